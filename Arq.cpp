@@ -0,0 +1,331 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Arq.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  SendWindow::SendWindow(size_t window, BYTE firstSeq, size_t maxPayload, PayloadSource source);
+--                  size_t SendWindow::burst(std::vector<ARQ_FRAME*> &frames);
+--                  size_t SendWindow::onSack(const SACK &sack);
+--                  BOOL SendWindow::done() const;
+--                  BOOL SendWindow::ready();
+--                  BOOL SendWindow::more() const;
+--                  BYTE SendWindow::nextSeq() const;
+--                  size_t SendWindow::outstanding() const;
+--                  size_t SendWindow::sent() const;
+--                  size_t SendWindow::resent() const;
+--                  VOID SendWindow::setLatency(LatencyHistogram *histogram);
+--                  VOID SendWindow::setMaxPayload(size_t size);
+--                  size_t SendWindow::payloadSize() const;
+--                  size_t SendWindow::fullest() const;
+--                  VOID SendWindow::setAckHook(AckHook hook);
+--                  ReceiveWindow::ReceiveWindow();
+--                  VOID ReceiveWindow::reset(BYTE expected, size_t window);
+--                  int ReceiveWindow::classify(BYTE seq) const;
+--                  int ReceiveWindow::accept(BYTE seq, std::string &payload);
+--                  BOOL ReceiveWindow::pop(std::string &out);
+--                  SACK ReceiveWindow::sack() const;
+--                  BOOL ReceiveWindow::complete() const;
+--                  size_t ReceiveWindow::duplicates() const;
+--                  VOID encodeSack(const SACK &sack, BOOL nak, char *out);
+--                  BOOL decodeSack(const char *in, DWORD len, SACK *sack);
+--                  BOOL sackCovers(const SACK &sack, BYTE seq);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Selective-repeat ARQ. The sender keeps up to `window` frames outstanding and puts every
+-- unacknowledged one on the line in a single burst after winning the line. The receiver buffers
+-- out-of-order frames, delivers them in sequence, and answers the burst with one SACK. The SACK
+-- carries its own CRC-16; the sender takes one that fails it for a lost one and sends the burst again.
+--
+-- The receiver tells duplicates apart by sequence number alone. A bitmap relative to the next
+-- expected frame marks the ones held, so a frame already in the window is one bit test, and the
+-- SACK mask is the same bitmap shifted by one. Frames up to ARQ_MAX_WINDOW behind the window were
+-- delivered already; they only come again when a SACK got lost, and are answered but not kept.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Arq.h"
+#include "Common.h"
+#include "Crc.h"
+using namespace std;
+
+SendWindow::SendWindow(size_t window, BYTE firstSeq, size_t maxPayload, PayloadSource source)
+    : window(max<size_t>(1, min<size_t>(window, ARQ_MAX_WINDOW))),
+      maxPayload(maxPayload),
+      source(source),
+      baseSeq(firstSeq),
+      exhausted(FALSE),
+      filled(0),
+      firstSends(0),
+      resends(0),
+      ackLatency(NULL)
+{
+}
+
+VOID SendWindow::refill()
+{
+    while (!exhausted && pending.size() < window)
+    {
+        ARQ_FRAME frame;
+        if (!source(frame.payload, maxPayload))
+        {
+            exhausted = TRUE;
+            break;
+        }
+        // nothing yet, the source is asked again next burst
+        if (frame.payload.empty())
+            break;
+        filled = max<size_t>(filled, frame.payload.size());
+        frame.seq = (BYTE)(baseSeq + pending.size());
+        frame.acked = FALSE;
+        frame.tries = 0;
+        frame.sentAt = 0;
+        pending.push_back(std::move(frame));
+    }
+}
+
+size_t SendWindow::burst(vector<ARQ_FRAME*> &frames)
+{
+    frames.clear();
+    refill();
+
+    for (auto &frame : pending)
+    {
+        if (!frame.acked)
+        {
+            if (++frame.tries == 1)
+            {
+                frame.sentAt = GetTickCount();
+                firstSends++;
+            }
+            else
+                resends++;
+            frames.push_back(&frame);
+        }
+    }
+
+    return frames.size();
+}
+
+size_t SendWindow::onSack(const SACK &sack)
+{
+    size_t acked = 0;
+    size_t cumulative = (BYTE)(sack.base - baseSeq);
+    DWORD now = GetTickCount();
+
+    // a base outside the window can only be a stale or garbled SACK
+    if (cumulative > pending.size())
+        return 0;
+
+    for (size_t i = 0; i < cumulative; i++)
+    {
+        if (!pending.front().acked)
+        {
+            acknowledge(pending.front(), now);
+            acked++;
+        }
+        pending.pop_front();
+    }
+    baseSeq = sack.base;
+
+    // pending[0] is the receiver's gap, bit i covers pending[i + 1]
+    for (size_t i = 1; i < pending.size() && i <= 32; i++)
+    {
+        if ((sack.mask >> (i - 1)) & 1 && !pending[i].acked)
+        {
+            acknowledge(pending[i], now);
+            acked++;
+        }
+    }
+
+    return acked;
+}
+
+VOID SendWindow::acknowledge(ARQ_FRAME &frame, DWORD now)
+{
+    frame.acked = TRUE;
+    if (ackLatency)
+        ackLatency->record(now - frame.sentAt);
+    if (ackHook)
+        ackHook(frame.payload);
+}
+
+BOOL SendWindow::done() const
+{
+    return exhausted && pending.empty();
+}
+
+BOOL SendWindow::ready()
+{
+    refill();
+    for (const auto &frame : pending)
+        if (!frame.acked)
+            return TRUE;
+    return FALSE;
+}
+
+BOOL SendWindow::more() const
+{
+    return !exhausted;
+}
+
+BYTE SendWindow::nextSeq() const
+{
+    return (BYTE)(baseSeq + pending.size());
+}
+
+size_t SendWindow::outstanding() const
+{
+    return pending.size();
+}
+
+size_t SendWindow::sent() const
+{
+    return firstSends;
+}
+
+size_t SendWindow::resent() const
+{
+    return resends;
+}
+
+VOID SendWindow::setLatency(LatencyHistogram *histogram)
+{
+    ackLatency = histogram;
+}
+
+VOID SendWindow::setMaxPayload(size_t size)
+{
+    maxPayload = size;
+    filled = 0;
+}
+
+size_t SendWindow::payloadSize() const
+{
+    return maxPayload;
+}
+
+size_t SendWindow::fullest() const
+{
+    return filled;
+}
+
+VOID SendWindow::setAckHook(AckHook hook)
+{
+    ackHook = hook;
+}
+
+ReceiveWindow::ReceiveWindow()
+{
+    reset(0, 1);
+}
+
+VOID ReceiveWindow::reset(BYTE expected, size_t window)
+{
+    this->expected = expected;
+    this->window = max<size_t>(1, min<size_t>(window, ARQ_MAX_WINDOW));
+    held = 0;
+    repeats = 0;
+    for (size_t i = 0; i < ARQ_MAX_WINDOW; i++)
+        slots[i].clear();
+}
+
+int ReceiveWindow::classify(BYTE seq) const
+{
+    size_t offset = (BYTE)(seq - expected);
+
+    if (offset >= window)
+    {
+        // frames just behind the window were delivered already and are being resent
+        // because our SACK was lost
+        return offset >= ARQ_SEQ_SPACE - ARQ_MAX_WINDOW ? ARQ_DUPLICATE : ARQ_OUT_OF_WINDOW;
+    }
+
+    return (held >> offset) & 1 ? ARQ_DUPLICATE : ARQ_ACCEPTED;
+}
+
+int ReceiveWindow::accept(BYTE seq, string &payload)
+{
+    int result = classify(seq);
+    if (result == ARQ_DUPLICATE)
+        repeats++;
+    if (result != ARQ_ACCEPTED)
+        return result;
+
+    held |= 1UL << (BYTE)(seq - expected);
+    slots[seq & (ARQ_MAX_WINDOW - 1)].swap(payload);
+    return ARQ_ACCEPTED;
+}
+
+BOOL ReceiveWindow::pop(string &out)
+{
+    if (!(held & 1))
+        return FALSE;
+
+    size_t slot = expected & (ARQ_MAX_WINDOW - 1);
+    out.swap(slots[slot]);
+    slots[slot].clear();
+    held >>= 1;
+    expected++;
+    return TRUE;
+}
+
+SACK ReceiveWindow::sack() const
+{
+    SACK s = { expected, held >> 1 };
+    return s;
+}
+
+BOOL ReceiveWindow::complete() const
+{
+    return (held >> 1) == 0;
+}
+
+size_t ReceiveWindow::duplicates() const
+{
+    return repeats;
+}
+
+VOID encodeSack(const SACK &sack, BOOL nak, char *out)
+{
+    out[0] = nak ? NAK : ACK;
+    out[1] = (char) sack.base;
+    for (int i = 0; i < 4; i++)
+        out[2 + i] = (char)((sack.mask >> (8 * i)) & 0xFF);
+
+    // high byte first, as in a frame
+    uint16_t crc = crc16((const uint8_t *) out, SACK_SIZE - 2);
+    out[SACK_SIZE - 2] = (char) (crc >> 8);
+    out[SACK_SIZE - 1] = (char) (crc & 0xFF);
+}
+
+BOOL decodeSack(const char *in, DWORD len, SACK *sack)
+{
+    if (len < SACK_SIZE || (in[0] != ACK && in[0] != NAK))
+        return FALSE;
+
+    // one flipped bit in the mask or the base would ack frames the receiver never got
+    uint16_t crc = crc16((const uint8_t *) in, SACK_SIZE - 2);
+    if ((BYTE) in[SACK_SIZE - 2] != (BYTE) (crc >> 8) || (BYTE) in[SACK_SIZE - 1] != (BYTE) (crc & 0xFF))
+        return FALSE;
+
+    sack->base = (BYTE) in[1];
+    sack->mask = 0;
+    for (int i = 0; i < 4; i++)
+        sack->mask |= (DWORD)(BYTE) in[2 + i] << (8 * i);
+    return TRUE;
+}
+
+BOOL sackCovers(const SACK &sack, BYTE seq)
+{
+    BYTE ahead = (BYTE)(seq - sack.base);
+
+    // behind the base in the lower half of the sequence space, the cumulative part has it
+    if (ahead >= ARQ_SEQ_SPACE / 2)
+        return TRUE;
+    return ahead > 0 && ahead <= 32 && ((sack.mask >> (ahead - 1)) & 1);
+}
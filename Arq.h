@@ -0,0 +1,137 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Arq.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declarations for the selective-repeat
+-- sliding window used by the sender (SendWindow) and the receiver (ReceiveWindow).
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef ARQ_H
+#define ARQ_H
+#include "Platform.h"
+#include "Histogram.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+
+// Sequence numbers are one byte; the window must stay below half of the sequence space
+#define ARQ_SEQ_SPACE       256
+#define ARQ_MAX_WINDOW      32
+// Window advertised by this station when the link is set up
+#define ARQ_WINDOW          8
+// Line bids nobody answered in a row before a transfer is abandoned
+#define ARQ_MAX_RETRIES     5
+// Bursts in a row the peer answered without acknowledging any of before a transfer is abandoned; a
+// frame cut before its link got worse keeps its size, and a 1024-byte one at a bit error rate of 3e-4
+// gets through about once in 12 tries
+#define ARQ_MAX_BURSTS      64
+
+// ACK/NAK + base + 32-bit selective mask + CRC-16 of the six bytes before it
+#define SACK_SIZE           8
+
+// Pulls the next payload (at most maxSize bytes) to be framed; returns FALSE when exhausted, or TRUE with
+// an empty payload when there is nothing to frame yet but more to come
+typedef std::function<BOOL(std::string &payload, size_t maxSize)> PayloadSource;
+// Told about every payload once the receiver has it
+typedef std::function<VOID(const std::string &payload)> AckHook;
+
+// Selective acknowledgement: base is the next in-order sequence the receiver expects,
+// bit i of mask is set when frame (base + 1 + i) has already been received.
+struct SACK {
+    BYTE    base;
+    DWORD   mask;
+};
+
+// A frame held by the sender until it is acknowledged
+struct ARQ_FRAME {
+    BYTE        seq;
+    BOOL        acked;
+    DWORD       tries;
+    DWORD       sentAt;     // tick of the first transmission
+    std::string payload;
+};
+
+class SendWindow {
+public:
+    SendWindow(size_t window, BYTE firstSeq, size_t maxPayload, PayloadSource source);
+
+    // collects every unacknowledged frame of the window, refilling it from the source first
+    size_t  burst(std::vector<ARQ_FRAME*> &frames);
+    // applies a selective acknowledgement, returns the number of newly acknowledged frames
+    size_t  onSack(const SACK &sack);
+    BOOL    done() const;
+    // refills the window, TRUE when a frame of it is still unacknowledged
+    BOOL    ready();
+    // the source may have payloads left to frame
+    BOOL    more() const;
+    BYTE    nextSeq() const;
+    size_t  outstanding() const;
+    // frames sent for the first time, and sent again
+    size_t  sent() const;
+    size_t  resent() const;
+    // where the ms from the first transmission of each acknowledged frame to its acknowledgement go
+    VOID    setLatency(LatencyHistogram *histogram);
+    // payload size of the frames cut from now on; frames already in the window keep theirs
+    VOID    setMaxPayload(size_t size);
+    size_t  payloadSize() const;
+    // most bytes the source put in one frame since the payload size last changed
+    size_t  fullest() const;
+    VOID    setAckHook(AckHook hook);
+
+private:
+    VOID    refill();
+    VOID    acknowledge(ARQ_FRAME &frame, DWORD now);
+
+    size_t                  window;
+    size_t                  maxPayload;
+    PayloadSource           source;
+    AckHook                 ackHook;
+    std::deque<ARQ_FRAME>   pending;
+    BYTE                    baseSeq;
+    BOOL                    exhausted;
+    size_t                  filled;
+    size_t                  firstSends;
+    size_t                  resends;
+    LatencyHistogram        *ackLatency;
+};
+
+// result of ReceiveWindow::accept()
+#define ARQ_ACCEPTED        0
+#define ARQ_DUPLICATE       1
+#define ARQ_OUT_OF_WINDOW   2
+
+class ReceiveWindow {
+public:
+    ReceiveWindow();
+
+    VOID    reset(BYTE expected, size_t window);
+    // what accept() would make of the frame, without taking its payload
+    int     classify(BYTE seq) const;
+    int     accept(BYTE seq, std::string &payload);
+    // moves the next in-order payload into out, returns FALSE when there is a gap
+    BOOL    pop(std::string &out);
+    SACK    sack() const;
+    BOOL    complete() const;
+    // frames turned away because they were held or delivered already
+    size_t  duplicates() const;
+
+private:
+    BYTE        expected;
+    size_t      window;
+    // bit i is set while frame (expected + i) is held
+    DWORD       held;
+    size_t      repeats;
+    std::string slots[ARQ_MAX_WINDOW];
+};
+
+// function prototypes
+VOID encodeSack(const SACK &sack, BOOL nak, char *out);
+BOOL decodeSack(const char *in, DWORD len, SACK *sack);
+BOOL sackCovers(const SACK &sack, BYTE seq);
+#endif
@@ -0,0 +1,1175 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Bench.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  uint64_t benchCycles();
+--                  double benchSeconds();
+--                  std::string benchCRC16();
+--                  std::string benchFec();
+--                  std::string benchFrameDecode();
+--                  std::string benchFrameSize();
+--                  std::string benchCompression(const std::vector<std::string> &paths);
+--                  std::string benchFileSource(size_t bytes);
+--                  std::string benchFileSink(size_t bytes);
+--                  std::string benchTransports(size_t bytes);
+--                  std::string benchLinkPool(size_t bytes);
+--                  std::string benchBidding(size_t bytes);
+--                  std::string benchBurst(size_t bytes);
+--                  std::string benchRecovery(size_t bytes);
+--                  std::string benchFrameQueue(size_t bytes);
+--                  std::string benchStats();
+--                  std::string benchHistogram();
+--                  std::string benchTrace();
+--                  std::string runBenchmarks();
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Micro benchmarks for the protocol hot paths. Cycle counts come from the time stamp counter where
+-- there is one, so bytes/cycle is only comparable between runs on the same machine.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Bench.h"
+#include "Common.h"
+#include "LinkSession.h"
+#include "LinkPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <ctime>
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+using namespace std;
+
+uint64_t benchCycles()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    // no cycle counter, fall back to nanoseconds
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double benchSeconds()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+string benchCRC16()
+{
+    // one frame and one large block
+    const size_t sizes[] = { 1029, 1 << 20 };
+    const size_t total = 64 << 20;
+    string report = "bench,path,bytes,bytes_per_cycle,mb_per_s,crc\n";
+    char line[160];
+
+    for (size_t size : sizes)
+    {
+        vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = (uint8_t)(i * 131 + 7);
+
+        for (int path = 0; path < CRC16_PATHS; path++)
+        {
+            if (!crc16PathSupported(path))
+                continue;
+
+            // the bitwise reference is slow, give it less work
+            size_t rounds = max<size_t>(1, (path == CRC16_BITWISE ? total / 16 : total) / size);
+            volatile uint16_t crc = 0;
+
+            double start = benchSeconds();
+            uint64_t cycles = benchCycles();
+            for (size_t r = 0; r < rounds; r++)
+                crc = crc16UpdatePath(path, CRC16_INIT, data.data(), size);
+            cycles = benchCycles() - cycles;
+            double seconds = benchSeconds() - start;
+
+            double bytes = (double) rounds * size;
+            snprintf(line, sizeof(line), "crc16,%s,%zu,%.3f,%.1f,%04x\n", crc16PathName(path), size,
+                bytes / (double) max<uint64_t>(1, cycles), bytes / seconds / 1e6, (unsigned) crc);
+            report += line;
+        }
+    }
+
+    return report;
+}
+
+string benchFec()
+{
+    // a full 4 KB frame with 32 check symbols per codeword, spread over the codewords it needs
+    const size_t len = PACKET_DATA_MAX + PACKET_OVERHEAD - PACKET_SEQ_INDEX;
+    const int parity = 32;
+    const size_t depth = fecDepth(len, parity, 1);
+    const size_t total = 32 << 20;
+    string report = "bench,path,bytes,bytes_per_cycle,mb_per_s,check\n";
+    char line[160];
+
+    // the kernel alone, over rows as wide as the frame's codewords, padded the way the codec pads them
+    const size_t width = (depth + 15) & ~(size_t) 15;
+    vector<uint8_t> row(width), acc(width);
+    for (size_t i = 0; i < width; i++)
+        row[i] = (uint8_t)(i * 131 + 7);
+
+    for (int path = 0; path < GF_PATHS; path++)
+    {
+        if (!gfPathSupported(path))
+            continue;
+
+        size_t rounds = total / width;
+        fill(acc.begin(), acc.end(), 0);
+        double start = benchSeconds();
+        uint64_t cycles = benchCycles();
+        for (size_t r = 0; r < rounds; r++)
+            gfMulAddPath(path, acc.data(), acc.data(), row.data(), (uint8_t)(r | 1), width);
+        cycles = benchCycles() - cycles;
+        double seconds = benchSeconds() - start;
+
+        double bytes = (double) rounds * width;
+        snprintf(line, sizeof(line), "gf_muladd,%s,%zu,%.3f,%.1f,%02x\n", gfPathName(path), width,
+            bytes / (double) max<uint64_t>(1, cycles), bytes / seconds / 1e6, (unsigned) acc[0]);
+        report += line;
+    }
+
+    // whole frames with the selected kernel: encode, and decode with every codeword at its limit
+    vector<uint8_t> data(len), check(depth * parity), work(len), workCheck(check.size());
+    for (size_t i = 0; i < len; i++)
+        data[i] = (uint8_t)(i * 131 + 7);
+    size_t frames = 2000;
+
+    double start = benchSeconds();
+    for (size_t f = 0; f < frames; f++)
+        fecEncode(data.data(), len, parity, 1, check.data());
+    double seconds = benchSeconds() - start;
+    snprintf(line, sizeof(line), "fec_encode,%s,%zu,,%.1f,%zu\n", gfPathName(gfSelectedPath()), len,
+        frames * (double) len / seconds / 1e6, check.size());
+    report += line;
+
+    int fixed = 0;
+    start = benchSeconds();
+    for (size_t f = 0; f < frames; f++)
+    {
+        work = data;
+        workCheck = check;
+        for (size_t k = 0; k < depth; k++)
+            for (int e = 0; e < parity / 2; e++)
+                work[(e * 5 + f % 5) * depth + k] ^= 0x5A;
+        fixed = fecDecode(work.data(), len, workCheck.data(), parity, 1);
+    }
+    seconds = benchSeconds() - start;
+    snprintf(line, sizeof(line), "fec_decode,%s,%zu,,%.1f,%d\n", gfPathName(gfSelectedPath()), len,
+        frames * (double) len / seconds / 1e6, fixed);
+    report += line;
+
+    return report;
+}
+
+// The fixed size frames used before, SYN | SEQ | FLAGS | DATA (NUL0 padded) | CRC16
+#define LEGACY_SIZE         1029
+#define LEGACY_DATA_INDEX   3
+
+static string legacyFrame(BYTE seq, const string &payload)
+{
+    string frame;
+    frame += (char) SYN;
+    frame += (char) seq;
+    frame += (char) 0;
+    frame += payload.substr(0, PACKET_DATA_SIZE);
+    frame.append(LEGACY_SIZE - 2 - frame.length(), (char) NUL0);
+    frame += CRCtoString(crc16((const uint8_t*) frame.data() + 1, frame.length() - 1));
+    return frame;
+}
+
+// The receive path as it was: rebuild the payload byte by byte, check the CRC on string copies
+// with the bitwise kernel, strip invalid characters and keep a copy.
+static BOOL legacyValidate(const char *packet, vector<string> &delivered)
+{
+    string message;
+    string crcs;
+
+    for (size_t i = LEGACY_DATA_INDEX; i < LEGACY_SIZE - 2; i++)
+    {
+        if (packet[i] != NUL0)
+            message += packet[i];
+    }
+    crcs.push_back(packet[LEGACY_SIZE - 2]);
+    crcs.push_back(packet[LEGACY_SIZE - 1]);
+
+    string covered(packet + PACKET_SEQ_INDEX, LEGACY_SIZE - 3);
+    uint16_t crc = crc16Bitwise(CRC16_INIT, (const uint8_t*) covered.data(), covered.length());
+    if (CRCtoString(crc) != crcs)
+        return FALSE;
+
+    message.erase(remove_if(message.begin(), message.end(), INVALID_CHAR()), message.end());
+    delivered.push_back(message);
+    return TRUE;
+}
+
+string benchFrameDecode()
+{
+    const size_t frames = 20000;
+    const size_t chunk = 4096;
+    string report = "bench,variant,frames,frames_per_s,mb_per_s,ok\n";
+    char line[160];
+
+    // a stream of full text frames, as they arrive from the line
+    string stream, legacy;
+    for (size_t i = 0; i < 64; i++)
+    {
+        string payload(PACKET_DATA_SIZE, ' ');
+        for (size_t j = 0; j < payload.length(); j++)
+            payload[j] = (char)('a' + (i * 7 + j) % 26);
+        stream += buildFrame((BYTE) i, 0, payload);
+        legacy += legacyFrame((BYTE) i, payload);
+    }
+
+    // before: one fixed size read per frame, validated with string copies
+    {
+        vector<string> delivered;
+        size_t ok = 0;
+        double start = benchSeconds();
+        for (size_t i = 0; i < frames; i++)
+        {
+            const char *packet = legacy.data() + (i % 64) * LEGACY_SIZE;
+            ok += legacyValidate(packet, delivered);
+            if (delivered.size() >= 64)
+                delivered.clear();
+        }
+        double seconds = benchSeconds() - start;
+        snprintf(line, sizeof(line), "decode,legacy,%zu,%.0f,%.1f,%s\n", ok, frames / seconds,
+            frames * (double) LEGACY_SIZE / seconds / 1e6, ok == frames ? "yes" : "no");
+        report += line;
+    }
+
+    // after: bulk chunks into the ring, frames checked in place, optionally materialized; the ring
+    // gets exactly as many frames as the legacy path, and has to give back every one of them
+    size_t total = frames * (stream.length() / 64);
+    for (int materialize = 0; materialize < 2; materialize++)
+    {
+        RingBuffer ring(RX_RING_SIZE);
+        FrameDecoder decoder(ring);
+        string payload;
+        size_t ok = 0, bad = 0, offset = 0, fed = 0;
+        double start = benchSeconds();
+        while (fed < total)
+        {
+            size_t room;
+            uint8_t *dst = ring.writePtr(&room);
+            size_t n = min<size_t>(min<size_t>(room, chunk), min<size_t>(stream.length() - offset, total - fed));
+            memcpy(dst, stream.data() + offset, n);
+            ring.commit(n);
+            offset = (offset + n) % stream.length();
+            fed += n;
+
+            FRAME_VIEW frame;
+            int result;
+            while ((result = decoder.next(&frame)) != DECODE_NEED_MORE)
+            {
+                if (result == DECODE_FRAME)
+                {
+                    if (materialize)
+                        framePayloadCopy(frame, payload);
+                    ok++;
+                }
+                else
+                    bad++;
+                decoder.release(frame);
+            }
+        }
+        double seconds = benchSeconds() - start;
+        snprintf(line, sizeof(line), "decode,%s,%zu,%.0f,%.1f,%s\n", materialize ? "ring+copy" : "ring", ok,
+            ok / seconds, ok * (double) PACKET_SIZE / seconds / 1e6,
+            ok == frames && bad == 0 && decoder.bytesSkipped == 0 && ring.size() == 0 ? "yes" : "no");
+        report += line;
+    }
+
+    return report;
+}
+
+string benchFrameSize()
+{
+    // a chat line, a short paragraph, and a full payload
+    const size_t sizes[] = { 16, 80, 256, PACKET_DATA_SIZE };
+    const double baud = 9600;
+    string report = "bench,payload,fixed_bytes,var_bytes,fixed_ms,var_ms\n";
+    char line[160];
+
+    for (size_t size : sizes)
+    {
+        // 10 bits per byte on the line: start, 8 data, stop
+        size_t fixed = LEGACY_SIZE;
+        size_t var = buildFrame(0, 0, string(size, 'x')).length();
+        snprintf(line, sizeof(line), "framing,%zu,%zu,%zu,%.1f,%.1f\n", size, fixed, var,
+            fixed * 10 * 1000 / baud, var * 10 * 1000 / baud);
+        report += line;
+    }
+
+    return report;
+}
+
+// A chat session, for when no text files are around
+static string chatSample()
+{
+    const char *lines[] = {
+        "Hello, are you receiving this on the second station?\r\n",
+        "Yes, the message came through. The line is a bit noisy this afternoon.\r\n",
+        "OK. I will send the file with the log of the test now, please confirm when it is in.\r\n",
+        "Thanks. Received 12 packets, 1 was corrupted and sent again.\r\n",
+        "That is better than yesterday. We should try the longer antenna next time.\r\n",
+    };
+    string text;
+    for (int i = 0; i < 200; i++)
+    {
+        text += lines[i % 5];
+        text += "[" + to_string(1000 + i * 37) + "] ";
+    }
+    return text;
+}
+
+string benchCompression(const vector<string> &paths)
+{
+    const double baud = 9600;
+    const BYTE modes[] = { COMPRESS_NONE, COMPRESS_LZ, COMPRESS_LZ_DICT };
+    const char *modeNames[] = { "none", "lz", "lz+dict" };
+    string report = "bench,file,mode,raw_bytes,line_bytes,ratio,goodput_bps,line_bps,compress_mb_s,decompress_mb_s,ok\n";
+    char line[256];
+
+    vector<pair<string, string>> samples;
+    samples.push_back(make_pair(string("chat"), chatSample()));
+    for (const string &path : paths)
+    {
+        ifstream in(path, ios::binary);
+        if (in)
+            samples.push_back(make_pair(path, string(istreambuf_iterator<char>(in), istreambuf_iterator<char>())));
+    }
+
+    for (const auto &sample : samples)
+    {
+        const string &text = sample.second;
+        for (int m = 0; m < 3; m++)
+        {
+            vector<string> payloads;
+            double start = benchSeconds();
+            if (modes[m] == COMPRESS_NONE)
+            {
+                for (size_t i = 0; i < text.length(); i += PACKET_DATA_SIZE)
+                    payloads.push_back(text.substr(i, PACKET_DATA_SIZE));
+            }
+            else
+            {
+                payloads = compressStage(text, PACKET_DATA_SIZE, modes[m]);
+            }
+            double compressSeconds = benchSeconds() - start;
+
+            // what goes on the line, and whether it comes back the same
+            size_t lineBytes = 0;
+            string back, raw;
+            start = benchSeconds();
+            for (const string &payload : payloads)
+            {
+                lineBytes += PACKET_OVERHEAD + payload.length();
+                if (modes[m] == COMPRESS_NONE)
+                    back += payload;
+                else if (decompressBlock(payload, raw))
+                    back += raw;
+            }
+            double decompressSeconds = benchSeconds() - start;
+
+            // 10 bits per byte on the line
+            double lineRate = baud / 10;
+            double seconds = lineBytes / lineRate;
+            snprintf(line, sizeof(line), "compress,%s,%s,%zu,%zu,%.2f,%.0f,%.0f,%.1f,%.1f,%d\n",
+                sample.first.c_str(), modeNames[m], text.length(), lineBytes,
+                text.length() / (double) max<size_t>(1, lineBytes), text.length() / seconds, lineRate,
+                text.length() / max(compressSeconds, 1e-9) / 1e6,
+                text.length() / max(decompressSeconds, 1e-9) / 1e6, back == text);
+            report += line;
+        }
+    }
+
+    return report;
+}
+
+// the packetizer before the send queue: the whole text split at the agreed maximum, or compressed,
+// before the first payload goes out
+static vector<string> splitText(const string &text)
+{
+    vector<string> packets;
+    size_t maxPayload = session->linkParams.maxPayload;
+
+    if (session->linkParams.compress != COMPRESS_NONE)
+        return compressStage(text, maxPayload, session->linkParams.compress);
+
+    for (size_t i = 0; i < text.length(); i += maxPayload)
+        packets.push_back(text.substr(i, maxPayload));
+
+    return packets;
+}
+
+string benchFileSource(size_t bytes)
+{
+    const char *path = "rmbench.tmp";
+    string report = "bench,source,file_bytes,first_frame_ms,total_ms,resident_bytes\n";
+    char line[160];
+
+    // a text file of the requested size
+    {
+        ofstream out(path, ios::binary);
+        string text = "The quick brown fox jumps over the lazy dog, line ";
+        for (size_t written = 0, n = 0; written < bytes; n++)
+        {
+            string l = text + to_string(n) + "\r\n";
+            out << l;
+            written += l.length();
+        }
+    }
+
+    // before: the whole file read line by line into one string, then split
+    {
+        double start = benchSeconds();
+        ifstream in(path);
+        string tmp, text;
+        while (getline(in, tmp))
+            text += tmp + "\n";
+        vector<string> packets = splitText(text);
+        double first = benchSeconds() - start;
+        snprintf(line, sizeof(line), "file,lines,%zu,%.1f,%.1f,%zu\n", bytes, first * 1e3, first * 1e3,
+            text.capacity() + packets.size() * PACKET_DATA_SIZE);
+        report += line;
+    }
+
+    // after: mapped a window at a time, payloads cut straight out of the mapping
+    for (BYTE mode : { COMPRESS_NONE, COMPRESS_LZ_DICT })
+    {
+        FileSource source;
+        string payload;
+        double start = benchSeconds();
+        source.open(path);
+        source.next(payload, PACKET_DATA_SIZE, mode);
+        double first = benchSeconds() - start;
+        while (source.next(payload, PACKET_DATA_SIZE, mode))
+            ;
+        double total = benchSeconds() - start;
+        snprintf(line, sizeof(line), "file,%s,%zu,%.3f,%.1f,%d\n", mode == COMPRESS_NONE ? "mapped" : "mapped+lz",
+            bytes, first * 1e3, total * 1e3, FILE_VIEW_SIZE);
+        report += line;
+    }
+
+    remove(path);
+    return report;
+}
+
+string benchFileSink(size_t bytes)
+{
+    const char *path = "rmbench.tmp";
+    string report = "bench,sink,bytes,deliver_ms,save_ms,held_bytes,stalls\n";
+    char line[160];
+    string payload(PACKET_DATA_SIZE, ' ');
+    for (size_t i = 0; i < payload.size(); i++)
+        payload[i] = "The quick brown fox jumps over the lazy dog\n"[i % 44];
+
+    // before: every payload kept in memory, written a line at a time when saved
+    {
+        vector<string> packets;
+        double start = benchSeconds();
+        for (size_t n = 0; n < bytes; n += payload.size())
+            packets.push_back(payload);
+        double delivered = benchSeconds() - start;
+        size_t held = packets.size() * (sizeof(string) + payload.capacity());
+
+        start = benchSeconds();
+        ofstream out(path);
+        for (const string &packet : packets)
+        {
+            istringstream lines(packet);
+            string l;
+            while (getline(lines, l))
+                out << l << endl;
+        }
+        out.close();
+        snprintf(line, sizeof(line), "sink,vector,%zu,%.1f,%.1f,%zu,0\n", bytes, delivered * 1e3,
+            (benchSeconds() - start) * 1e3, held);
+        report += line;
+    }
+
+    // after: streamed into the file by the sink's thread, a burst of 8 frames between syncs
+    {
+        FileSink sink;
+        sink.open(path);
+        double start = benchSeconds();
+        for (size_t n = 0, frames = 0; n < bytes; n += payload.size())
+        {
+            sink.write(payload);
+            if (++frames % ARQ_WINDOW == 0)
+                sink.sync();
+        }
+        double delivered = benchSeconds() - start;
+        start = benchSeconds();
+        sink.close();
+        snprintf(line, sizeof(line), "sink,file,%zu,%.1f,%.1f,%d,%zu\n", bytes, delivered * 1e3,
+            (benchSeconds() - start) * 1e3, SINK_BLOCKS * SINK_BLOCK + SINK_TAIL, sink.stalls());
+        report += line;
+    }
+
+    remove(path);
+    return report;
+}
+
+#ifndef _WIN32
+// CPU time of the whole process, both ends of the loopback included
+static double cpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// pushes bytes through from one end to the other the way the engine reads: wait for input, then
+// take what is there
+static string loopback(const char *backend, Transport *from, Transport *to, size_t bytes)
+{
+    char line[160];
+    vector<uint8_t> frame(PACKET_SIZE, 0x55), buffer(RX_RING_SIZE);
+    size_t received = 0;
+    size_t reads = session->readMetrics.readCalls;
+    double start = benchSeconds();
+    double cpu = cpuSeconds();
+
+    thread writer([&] {
+        for (size_t sent = 0; sent < bytes; sent += frame.size())
+            from->write(frame.data(), (DWORD) min<size_t>(frame.size(), bytes - sent));
+    });
+    while (received < bytes && to->waitForInput())
+    {
+        DWORD n;
+        while ((n = to->read(buffer.data(), (DWORD) buffer.size(), 0)) > 0)
+            received += n;
+    }
+    writer.join();
+
+    double seconds = benchSeconds() - start;
+    double mb = received / 1e6;
+    snprintf(line, sizeof(line), "transport,%s,%zu,%.1f,%.2f,%.1f\n", backend, received, mb / seconds,
+        (cpuSeconds() - cpu) * 1e3 / mb, (session->readMetrics.readCalls - reads) / mb);
+    return line;
+}
+
+// Two stations joined by a simulated line, the first one sends to the second
+struct BENCH_PAIR {
+    LinkSession     *links[2];
+    SimTransport    *lines[2];
+};
+
+// bytes that do not compress, every link takes its full time on the line
+static VOID writeNoise(const char *path, size_t bytes)
+{
+    ofstream out(path, ios::binary);
+    uint32_t x = 1;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        out.put((char) x);
+    }
+}
+
+// both stations connected and receiving into their sinks, their engines are started by the caller
+static BOOL openPair(BENCH_PAIR *pair, const SIM_PARAMS &params)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return FALSE;
+
+    for (BYTE station = 0; station < 2; station++)
+    {
+        pair->links[station] = new LinkSession();
+        pair->lines[station] = new SimTransport(sv[station], station, params);
+        pair->links[station]->transport = pair->lines[station];
+        pair->links[station]->connected = TRUE;
+        pair->links[station]->fileSink.open(NULL);
+    }
+    return TRUE;
+}
+
+// once the engines have stopped
+static VOID closePair(BENCH_PAIR *pair)
+{
+    for (int i = 0; i < 2; i++)
+        pair->lines[i]->close();
+    for (int i = 0; i < 2; i++)
+    {
+        delete pair->links[i];
+        delete pair->lines[i];
+    }
+}
+
+// the setup goes out again until the peer has answered, as the driver does
+static BOOL setUpLinks(const vector<LinkSession *> &links)
+{
+    DWORD start = GetTickCount(), asked = start - TIME_OUT_LONG;
+
+    for (;; Sleep(BENCH_LINK_POLL))
+    {
+        BOOL ask = GetTickCount() - asked >= TIME_OUT_LONG;
+        size_t ready = 0;
+        for (LinkSession *link : links)
+            if (link->linkReady)
+                ready++;
+            else if (ask)
+                postCommand(ENGINE_CMD_SETUP, NULL, NULL, link);
+        if (ready == links.size())
+            return TRUE;
+        if (ask)
+            asked = GetTickCount();
+        if (GetTickCount() - start >= BENCH_LINK_WAIT)
+            return FALSE;
+    }
+}
+
+// the engine opens the file, only it touches the file source of its link
+static BOOL loadFile(LinkSession *link, const char *path)
+{
+    HANDLE loaded = CreateEvent(NULL, FALSE, FALSE, NULL);
+    postCommand(ENGINE_CMD_LOAD, loaded, NULL, link, path);
+    BOOL ok = WaitForSingleObject(loaded, BENCH_LINK_WAIT) == WAIT_OBJECT_0 && link->fileSource.isOpen();
+    CloseHandle(loaded);
+    return ok;
+}
+#endif
+
+string benchTransports(size_t bytes)
+{
+    string report = "bench,backend,bytes,mb_per_s,cpu_ms_per_mb,reads_per_mb\n";
+
+#ifndef _WIN32
+    // the same pty pair read through the emulated Win32 calls, then straight through termios and epoll
+    int master, slave;
+    if (openPtyPair(&master, &slave))
+    {
+        TermiosTransport writer(master);
+        HANDLE port = CreateFile(ptsname(master), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+            FILE_FLAG_OVERLAPPED, NULL);
+        if (port != INVALID_HANDLE_VALUE)
+        {
+            COMMTIMEOUTS timeouts = { MAXDWORD, MAXDWORD, TIME_OUT_LONG, 0, 0 };
+            SetCommTimeouts(port, &timeouts);
+            CommTransport comm(port);
+            report += loopback("comm_pty", &writer, &comm, bytes);
+            CloseHandle(port);
+        }
+
+        TermiosTransport reader(slave);
+        report += loopback("termios_pty", &writer, &reader, bytes);
+    }
+
+    // the simulated link without a line rate, a socket pair and its delivery thread
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0)
+    {
+        SIM_PARAMS params = {};
+        SimTransport a(sv[0], 0, params), b(sv[1], 1, params);
+        report += loopback("sim", &a, &b, bytes);
+        a.close();
+        b.close();
+    }
+#endif
+
+    return report;
+}
+
+string benchLinkPool(size_t bytes)
+{
+    const char *path = "rmbench.tmp";
+    const size_t workers = 4;
+    string report = "bench,mode,links,engine_threads,bytes_per_link,elapsed_ms,cpu_ms_per_link,switches_per_link,ok\n";
+
+#ifndef _WIN32
+    char line[200];
+    writeNoise(path, bytes);
+
+    // pairs of stations on simulated lines, every even link sends a file to the odd one after it; an
+    // engine thread per link, then every engine on a pool of a few workers
+    for (size_t count : { 1, 4, 16, 48 })
+    {
+        for (int pooled = 0; pooled < 2; pooled++)
+        {
+            SIM_PARAMS params = {};
+            params.baud = 115200;
+            vector<BENCH_PAIR> pairs;
+            vector<LinkSession *> links, senders;
+            for (size_t i = 0; i < count; i++)
+            {
+                BENCH_PAIR pair;
+                if (!openPair(&pair, params))
+                    break;
+                pairs.push_back(pair);
+                links.push_back(pair.links[0]);
+                links.push_back(pair.links[1]);
+                senders.push_back(pair.links[0]);
+            }
+
+            LinkPool pool;
+            if (pooled)
+                pool.start(links, workers);
+            else
+                for (LinkSession *link : links)
+                    startEngine(link);
+
+            BOOL ok = setUpLinks(senders);
+            for (size_t i = 0; ok && i < senders.size(); i++)
+                ok = loadFile(senders[i], path);
+
+            vector<HANDLE> sent;
+            double begin = benchSeconds();
+            double cpu = cpuSeconds();
+            uint64_t switches = pool.switches();
+            for (size_t i = 0; ok && i < senders.size(); i++)
+            {
+                sent.push_back(CreateEvent(NULL, FALSE, FALSE, NULL));
+                postCommand(ENGINE_CMD_SEND, sent.back(), NULL, senders[i]);
+            }
+            for (HANDLE done : sent)
+            {
+                ok = ok && WaitForSingleObject(done, BENCH_LINK_WAIT) == WAIT_OBJECT_0;
+                CloseHandle(done);
+            }
+            double seconds = benchSeconds() - begin;
+            double cpuMs = (cpuSeconds() - cpu) * 1e3;
+            switches = pool.switches() - switches;
+
+            if (pooled)
+                pool.stop();
+            else
+                for (LinkSession *link : links)
+                    stopEngine(link);
+            for (BENCH_PAIR &pair : pairs)
+                ok = ok && pair.links[1]->fileSink.bytes() == bytes;
+
+            snprintf(line, sizeof(line), "link_pool,%s,%zu,%zu,%zu,%.1f,%.2f,%.1f,%s\n",
+                pooled ? "pool" : "threads", links.size(), pooled ? min<size_t>(workers, links.size()) : links.size(),
+                bytes, seconds * 1e3, cpuMs / links.size(), (double) switches / links.size(), ok ? "yes" : "no");
+            report += line;
+
+            for (BENCH_PAIR &pair : pairs)
+                closePair(&pair);
+        }
+    }
+
+    remove(path);
+#endif
+
+    return report;
+}
+
+string benchBidding(size_t bytes)
+{
+    const char *path = "rmbench.tmp";
+    string report = "bench,load,backoff,bytes_each,elapsed_ms,aggregate_bps,bids,bid_success,collisions,backoff_ms,"
+        "ok\n";
+
+#ifndef _WIN32
+    char line[200];
+    writeNoise(path, bytes);
+
+    // one station sending, then both at once, bidding against each other with the fixed wait after a
+    // failed bid and with the random backoff. Two stations with the fixed wait keep colliding, that row
+    // shows the livelock; it running out of time is expected, not a failure
+    const struct { BOOL both; BOOL random; BOOL livelock; } runs[] = {
+        { FALSE, TRUE, FALSE }, { TRUE, FALSE, TRUE }, { TRUE, TRUE, FALSE }
+    };
+    for (const auto &run : runs)
+    {
+        SIM_PARAMS params = {};
+        params.baud = 115200;
+        params.latency = 5;
+        params.turnaround = 2;
+        params.seed = 1;
+        BENCH_PAIR pair;
+        if (!openPair(&pair, params))
+            break;
+
+        LinkSession **links = pair.links;
+        for (int i = 0; i < 2; i++)
+        {
+            links[i]->randomBackoff = run.random;
+            startEngine(links[i]);
+        }
+
+        BOOL ok = setUpLinks({ links[0] });
+        int senders = run.both ? 2 : 1;
+        for (int i = 0; ok && i < senders; i++)
+            ok = loadFile(links[i], path);
+        BOOL started = ok;
+
+        // the setup took its bids, only the transfer counts
+        BID_METRICS before[2] = { links[0]->bidMetrics, links[1]->bidMetrics };
+        HANDLE sent[2] = { CreateEvent(NULL, FALSE, FALSE, NULL), CreateEvent(NULL, FALSE, FALSE, NULL) };
+        double begin = benchSeconds();
+        for (int i = 0; ok && i < senders; i++)
+            postCommand(ENGINE_CMD_SEND, sent[i], NULL, links[i]);
+        for (int i = 0; i < senders; i++)
+        {
+            DWORD left = BENCH_BID_WAIT - min<DWORD>((DWORD) ((benchSeconds() - begin) * 1e3), BENCH_BID_WAIT);
+            ok = ok && WaitForSingleObject(sent[i], left) == WAIT_OBJECT_0;
+        }
+        double seconds = benchSeconds() - begin;
+
+        for (int i = 0; i < 2; i++)
+        {
+            stopEngine(links[i]);
+            CloseHandle(sent[i]);
+        }
+        // what got across in the time, a run that ran out of it included
+        uint64_t received = 0;
+        for (int i = 0; i < senders; i++)
+        {
+            received += links[1 - i]->fileSink.bytes();
+            ok = ok && links[1 - i]->fileSink.bytes() == bytes && links[i]->stats.snapshot().packetLost == 0;
+        }
+
+        BID_METRICS bids = {};
+        for (int i = 0; i < 2; i++)
+        {
+            bids.bids += links[i]->bidMetrics.bids - before[i].bids;
+            bids.won += links[i]->bidMetrics.won - before[i].won;
+            bids.collided += links[i]->bidMetrics.collided - before[i].collided;
+            bids.backoffMs += links[i]->bidMetrics.backoffMs - before[i].backoffMs;
+        }
+        snprintf(line, sizeof(line), "bidding,%s,%s,%zu,%.1f,%.0f,%zu,%.3f,%zu,%llu,%s\n",
+            run.both ? "both" : "one", run.random ? "random" : "fixed", bytes, seconds * 1e3,
+            received / seconds, bids.bids, bids.bids ? (double) bids.won / bids.bids : 0.0, bids.collided,
+            (unsigned long long) bids.backoffMs, ok ? "yes" : run.livelock && started ? "expected" : "no");
+        report += line;
+
+        closePair(&pair);
+    }
+
+    remove(path);
+#endif
+
+    return report;
+}
+
+string benchBurst(size_t bytes)
+{
+    const char *path = "rmbench.tmp";
+    string report = "bench,burst,bytes,elapsed_ms,goodput_bps,bids,bursts_held,saved_ms_per_mb,"
+        "measured_saved_ms_per_mb,ok\n";
+
+#ifndef _WIN32
+    char line[200];
+    writeNoise(path, bytes);
+
+    // one station sending, giving up the line after every window, then holding it for bursts
+    const BYTE bursts[] = { 0, BURST_FRAMES };
+    double unheld = 0;
+    for (BYTE burst : bursts)
+    {
+        SIM_PARAMS params = {};
+        params.baud = 115200;
+        params.latency = 5;
+        params.turnaround = 2;
+        params.seed = 1;
+        BENCH_PAIR pair;
+        if (!openPair(&pair, params))
+            break;
+
+        LinkSession **links = pair.links;
+        for (int i = 0; i < 2; i++)
+        {
+            links[i]->localParams.burst = burst;
+            startEngine(links[i]);
+        }
+
+        BOOL ok = setUpLinks({ links[0] }) && loadFile(links[0], path);
+
+        // the setup took its bids, only the transfer counts
+        size_t before = links[0]->bidMetrics.bids;
+        HANDLE sent = CreateEvent(NULL, FALSE, FALSE, NULL);
+        double begin = benchSeconds();
+        if (ok)
+            postCommand(ENGINE_CMD_SEND, sent, NULL, links[0]);
+        ok = ok && WaitForSingleObject(sent, BENCH_BID_WAIT) == WAIT_OBJECT_0;
+        double seconds = benchSeconds() - begin;
+
+        for (int i = 0; i < 2; i++)
+            stopEngine(links[i]);
+        CloseHandle(sent);
+        ok = ok && links[1]->fileSink.bytes() == bytes && links[0]->stats.snapshot().packetLost == 0;
+
+        // the turnaround the engine counted as saved, and how much sooner the run ended than the one
+        // without bursts, both per MB
+        double mb = (double) bytes / (1 << 20);
+        if (burst == 0)
+            unheld = seconds;
+        snprintf(line, sizeof(line), "burst,%u,%zu,%.1f,%.0f,%zu,%zu,%.0f,%.0f,%s\n", burst, bytes, seconds * 1e3,
+            links[1]->fileSink.bytes() / seconds, links[0]->bidMetrics.bids - before,
+            links[0]->sendMetrics.burstsHeld, links[0]->sendMetrics.turnaroundSavedMs / mb,
+            (unheld - seconds) * 1e3 / mb, ok ? "yes" : "no");
+        report += line;
+
+        closePair(&pair);
+    }
+
+    remove(path);
+#endif
+
+    return report;
+}
+
+string benchRecovery(size_t bytes)
+{
+    const char *path = "rmbench.tmp";
+    string report = "bench,down_ms,up_ms,bytes,first_lost,first_received,second_ms,second_received,ok\n";
+
+#ifndef _WIN32
+    char line[200];
+    writeNoise(path, bytes);
+
+    // the peer goes silent in the middle of a send, which is given up; once it is back, the next send
+    // has to get through whole
+    SIM_PARAMS params = {};
+    params.baud = 115200;
+    params.latency = 5;
+    params.turnaround = 2;
+    params.seed = 1;
+    params.down = BENCH_DOWN_MS;
+    params.up = BENCH_UP_MS;
+    BENCH_PAIR pair;
+    double opened = benchSeconds();
+    if (!openPair(&pair, params))
+        return report;
+
+    LinkSession **links = pair.links;
+    for (int i = 0; i < 2; i++)
+        startEngine(links[i]);
+    BOOL ok = setUpLinks({ links[0] }) && loadFile(links[0], path);
+
+    HANDLE sent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (ok)
+        postCommand(ENGINE_CMD_SEND, sent, NULL, links[0]);
+    ok = ok && WaitForSingleObject(sent, BENCH_LINK_WAIT) == WAIT_OBJECT_0;
+    int lost = links[0]->stats.snapshot().packetLost;
+    uint64_t first = links[1]->fileSink.bytes();
+
+    // the second send starts once the line is back
+    double back = opened + BENCH_UP_MS / 1e3 - benchSeconds();
+    if (back > 0)
+        Sleep((DWORD) (back * 1e3) + 1);
+    ok = ok && loadFile(links[0], path);
+    double begin = benchSeconds();
+    if (ok)
+        postCommand(ENGINE_CMD_SEND, sent, NULL, links[0]);
+    ok = ok && WaitForSingleObject(sent, BENCH_LINK_WAIT) == WAIT_OBJECT_0;
+    double seconds = benchSeconds() - begin;
+
+    for (int i = 0; i < 2; i++)
+        stopEngine(links[i]);
+    CloseHandle(sent);
+    uint64_t second = links[1]->fileSink.bytes() - first;
+    ok = ok && lost > 0 && first < bytes && second == bytes;
+
+    snprintf(line, sizeof(line), "recovery,%u,%u,%zu,%d,%llu,%.1f,%llu,%s\n", BENCH_DOWN_MS, BENCH_UP_MS, bytes, lost,
+        (unsigned long long) first, seconds * 1e3, (unsigned long long) second, ok ? "yes" : "no");
+    report += line;
+
+    closePair(&pair);
+    remove(path);
+#endif
+
+    return report;
+}
+
+string benchFrameQueue(size_t bytes)
+{
+    string report = "bench,path,mode,text_bytes,first_payload_ms,total_ms,full_stalls,empty_stalls,max_depth\n";
+    char line[200];
+    BYTE compress = session->linkParams.compress;
+
+    // the lines of the send panel
+    vector<string> lines;
+    size_t written = 0;
+    for (size_t n = 0; written < bytes; n++)
+    {
+        lines.push_back("The quick brown fox jumps over the lazy dog, line " + to_string(n) + "\n");
+        written += lines.back().length();
+    }
+
+    for (BYTE mode : { COMPRESS_NONE, COMPRESS_LZ_DICT })
+    {
+        const char *name = mode == COMPRESS_NONE ? "none" : "lz";
+        session->linkParams.compress = mode;
+
+        // before: every line gathered, then the whole text split before the first payload is sent
+        {
+            double start = benchSeconds();
+            string text;
+            for (const auto &l : lines)
+                text += l;
+            vector<string> packets = splitText(text);
+            double total = benchSeconds() - start;
+            snprintf(line, sizeof(line), "queue,whole,%s,%zu,%.2f,%.2f,0,0,%zu\n", name, written,
+                total * 1e3, total * 1e3, packets.size());
+            report += line;
+        }
+
+        // after: cut a line at a time into the send queue, taken on another thread as they come
+        {
+            FrameQueue queue(FRAME_QUEUE_DEPTH);
+            string payload;
+            double start = benchSeconds(), first = 0;
+            queue.open();
+            thread packetizer([&] {
+                string pending;
+                for (size_t i = 0; i < lines.size(); i++)
+                {
+                    pending += lines[i];
+                    if (!cutPayloads(pending, i == lines.size() - 1, queue))
+                        break;
+                }
+                queue.finish();
+            });
+            // the window takes its payloads from the blocks at the agreed maximum
+            string text;
+            for (size_t taken = 0; nextText(queue, text, payload, session->linkParams.maxPayload); )
+            {
+                // nothing cut yet, the engine would look at the line before it asks again
+                if (payload.empty())
+                {
+                    Sleep(0);
+                    continue;
+                }
+                if (taken++ == 0)
+                    first = benchSeconds() - start;
+            }
+            double total = benchSeconds() - start;
+            packetizer.join();
+            queue.close();
+
+            FRAME_QUEUE_METRICS queued = queue.metrics();
+            snprintf(line, sizeof(line), "queue,streamed,%s,%zu,%.2f,%.2f,%zu,%zu,%zu\n", name, written,
+                first * 1e3, total * 1e3, queued.fullStalls, queued.emptyStalls, queued.maxDepth);
+            report += line;
+        }
+    }
+
+    session->linkParams.compress = compress;
+    return report;
+}
+
+string benchStats()
+{
+    const size_t counts = 1 << 24;
+    string report = "bench,readers,adds,ns_per_add,snapshots\n";
+    char line[160];
+
+    // the engine counting alone, then with a thread taking snapshots as fast as it can
+    for (int readers : { 0, 1 })
+    {
+        LinkStats counters;
+        atomic<BOOL> counting(TRUE);
+        size_t snapshots = 0;
+        thread reader([&] {
+            while (readers && counting)
+            {
+                counters.snapshot();
+                snapshots++;
+            }
+        });
+
+        double start = benchSeconds();
+        for (size_t i = 0; i < counts; i++)
+            counters.add((int)(i % STAT_COUNTERS));
+        double seconds = benchSeconds() - start;
+        counting = FALSE;
+        reader.join();
+
+        snprintf(line, sizeof(line), "stats,%d,%zu,%.2f,%zu\n", readers, counts, seconds * 1e9 / counts, snapshots);
+        report += line;
+    }
+
+    return report;
+}
+
+string benchHistogram()
+{
+    const size_t counts = 1 << 24;
+    string report = "bench,values,ns_per_record,ns_per_clock,p50,p99,max\n";
+    char line[160];
+    LatencyHistogram h;
+
+    // spread over the buckets the engine uses, a few us to a few s
+    uint64_t value = 1;
+    double start = benchSeconds();
+    for (size_t i = 0; i < counts; i++)
+    {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        h.record((value >> 40) & 0x3FFFFF);
+    }
+    double recordSeconds = benchSeconds() - start;
+
+    // reading the clock twice is the rest of what a state pays
+    volatile uint64_t sink = 0;
+    start = benchSeconds();
+    for (size_t i = 0; i < counts; i++)
+        sink += latencyClock();
+    double clockSeconds = benchSeconds() - start;
+
+    snprintf(line, sizeof(line), "histogram,%zu,%.2f,%.2f,%llu,%llu,%llu\n", counts,
+        recordSeconds * 1e9 / counts, clockSeconds * 1e9 / counts, (unsigned long long) h.percentile(0.50),
+        (unsigned long long) h.percentile(0.99), (unsigned long long) h.maxValue());
+    return report + line;
+}
+
+string benchTrace()
+{
+    const size_t events = 1 << 24;
+    string report = "bench,events,ns_off,ns_on\n";
+    char line[160];
+    BOOL enabled = traceEnabled;
+
+    // what a TRACE() in the engine costs before traceOpen(), and once it records
+    double seconds[2];
+    for (int on = 0; on < 2; on++)
+    {
+        traceEnabled = on;
+        double start = benchSeconds();
+        for (size_t i = 0; i < events; i++)
+            TRACE(TRACE_FRAME_SENT, i, i & 0xFFF, 1024);
+        seconds[on] = benchSeconds() - start;
+    }
+    traceEnabled = enabled;
+
+    snprintf(line, sizeof(line), "trace,%zu,%.2f,%.2f\n", events, seconds[0] * 1e9 / events,
+        seconds[1] * 1e9 / events);
+    return report + line;
+}
+
+string runBenchmarks()
+{
+    return benchCRC16() + benchFec() + benchFrameDecode() + benchFrameSize() +
+        benchCompression(vector<string>{ "README.md", "LICENSE" }) + benchFileSource(100 << 20) +
+        benchFileSink(100 << 20) +
+        benchTransports(64 << 20) + benchLinkPool(16 << 10) + benchBidding(64 << 10) + benchBurst(128 << 10) +
+        benchRecovery(64 << 10) +
+        benchFrameQueue(16 << 20) + benchStats() + benchHistogram() + benchTrace();
+}
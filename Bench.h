@@ -0,0 +1,50 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Bench.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the function declarations for the micro benchmarks of the protocol
+-- hot paths. Every benchmark returns its results as CSV lines.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef BENCH_H
+#define BENCH_H
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Longest the link benchmark waits for the engines, ms
+#define BENCH_LINK_WAIT     60000
+// How often it looks for the link setups, ms
+#define BENCH_LINK_POLL     10
+// Longest the bidding benchmark gives a transfer, ms; with the fixed wait it may never get the line
+#define BENCH_BID_WAIT      20000
+// When the line of the recovery benchmark goes down and comes back, ms from its start
+#define BENCH_DOWN_MS       1000
+#define BENCH_UP_MS         10000
+
+// function prototypes
+uint64_t benchCycles();
+double benchSeconds();
+std::string benchCRC16();
+std::string benchFec();
+std::string benchFrameDecode();
+std::string benchFrameSize();
+std::string benchCompression(const std::vector<std::string> &paths);
+std::string benchFileSource(size_t bytes);
+std::string benchFileSink(size_t bytes);
+std::string benchTransports(size_t bytes);
+std::string benchLinkPool(size_t bytes);
+std::string benchBidding(size_t bytes);
+std::string benchBurst(size_t bytes);
+std::string benchRecovery(size_t bytes);
+std::string benchFrameQueue(size_t bytes);
+std::string benchStats();
+std::string benchHistogram();
+std::string benchTrace();
+std::string runBenchmarks();
+#endif
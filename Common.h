@@ -13,7 +13,7 @@
 ----------------------------------------------------------------------------------------------------------------------*/
 #ifndef COMMON_H
 #define COMMON_H
-#include <windows.h>
+#include "Platform.h"
 #include <fstream>
 #include <string>
 #include <algorithm>
@@ -22,9 +22,29 @@
 #include "resource.h"
 #include "Utils.h"
 #include "OpenFile.h"
+#include "Crc.h"
+#include "Fec.h"
+#include "Compress.h"
+#include "FileSource.h"
+#include "FileSink.h"
+#include "Bench.h"
+#include "RingBuffer.h"
+#include "FrameQueue.h"
+#include "Stats.h"
+#include "Histogram.h"
+#include "Trace.h"
+#include "FrameDecoder.h"
+#include "Arq.h"
+#include "Rtt.h"
+#include "LinkQuality.h"
+#include "Transport.h"
+#include "SimLink.h"
+#include "TermiosLink.h"
+#include "LinkSetup.h"
 #include "Serial.h"
 #include "SerialRead.h"
 #include "SerialWrite.h"
+#include "Engine.h"
 #include "Packetizer.h"
 #include "Session.h"
 #include "RMProtocol.h"
@@ -35,8 +55,7 @@
 // Error checking macros
 #define NO_ERR              400
 #define ERR_INIT_COMM       401
-#define ERR_READ_THREAD     402
-#define ERR_WRITE_THREAD    403
+#define ERR_ENGINE_THREAD   402
 #define ERR_RETRIEVE_COMM   404
 #define ERR_DISPLAY_COMM    405
 #define ERR_SET_COMM        406
@@ -48,19 +67,41 @@
 #define EOT     0x04
 #define ENQ     0x05
 #define ACK     0x06
+#define NAK     0x15
 #define SYN     0x16
-// Filled NUL
+// Filled NUL, only used by the old fixed size frames
 #define NUL0    0x14
 
-// 1(SYNC)+1024(DATA)+2(CRC)
-#define PACKET_SIZE         1027
+// 1(SYNC)+1(SEQ)+1(FLAGS)+2(LEN)+LEN(DATA)+2(CRC), frames are sized to their payload
+#define PACKET_HEADER_SIZE  5
+#define PACKET_OVERHEAD     7
+// default largest payload, the link may agree on another one
 #define PACKET_DATA_SIZE    1024
-#define PACKET_DATA_INDEX   1
+// largest payload any station accepts
+#define PACKET_DATA_MAX     4096
+// a frame carrying a full default payload
+#define PACKET_SIZE         (PACKET_OVERHEAD + PACKET_DATA_SIZE)
+#define PACKET_SEQ_INDEX    1
+#define PACKET_FLAGS_INDEX  2
+#define PACKET_LEN_INDEX    3
+#define PACKET_DATA_INDEX   5
+
+// Receive ring, holds at least two of the largest frames, FEC check bytes included
+#define RX_RING_SIZE        16384
+
+// Frame flags
+#define FLAG_POLL           0x01    // last frame of a burst, the receiver answers with a SACK
+#define FLAG_HOLD           0x02    // the sender keeps the line, another burst follows the SACK
 
 // Timeouts in ms
 #define TIME_OUT            500
 #define TIME_OUT_SHORT      200
 #define TIME_OUT_LONG       2000
+// longest gap between two bytes of the same frame
+#define TIME_OUT_BYTE       50
+// longest quiet on the line between two frames of the same burst; the receiver answers a burst
+// whose poll frame got lost this long after the last byte it heard
+#define TIME_OUT_FRAME      100
 
 // Timeout max tries
 #define LINE_TRIES          1
@@ -70,11 +111,13 @@
 #define LABEL_COUNT         7
 #define LABEL_START_ID      10022
 
-// default port#
-static  LPCSTR  lpszCommName    = "com1";
+// Synchronization object names, unnamed so two stations on one machine never share them
+#define ENGINE_LOCK         NULL
+#define EV_OVWRITE          NULL
+
+// port#, "com1" unless the command line names another
+extern  LPCSTR  lpszCommName;
 static  TCHAR   Name[]          = TEXT("Comm Shell");
-// previous CRCs, used to avoid duplicated packets
-static std::string prev_crcs;
 
 // Invalid character struct
 struct INVALID_CHAR
@@ -84,16 +127,4 @@ struct INVALID_CHAR
         return !(c >= -1 && c <= 255);
     }
 };
-
-// File stats
-struct FILE_STATISTICS {
-	int packetSent;
-    int packetLost;
-	int packetReceived;
-	int packetCorrupted;
-	int acksReceived;
-	int bitErrorRate;
-};
-
-extern FILE_STATISTICS stats;
 #endif
@@ -0,0 +1,303 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Compress.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  size_t lzCompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap, BOOL dictionary);
+--                  BOOL lzDecompress(const uint8_t *src, size_t len, std::string &out, size_t maxOut,
+--                                    BOOL dictionary);
+--                  std::string compressBlock(const std::string &raw, BYTE mode);
+--                  BOOL decompressBlock(const std::string &block, std::string &raw);
+--                  std::string compressNext(const char *data, size_t len, size_t maxPayload, BYTE mode,
+--                                           size_t *taken);
+--                  std::vector<std::string> compressStage(const std::string &raw, size_t maxPayload, BYTE mode);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Block compression in the LZ77 family. Every payload is compressed on its own, so frames can still
+-- be lost, repeated and reordered by the window without breaking the receiver. A block is a mode
+-- byte followed by either the text itself (COMPRESS_STORED) or a run of sequences:
+--
+--     token | [literal length bytes] | literals | offset (2 bytes, little endian) | [match length bytes]
+--
+-- The high nibble of the token is the literal count and the low nibble the match length minus
+-- LZ_MIN_MATCH; a nibble of 15 continues in bytes of 255 until a smaller one. The last sequence has
+-- literals only. With COMPRESS_LZ_DICT both sides act as if lzDictionary came right before the
+-- block, so even a short chat line finds matches.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Compress.h"
+#include "Common.h"
+using namespace std;
+
+#define LZ_MIN_MATCH        4
+#define LZ_MAX_OFFSET       0xFFFF
+#define LZ_HASH_BITS        12
+// candidates tried per position; the line is far slower than the search
+#define LZ_CHAIN_DEPTH      32
+
+// Common English and the protocol's own vocabulary; both stations must carry the same text
+static const char lzDictionary[] =
+    "the of and to in is that for it as was with be by on not he this are or his from at which but have "
+    "an had they you were their one all we can her has there been if more when will would who so no "
+    "out up into do any your what some about than then them its only other new also time these two may "
+    "first could like over such our after most made before should between where those being through "
+    "because each people while does just very under without against during again still message send "
+    "sent received receive file line frame packet error please thank you, Hello, Thanks. OK. Yes. No. "
+    " The  This  That  There  It  We  I  You  He  She  They  In  On  At  For  And  But "
+    "ing tion ment ness able ally ence ight ould ther ever ough ound ation ected ition ative "
+    ".\r\n\r\n, and the . The , which , but the of the in the to the on the for the and the is a "
+    "it is that the there is will be have been has been would be could be should be as well as "
+    "at the same time in order to for example such as one of the part of the end of the ";
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint32_t lzHash(const uint8_t *p)
+{
+    return (read32(p) * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// writes a 4 bit length continuation, returns FALSE when out of room
+static BOOL putLength(uint8_t *&op, const uint8_t *oend, size_t len)
+{
+    for (len -= 15; ; len -= 255)
+    {
+        if (op >= oend)
+            return FALSE;
+        if (len < 255)
+        {
+            *op++ = (uint8_t) len;
+            return TRUE;
+        }
+        *op++ = 255;
+    }
+}
+
+// reads a 4 bit length continuation, returns FALSE when the block ends early
+static BOOL getLength(const uint8_t *&ip, const uint8_t *iend, size_t *len)
+{
+    BYTE b;
+    do {
+        if (ip >= iend)
+            return FALSE;
+        b = *ip++;
+        *len += b;
+    } while (b == 255);
+    return TRUE;
+}
+
+// emits literals [anchor, end) and, when offset is not 0, a match
+static BOOL putSequence(uint8_t *&op, const uint8_t *oend, const uint8_t *anchor, size_t literals,
+    size_t offset, size_t match)
+{
+    if (op >= oend)
+        return FALSE;
+
+    size_t code = offset ? match - LZ_MIN_MATCH : 0;
+    uint8_t *token = op++;
+    *token = (uint8_t)((min<size_t>(literals, 15) << 4) | min<size_t>(code, 15));
+
+    if (literals >= 15 && !putLength(op, oend, literals))
+        return FALSE;
+    if ((size_t)(oend - op) < literals)
+        return FALSE;
+    memcpy(op, anchor, literals);
+    op += literals;
+
+    if (!offset)
+        return TRUE;
+
+    if (oend - op < 2)
+        return FALSE;
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+
+    return code < 15 || putLength(op, oend, code);
+}
+
+size_t lzCompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap, BOOL dictionary)
+{
+    // the dictionary is matched as if it had been sent just before the block
+    size_t dictLen = dictionary ? sizeof(lzDictionary) - 1 : 0;
+    vector<uint8_t> buf(dictLen + len);
+    memcpy(buf.data(), lzDictionary, dictLen);
+    memcpy(buf.data() + dictLen, src, len);
+
+    // head of the hash chain for every hash, and the previous position with the same hash
+    vector<int32_t> table(1 << LZ_HASH_BITS, -1);
+    vector<int32_t> chain(buf.size(), -1);
+    const uint8_t *base = buf.data();
+    size_t n = buf.size();
+
+    auto insert = [&](size_t pos) {
+        uint32_t h = lzHash(base + pos);
+        chain[pos] = table[h];
+        table[h] = (int32_t) pos;
+    };
+
+    for (size_t i = 0; i + LZ_MIN_MATCH <= dictLen; i++)
+        insert(i);
+
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + cap;
+    size_t anchor = dictLen, i = dictLen;
+
+    while (i + LZ_MIN_MATCH <= n)
+    {
+        // longest match among the most recent candidates
+        size_t match = 0, offset = 0;
+        int32_t cand = table[lzHash(base + i)];
+        for (int depth = 0; cand >= 0 && depth < LZ_CHAIN_DEPTH && i - cand <= LZ_MAX_OFFSET; depth++)
+        {
+            size_t len = 0;
+            while (i + len < n && base[cand + len] == base[i + len])
+                len++;
+            if (len > match)
+            {
+                match = len;
+                offset = i - cand;
+            }
+            cand = chain[cand];
+        }
+        insert(i);
+
+        if (match < LZ_MIN_MATCH)
+        {
+            i++;
+            continue;
+        }
+
+        if (!putSequence(op, oend, base + anchor, i - anchor, offset, match))
+            return 0;
+
+        for (size_t k = 1; k < match && i + k + LZ_MIN_MATCH <= n; k++)
+            insert(i + k);
+        i += match;
+        anchor = i;
+    }
+
+    if (!putSequence(op, oend, base + anchor, n - anchor, 0, 0))
+        return 0;
+
+    return op - dst;
+}
+
+BOOL lzDecompress(const uint8_t *src, size_t len, string &out, size_t maxOut, BOOL dictionary)
+{
+    size_t dictLen = dictionary ? sizeof(lzDictionary) - 1 : 0;
+    const uint8_t *ip = src, *iend = src + len;
+
+    out.assign(lzDictionary, dictLen);
+    while (ip < iend)
+    {
+        BYTE token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(ip, iend, &literals))
+            return FALSE;
+        if ((size_t)(iend - ip) < literals || out.length() - dictLen + literals > maxOut)
+            return FALSE;
+        out.append((const char*) ip, literals);
+        ip += literals;
+
+        // the last sequence has no match
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return FALSE;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t match = token & 0x0F;
+        if (match == 15 && !getLength(ip, iend, &match))
+            return FALSE;
+        match += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > out.length() || out.length() - dictLen + match > maxOut)
+            return FALSE;
+
+        // byte by byte, a match may overlap the text it produces
+        size_t from = out.length() - offset;
+        for (size_t k = 0; k < match; k++)
+            out += out[from + k];
+    }
+
+    out.erase(0, dictLen);
+    return TRUE;
+}
+
+string compressBlock(const string &raw, BYTE mode)
+{
+    if (mode != COMPRESS_NONE && raw.length() > 1)
+    {
+        // must come out at least a byte smaller to be worth it
+        string block(raw.length(), '\0');
+        block[0] = (char) mode;
+        size_t n = lzCompress((const uint8_t*) raw.data(), raw.length(), (uint8_t*) &block[1],
+            raw.length() - 1, mode == COMPRESS_LZ_DICT);
+        if (n > 0)
+        {
+            block.resize(n + 1);
+            return block;
+        }
+    }
+
+    return string(1, (char) COMPRESS_STORED) + raw;
+}
+
+BOOL decompressBlock(const string &block, string &raw)
+{
+    if (block.empty())
+        return FALSE;
+
+    const uint8_t *data = (const uint8_t*) block.data() + 1;
+    size_t len = block.length() - 1;
+
+    switch ((BYTE) block[0])
+    {
+    case COMPRESS_STORED:
+        raw.assign((const char*) data, len);
+        return TRUE;
+    case COMPRESS_LZ:
+    case COMPRESS_LZ_DICT:
+        return lzDecompress(data, len, raw, COMPRESS_MAX_RAW, (BYTE) block[0] == COMPRESS_LZ_DICT);
+    }
+
+    return FALSE;
+}
+
+string compressNext(const char *data, size_t len, size_t maxPayload, BYTE mode, size_t *taken)
+{
+    // the mode byte takes one byte of every payload
+    size_t room = maxPayload - 1;
+
+    // start with as much text as a block may hold, and shrink it until the block fits a frame
+    size_t take = min<size_t>(len, min<size_t>(room * COMPRESS_SPAN, COMPRESS_MAX_RAW));
+    string block = compressBlock(string(data, take), mode);
+    while (block.length() > maxPayload && take > room)
+    {
+        take = max<size_t>(room, take * maxPayload / block.length() * 15 / 16);
+        block = compressBlock(string(data, take), mode);
+    }
+
+    *taken = take;
+    return block;
+}
+
+vector<string> compressStage(const string &raw, size_t maxPayload, BYTE mode)
+{
+    vector<string> payloads;
+    size_t taken;
+
+    for (size_t i = 0; i < raw.length(); i += taken)
+        payloads.push_back(compressNext(raw.data() + i, raw.length() - i, maxPayload, mode, &taken));
+
+    return payloads;
+}
@@ -0,0 +1,41 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Compress.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and function declarations for the compression
+-- stage that sits between the packetizer and the line.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef COMPRESS_H
+#define COMPRESS_H
+#include "Platform.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Compression modes, agreed at link setup; also the first byte of every compressed payload
+#define COMPRESS_NONE       0x00
+#define COMPRESS_LZ         0x01
+#define COMPRESS_LZ_DICT    0x02
+
+// a block is stored when it does not get any smaller
+#define COMPRESS_STORED     COMPRESS_NONE
+
+// A block holds at most this many payloads worth of text
+#define COMPRESS_SPAN       4
+// Largest block of text the receiver expands
+#define COMPRESS_MAX_RAW    16384
+
+// function prototypes
+size_t lzCompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap, BOOL dictionary);
+BOOL lzDecompress(const uint8_t *src, size_t len, std::string &out, size_t maxOut, BOOL dictionary);
+std::string compressBlock(const std::string &raw, BYTE mode);
+BOOL decompressBlock(const std::string &block, std::string &raw);
+std::string compressNext(const char *data, size_t len, size_t maxPayload, BYTE mode, size_t *taken);
+std::vector<std::string> compressStage(const std::string &raw, size_t maxPayload, BYTE mode);
+#endif
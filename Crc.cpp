@@ -0,0 +1,251 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Crc.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  uint16_t crc16(const uint8_t *data, size_t len);
+--                  uint16_t crc16Update(uint16_t crc, const uint8_t *data, size_t len);
+--                  uint16_t crc16UpdatePath(int path, uint16_t crc, const uint8_t *data, size_t len);
+--                  uint16_t crc16Bitwise(uint16_t crc, const uint8_t *data, size_t len);
+--                  uint16_t crc16Slice8(uint16_t crc, const uint8_t *data, size_t len);
+--                  uint16_t crc16Clmul(uint16_t crc, const uint8_t *data, size_t len);
+--                  bool crc16PathSupported(int path);
+--                  int crc16SelectedPath();
+--                  const char *crc16PathName(int path);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Three interchangeable CRC-16/CCITT-FALSE kernels working on raw bytes:
+--   bitwise  - portable reference, one bit at a time
+--   slice8   - eight 256-entry tables generated at compile time, eight bytes per step
+--   clmul    - PCLMULQDQ folding of 64-byte blocks, picked at runtime when the CPU has it
+-- Every kernel takes the running CRC register and returns the updated one, so a frame can be
+-- checked piece by piece (e.g. both halves of a wrapped ring buffer).
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Crc.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC16_HAVE_CLMUL
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC16_TARGET
+#else
+#include <cpuid.h>
+#define CRC16_TARGET __attribute__((target("pclmul,ssse3")))
+#endif
+#endif
+
+struct CRC16_TABLES {
+    uint16_t t[8][256];
+};
+
+// t[k][b] is the CRC contribution of byte b followed by k zero bytes
+static constexpr CRC16_TABLES makeTables()
+{
+    CRC16_TABLES tables = {};
+
+    for (int b = 0; b < 256; b++)
+    {
+        uint16_t c = (uint16_t)(b << 8);
+        for (int bit = 0; bit < 8; bit++)
+            c = (c & 0x8000) ? (uint16_t)((c << 1) ^ CRC16_POLY) : (uint16_t)(c << 1);
+        tables.t[0][b] = c;
+    }
+
+    for (int k = 1; k < 8; k++)
+        for (int b = 0; b < 256; b++)
+            tables.t[k][b] = (uint16_t)((tables.t[k - 1][b] << 8) ^ tables.t[0][tables.t[k - 1][b] >> 8]);
+
+    return tables;
+}
+
+static constexpr CRC16_TABLES crcTables = makeTables();
+
+uint16_t crc16Bitwise(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len--)
+    {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+uint16_t crc16Slice8(uint16_t crc, const uint8_t *data, size_t len)
+{
+    const uint16_t (*t)[256] = crcTables.t;
+
+    while (len >= 8)
+    {
+        crc = t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xFF)] ^
+              t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^
+              t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = (uint16_t)((crc << 8) ^ t[0][(crc >> 8) ^ *data++]);
+
+    return crc;
+}
+
+// x^n mod P, the multiplier that moves a 64-bit lane n bits further down the message
+static constexpr uint64_t xPowModP(int n)
+{
+    uint32_t r = 1;
+    for (int i = 0; i < n; i++)
+    {
+        r <<= 1;
+        if (r & 0x10000)
+            r ^= 0x10000 | CRC16_POLY;
+    }
+    return r;
+}
+
+#ifdef CRC16_HAVE_CLMUL
+// Folds the 128-bit accumulator x over `bits` of following message and adds the next block
+CRC16_TARGET static inline __m128i fold(__m128i x, __m128i k, __m128i next)
+{
+    __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+    __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+    return _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+}
+
+CRC16_TARGET uint16_t crc16Clmul(uint16_t crc, const uint8_t *data, size_t len)
+{
+    if (len < 64)
+        return crc16Slice8(crc, data, len);
+
+    // the message is big-endian, byte 0 is the highest coefficient
+    const __m128i swap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i k512 = _mm_set_epi64x((long long) xPowModP(512 + 64), (long long) xPowModP(512));
+    const __m128i k128 = _mm_set_epi64x((long long) xPowModP(128 + 64), (long long) xPowModP(128));
+
+    __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data +  0)), swap);
+    __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + 16)), swap);
+    __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + 32)), swap);
+    __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + 48)), swap);
+    // the running register lines up with the first 16 bits of the message
+    x0 = _mm_xor_si128(x0, _mm_set_epi64x((long long) ((uint64_t) crc << 48), 0));
+    data += 64;
+    len -= 64;
+
+    // four independent lanes, each folded over the 512 bits that follow it
+    while (len >= 64)
+    {
+        x0 = fold(x0, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data +  0)), swap));
+        x1 = fold(x1, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + 16)), swap));
+        x2 = fold(x2, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + 32)), swap));
+        x3 = fold(x3, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + 48)), swap));
+        data += 64;
+        len -= 64;
+    }
+
+    __m128i x = fold(fold(fold(x0, k128, x1), k128, x2), k128, x3);
+    while (len >= 16)
+    {
+        x = fold(x, k128, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) data), swap));
+        data += 16;
+        len -= 16;
+    }
+
+    // the CRC of the 128-bit remainder taken from a zero register is the folded message mod P
+    uint8_t rest[16];
+    _mm_storeu_si128((__m128i*) rest, _mm_shuffle_epi8(x, swap));
+    crc = crc16Slice8(0, rest, sizeof(rest));
+
+    return crc16Slice8(crc, data, len);
+}
+
+static bool clmulSupported()
+{
+    unsigned int ecx;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned int) info[2];
+#else
+    unsigned int eax, ebx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+#endif
+    // PCLMULQDQ and SSSE3
+    return (ecx & (1u << 1)) && (ecx & (1u << 9));
+}
+#else
+uint16_t crc16Clmul(uint16_t crc, const uint8_t *data, size_t len)
+{
+    return crc16Slice8(crc, data, len);
+}
+
+static bool clmulSupported()
+{
+    return false;
+}
+#endif
+
+bool crc16PathSupported(int path)
+{
+    switch (path)
+    {
+    case CRC16_BITWISE:
+    case CRC16_SLICE8:
+        return true;
+    case CRC16_CLMUL:
+        return clmulSupported();
+    }
+    return false;
+}
+
+int crc16SelectedPath()
+{
+    static const int path = crc16PathSupported(CRC16_CLMUL) ? CRC16_CLMUL : CRC16_SLICE8;
+    return path;
+}
+
+const char *crc16PathName(int path)
+{
+    switch (path)
+    {
+    case CRC16_BITWISE:
+        return "bitwise";
+    case CRC16_SLICE8:
+        return "slice8";
+    case CRC16_CLMUL:
+        return "clmul";
+    }
+    return "unknown";
+}
+
+uint16_t crc16UpdatePath(int path, uint16_t crc, const uint8_t *data, size_t len)
+{
+    switch (path)
+    {
+    case CRC16_BITWISE:
+        return crc16Bitwise(crc, data, len);
+    case CRC16_CLMUL:
+        return crc16Clmul(crc, data, len);
+    }
+    return crc16Slice8(crc, data, len);
+}
+
+uint16_t crc16Update(uint16_t crc, const uint8_t *data, size_t len)
+{
+    return crc16UpdatePath(crc16SelectedPath(), crc, data, len);
+}
+
+uint16_t crc16(const uint8_t *data, size_t len)
+{
+    return crc16Update(CRC16_INIT, data, len);
+}
@@ -0,0 +1,39 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Crc.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and function declarations for the CRC-16 engine
+-- used to protect frames. All kernels compute CRC-16/CCITT-FALSE and accept incremental updates.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef CRC_H
+#define CRC_H
+#include <cstddef>
+#include <cstdint>
+
+// CRC-16/CCITT-FALSE
+#define CRC16_POLY          0x1021
+#define CRC16_INIT          0xFFFF
+
+// kernels, in order of preference
+#define CRC16_BITWISE       0
+#define CRC16_SLICE8        1
+#define CRC16_CLMUL         2
+#define CRC16_PATHS         3
+
+// function prototypes
+uint16_t crc16(const uint8_t *data, size_t len);
+uint16_t crc16Update(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t crc16UpdatePath(int path, uint16_t crc, const uint8_t *data, size_t len);
+uint16_t crc16Bitwise(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t crc16Slice8(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t crc16Clmul(uint16_t crc, const uint8_t *data, size_t len);
+bool crc16PathSupported(int path);
+int crc16SelectedPath();
+const char *crc16PathName(int path);
+#endif
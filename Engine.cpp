@@ -0,0 +1,505 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Engine.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  VOID startEngine(LinkSession *link);
+--                  VOID stopEngine(LinkSession *link);
+--                  VOID postCommand(BYTE type, HANDLE done, FrameQueue *queue, LinkSession *link, LPCSTR path);
+--                  DWORD WINAPI engineThread(LPVOID param);
+--                  BYTE engineIdle();
+--                  BYTE engineBid();
+--                  BYTE engineSend();
+--                  BYTE engineWaitAck();
+--                  BYTE engineWait();
+--                  BYTE engineReceive();
+--                  BOOL nextCommand(ENGINE_COMMAND *command);
+--                  BOOL loadPending();
+--                  VOID startTransfer(ENGINE_COMMAND &command);
+--                  VOID finishTransfer();
+--                  std::string formatLatency();
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The protocol engine: one thread for the life of the link, started with the port and the only one
+-- that reads or writes it. Each state runs one step of the protocol and returns the next state:
+--
+--     IDLE     -> BID       a send is in progress
+--              -> RECEIVE   the peer bid for the line, we answered with an ACK
+--     BID      -> SEND      our ENQ was acknowledged
+--              -> WAIT      it was not, we back off while the peer may be bidding itself
+--     SEND     -> WAIT_ACK  the burst is on the line
+--     WAIT_ACK -> SEND      no SACK yet and tries left, or the next burst on a held line
+--              -> WAIT      otherwise
+--     WAIT     -> RECEIVE   the peer bid within the wait, we answered with an ACK
+--              -> IDLE      otherwise
+--     RECEIVE  -> IDLE      the burst is answered with a SACK
+--              -> RECEIVE   the sender holds the line for another burst
+--
+-- The dialog and the command line never touch the line themselves. They queue a command with
+-- postCommand() and wake the engine, which takes it the next time it is idle with nothing to send.
+-- A send stays with the engine from its first bid until its window drains or the peer stops
+-- answering, then the event given with the command is set. Only the engine opens and closes the
+-- file it sends: the dialog posts ENGINE_CMD_LOAD, and a file send ends early when one is next.
+--
+-- When the link agreed to bursts, a won bid carries up to linkParams.burst frames, window after
+-- window, for at most BURST_MAX_MS. Each burst that has room for another after it flags its frames
+-- with FLAG_HOLD; the receiver answers with its SACK and stays in RECEIVE, and the sender goes
+-- straight on with the next burst, without the turnaround and the bid in between. The bid limits
+-- keep the peer from being shut out for long. A sender that lost the SACK bids for the line again,
+-- and the receiver still waiting in RECEIVE answers its ENQ as it would from IDLE.
+--
+-- The engine keeps what it knows about the link in the link's session. startEngine() runs the engine
+-- of the calling thread's link on a thread of its own; a LinkPool runs the engines of many links on a
+-- few threads, see LinkPool.cpp.
+--
+-- Every step of a state goes into that state's latency histogram: the line bid in BID, the burst
+-- in SEND, the SACK in WAIT_ACK, the turnaround in WAIT and a received burst in RECEIVE. Each frame
+-- written goes into LATENCY_FRAME_WRITE as well. The summary of every histogram is dumped when a
+-- send finishes. State changes, bids and transfers go into the binary trace, see Trace.cpp.
+--
+-- A link in a bond takes the payloads of its sends from the bond and tells it of every one the peer
+-- acknowledges; while the bond has no stripe for it, it stays idle. See LinkBond.cpp.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Engine.h"
+#include "LinkBond.h"
+#include "LinkSession.h"
+#include <deque>
+using namespace std;
+
+// histogram names in the latency summary
+const char *latencyNames[LATENCY_SLOTS] = {
+    "idle", "bid", "send", "wait_ack", "wait", "receive", "frame_write"
+};
+
+VOID startEngine(LinkSession *link)
+{
+    if (!link)
+        link = session;
+
+    try {
+        link->engineRunning = TRUE;
+        link->engineState = ENGINE_IDLE;
+        errorCheck((link->engineHandle = CreateThread(NULL, 0, engineThread, link, 0,
+            &link->engineThreadId)) == NULL ? ERR_ENGINE_THREAD : NO_ERR);
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+    }
+}
+
+VOID stopEngine(LinkSession *link)
+{
+    if (!link)
+        link = session;
+    if (!link->engineHandle)
+        return;
+
+    // every state other than idle ends within its timeout, so the engine finishes the exchange it
+    // is in and stops
+    link->engineRunning = FALSE;
+    link->transport->wake();
+    WaitForSingleObject(link->engineHandle, INFINITE);
+    CloseHandle(link->engineHandle);
+    link->engineHandle = NULL;
+}
+
+VOID postCommand(BYTE type, HANDLE done, FrameQueue *queue, LinkSession *link, LPCSTR path)
+{
+    ENGINE_COMMAND command = { type, queue, done, path ? path : "" };
+    if (!link)
+        link = session;
+
+    WaitForSingleObject(link->hEngine_Lock, INFINITE);
+    link->engineQueue.push_back(command);
+    ReleaseMutex(link->hEngine_Lock);
+
+    // the engine may be waiting on the line
+    if (link->transport)
+        link->transport->wake();
+}
+
+DWORD WINAPI engineThread(LPVOID param)
+{
+    // the link this engine runs, for everything it calls
+    session = (LinkSession *) param;
+
+    while (session->engineRunning || session->engineState != ENGINE_IDLE)
+    {
+        BYTE state = session->engineState;
+        uint64_t entered = latencyClock();
+
+        try {
+            switch (session->engineState)
+            {
+            case ENGINE_IDLE:
+                session->engineState = engineIdle();
+                break;
+            case ENGINE_BID:
+                session->engineState = engineBid();
+                break;
+            case ENGINE_SEND:
+                session->engineState = engineSend();
+                break;
+            case ENGINE_WAIT_ACK:
+                session->engineState = engineWaitAck();
+                break;
+            case ENGINE_WAIT:
+                session->engineState = engineWait();
+                break;
+            case ENGINE_RECEIVE:
+                session->engineState = engineReceive();
+                break;
+            default:
+                session->engineState = ENGINE_IDLE;
+                break;
+            }
+        }
+        catch (exception& e) {
+            OutputDebugString(e.what());
+            session->engineState = ENGINE_IDLE;
+        }
+        session->stateLatency[state].record(latencyClock() - entered);
+        if (session->engineState != state)
+            TRACE(TRACE_STATE, 0, state, 0);
+    }
+
+    // nobody is left waiting on an engine that is gone
+    ENGINE_COMMAND command;
+    if (session->transfer.window)
+        finishTransfer();
+    while (nextCommand(&command))
+    {
+        if (command.queue)
+            command.queue->close();
+        if (command.done)
+            SetEvent(command.done);
+    }
+
+    return 0;
+}
+
+BYTE engineIdle()
+{
+    ENGINE_COMMAND command;
+
+    if (!session->engineRunning)
+        return ENGINE_IDLE;
+
+    // a send goes on until its window drains or the peer stops answering, or answers but takes none
+    // of it; a file send also ends when the dialog cleared or replaced the file
+    SendWindow *window = session->transfer.window;
+    if (window && (window->done() || session->transfer.retries >= ARQ_MAX_RETRIES ||
+        session->transfer.fruitless >= ARQ_MAX_BURSTS ||
+        (!session->transfer.queue && !session->bond && loadPending())))
+        finishTransfer();
+
+    if (!session->transfer.window && nextCommand(&command))
+    {
+        if (command.type == ENGINE_CMD_SEND)
+            startTransfer(command);
+        else
+        {
+            if (command.type == ENGINE_CMD_LOAD)
+            {
+                session->fileSource.close();
+                if (!command.path.empty() && !session->fileSource.open(command.path.c_str()))
+                    OutputDebugString("cannot open the file to send\n");
+            }
+            else
+                requestSetup();
+            if (command.done)
+                SetEvent(command.done);
+        }
+        return ENGINE_IDLE;
+    }
+
+    // a setup the peer has not answered goes out again, the wait for input is cut short until then.
+    // After a send was given up no frame goes out before the peer has answered one, the setups of a
+    // send count as its unanswered bids meanwhile
+    BOOL resyncing = session->localParams.resync != RESYNC_NONE;
+    if (resyncing || (session->setupPending && !session->transfer.window))
+    {
+        DWORD waited = GetTickCount() - session->setupSent;
+        if (waited >= TIME_OUT_LONG)
+        {
+            if (session->transfer.window)
+                session->transfer.retries++;
+            requestSetup();
+            return ENGINE_IDLE;
+        }
+        if (!timeout(TIME_OUT_LONG - waited))
+            return ENGINE_IDLE;
+    }
+
+    // a send bids again at once, unless something came in since the last exchange; a bid from the
+    // peer goes first, and readInput() drains what is left of a late SACK until the line is quiet
+    if (session->transfer.window && !resyncing && !timeout(0))
+    {
+        // a bonded link with nothing to send waits below until the bond wakes it, or ends its send
+        if (session->transfer.window->ready())
+            return ENGINE_BID;
+        if (session->transfer.window->done())
+            return ENGINE_IDLE;
+        // the packetizer is still cutting the text, the line is looked at while it does
+        if (!session->bond && !timeout(FRAME_QUEUE_WAIT))
+            return ENGINE_IDLE;
+    }
+
+    // Idle state waiting, a new command ends the wait with nothing read
+    CHAR c = readInput();
+    if (evaluateInput(c))
+    {
+        TRACE(TRACE_ENQ_RECEIVED, 0, 0, 0);
+        sendACK();
+        return ENGINE_RECEIVE;
+    }
+    if (c == SOH)
+        // the peer is setting up the link
+        receiveSetup();
+
+    return ENGINE_IDLE;
+}
+
+BYTE engineBid()
+{
+    int result = confirmLine();
+    if (result == BID_WON)
+    {
+        session->transfer.retries = 0;
+        session->transfer.tries = 0;
+        session->transfer.held = 0;
+        session->transfer.heldSince = GetTickCount();
+        return ENGINE_SEND;
+    }
+
+    // a collision shows the peer is there, only bids nobody answered count towards giving up
+    if (result == BID_UNANSWERED)
+    {
+        TRACE(TRACE_BID_FAILED, 0, LINE_TRIES, session->transfer.retries);
+        session->transfer.retries++;
+    }
+    session->transfer.wait = bidBackoff(result);
+    return ENGINE_WAIT;
+}
+
+BYTE engineSend()
+{
+    SendWindow *window = session->transfer.window;
+
+    // the receiver stays on the line for another burst while one more window fits in the frames and
+    // the time a bid allows, and the source has more for it
+    session->transfer.hold = session->linkParams.burst && window->more() &&
+        session->transfer.held + 2 * session->linkParams.window <= session->linkParams.burst &&
+        GetTickCount() - session->transfer.heldSince < BURST_MAX_MS;
+    sendBurst(window, session->transfer.burst, session->transfer.hold);
+    session->transfer.held += session->transfer.burst.size();
+    session->transfer.tries++;
+    return ENGINE_WAIT_ACK;
+}
+
+BYTE engineWaitAck()
+{
+    size_t acked = 0;
+
+    // without a SACK the burst goes out again while it has tries left; what came of the SACK, if
+    // anything, is gone before the line is used again
+    if (!awaitSack(session->transfer.window, session->transfer.burst, session->transfer.tries > 1, &acked))
+    {
+        drainInput();
+        if (session->transfer.tries < SEND_TRIES)
+            return ENGINE_SEND;
+    }
+
+    // the peer is there whether or not it got any of the burst, only bids it did not answer count
+    // towards giving up; a burst that gets nothing through counts towards a limit of its own
+    session->transfer.fruitless = acked ? 0 : session->transfer.fruitless + 1;
+
+    // the receiver is waiting for the next burst, it goes out without the turnaround and the bid
+    // that would come before it otherwise
+    if (session->transfer.hold && acked && session->transfer.window->ready())
+    {
+        session->transfer.tries = 0;
+        session->sendMetrics.burstsHeld++;
+        session->sendMetrics.turnaroundSavedMs += max<DWORD>(TIME_OUT_SHORT, session->linkRtt.timeout()) +
+            session->linkRtt.srtt();
+        return ENGINE_SEND;
+    }
+
+    // the peer gets the line first if it wants it; it needs at least a round trip to bid, however
+    // fast it turns around
+    session->transfer.wait = max<DWORD>(TIME_OUT_SHORT, session->linkRtt.timeout());
+    return ENGINE_WAIT;
+}
+
+BYTE engineWait()
+{
+    // WAIT STATE: wait for an enq, after our burst or for the backoff of a failed bid
+    if (!waitForENQ(session->transfer.wait))
+        return ENGINE_IDLE;
+
+    sendACK();
+    return ENGINE_RECEIVE;
+}
+
+BYTE engineReceive()
+{
+    // Now wait for the packet to come, and validate it; a sender that holds the line goes on with
+    // its next burst after our SACK, otherwise the line is free and either station may bid for it
+    return waitForPacket() ? ENGINE_RECEIVE : ENGINE_IDLE;
+}
+
+BOOL nextCommand(ENGINE_COMMAND *command)
+{
+    BOOL found;
+
+    WaitForSingleObject(session->hEngine_Lock, INFINITE);
+    if ((found = !session->engineQueue.empty()))
+    {
+        *command = session->engineQueue.front();
+        session->engineQueue.pop_front();
+    }
+    ReleaseMutex(session->hEngine_Lock);
+
+    return found;
+}
+
+BOOL loadPending()
+{
+    BOOL pending;
+
+    WaitForSingleObject(session->hEngine_Lock, INFINITE);
+    pending = !session->engineQueue.empty() && session->engineQueue.front().type == ENGINE_CMD_LOAD;
+    ReleaseMutex(session->hEngine_Lock);
+
+    return pending;
+}
+
+VOID startTransfer(ENGINE_COMMAND &command)
+{
+    try {
+        PayloadSource source;
+        session->transfer.queue = command.queue;
+        session->transfer.retries = 0;
+        session->transfer.fruitless = 0;
+        session->transfer.delivered = 0;
+        session->transfer.done = command.done;
+
+        if (session->bond)
+        {
+            // a bonded link sends the stripes the bond hands it, an empty one when another link should
+            source = [](string &payload, size_t maxSize) {
+                return session->bond->next(payload, maxSize);
+            };
+        }
+        else if (!session->transfer.queue)
+        {
+            // a loaded file goes from its mapping straight into the window
+            session->fileSource.rewind();
+            source = [](string &payload, size_t maxSize) {
+                return session->fileSource.next(payload, maxSize, session->linkParams.compress);
+            };
+        }
+        else
+        {
+            // text comes in blocks as the packetizer cuts them, the window waits for the next one and
+            // cuts its payloads from them at its own size
+            session->transfer.text.clear();
+            source = [](string &payload, size_t maxSize) {
+                return nextText(*session->transfer.queue, session->transfer.text, payload, maxSize);
+            };
+        }
+
+        session->transfer.window = new SendWindow(session->linkParams.window, session->txSeq,
+            session->linkParams.adaptive ? session->txPayload : session->linkParams.maxPayload, source);
+        session->transfer.window->setLatency(&session->sendMetrics.frameLatency);
+        if (session->bond)
+            session->transfer.window->setAckHook([](const string &payload) {
+                session->bond->acked(payload);
+            });
+        TRACE(TRACE_TRANSFER_START, session->txSeq, session->transfer.queue ? 0 : session->fileSource.size(), 0);
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+        if (session->transfer.queue)
+            session->transfer.queue->close();
+        if (session->transfer.done)
+            SetEvent(session->transfer.done);
+    }
+}
+
+VOID finishTransfer()
+{
+    SendWindow *window = session->transfer.window;
+    TRACE(TRACE_TRANSFER_END, window->nextSeq(), window->sent(), window->done() ? 0 : window->outstanding());
+
+    try {
+        if (!window->done())
+        {
+            // give up on what is still outstanding
+            session->stats.add(STAT_PACKET_LOST,
+                (int)(window->outstanding() + (session->transfer.queue ? session->transfer.queue->depth() : 0)));
+        }
+        if (session->transfer.queue)
+        {
+            FRAME_QUEUE_METRICS queued = session->transfer.queue->metrics();
+            session->sendMetrics.queueMaxDepth = max<size_t>(session->sendMetrics.queueMaxDepth, queued.maxDepth);
+            session->sendMetrics.queueFullStalls += queued.fullStalls;
+            session->sendMetrics.queueEmptyStalls += queued.emptyStalls;
+            session->transfer.queue->close();
+        }
+        session->txSeq = window->nextSeq();
+        if (!window->done())
+        {
+            // the peer may hold frames of this send, or still wait for ones that will not come; its
+            // receive window starts over at our next number before another frame goes out. The first
+            // setup that says so goes now, engineIdle() repeats it until the peer answers
+            session->localParams.resync = session->txSeq;
+            session->setupPending = TRUE;
+            session->setupSent = GetTickCount() - TIME_OUT_LONG;
+            if (session->engineRunning)
+                requestSetup();
+        }
+        session->sendMetrics.framesSent += window->sent();
+        session->sendMetrics.framesResent += window->resent();
+        // a file counts once the receiver has acknowledged all of it, a text send is not counted
+        session->transfer.delivered = window->done() && !session->transfer.queue ? session->fileSource.size() : 0;
+        session->fileSource.close();
+        // the panels belong to the dialog's thread
+        if (hDlg)
+            PostMessage(hDlg, WM_SEND_DONE, 0, 0);
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+    }
+
+    delete window;
+    session->transfer.window = NULL;
+    OutputDebugString(formatLatency().c_str());
+    if (session->transfer.done)
+        SetEvent(session->transfer.done);
+}
+
+string formatLatency()
+{
+    string summary = "state,count,p50Us,p99Us,maxUs,totalMs\n";
+    char line[160];
+
+    for (int i = 0; i < LATENCY_SLOTS; i++)
+    {
+        const LatencyHistogram &h = session->stateLatency[i];
+        snprintf(line, sizeof(line), "%s,%llu,%llu,%llu,%llu,%llu\n", latencyNames[i],
+            (unsigned long long) h.count(), (unsigned long long) h.percentile(0.50),
+            (unsigned long long) h.percentile(0.99), (unsigned long long) h.maxValue(),
+            (unsigned long long) (h.total() / 1000));
+        summary += line;
+    }
+
+    return summary;
+}
@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Engine.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the states, commands and function declarations for the protocol
+-- engine, the one thread that runs a link.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef ENGINE_H
+#define ENGINE_H
+#include "Common.h"
+
+class LinkSession;
+
+// engine states
+#define ENGINE_IDLE         0   // listening to the line, takes the next command
+#define ENGINE_BID          1   // ENQ sent, waiting for the ACK
+#define ENGINE_SEND         2   // putting a burst on the line
+#define ENGINE_WAIT_ACK     3   // waiting for the SACK of the burst
+#define ENGINE_WAIT         4   // done with the line, the peer may bid for it
+#define ENGINE_RECEIVE      5   // the peer holds the line, collecting its burst
+#define ENGINE_STATES       6
+
+// posted to the dialog when a send ends, the dialog gives the send panel back on its own thread
+#define WM_SEND_DONE        (WM_APP + 1)
+
+// commands queued for the engine
+#define ENGINE_CMD_SEND     0   // send the loaded file, or the text given with the command
+#define ENGINE_CMD_SETUP    1   // offer our link parameters to the peer
+#define ENGINE_CMD_LOAD     2   // load the file given with the command, none closes the loaded one
+
+// A command waiting for the engine
+struct ENGINE_COMMAND {
+    BYTE type;
+    FrameQueue *queue;                  // payloads of the text to send, NULL sends the loaded file
+    HANDLE done;                        // set once the command is carried out, may be NULL
+    std::string path;                   // the file ENGINE_CMD_LOAD loads
+};
+
+// Longest a sender keeps the line on one won bid, ms; no burst that asks the receiver to stay on the
+// line starts after it
+#define BURST_MAX_MS        2000
+
+// The send the engine is working through, one burst per line bid, or more when the link agreed to
+struct ENGINE_TRANSFER {
+    SendWindow *window;                 // NULL when there is nothing to send
+    FrameQueue *queue;                  // where the window takes the text from, NULL for a file
+    std::string text;                   // text taken from the queue that no payload holds yet
+    DWORD retries;                      // bids in a row nobody answered
+    DWORD fruitless;                    // bursts in a row that got nothing acknowledged
+    DWORD tries;                        // times the current burst went out
+    DWORD wait;                         // ms the next WAIT listens for the peer's bid
+    // frames sent since the bid was won, when it was won, and whether the receiver was told that
+    // another burst follows the SACK
+    size_t held;
+    DWORD heldSince;
+    BOOL hold;
+    std::vector<std::pair<BYTE, size_t>> burst;     // seq and frame size of the burst in flight
+    uint64_t delivered;                 // bytes of the file the last send got across, 0 when given up
+    HANDLE done;
+};
+
+// latency histograms in microseconds: one per state, and one for putting a frame on the line
+#define LATENCY_FRAME_WRITE ENGINE_STATES
+#define LATENCY_SLOTS       (ENGINE_STATES + 1)
+
+// names of the states and of LATENCY_FRAME_WRITE, as the latency summary and the trace print them
+extern const char *latencyNames[LATENCY_SLOTS];
+
+// function prototypes; these work on the calling thread's link unless given another
+VOID startEngine(LinkSession *link = NULL);
+VOID stopEngine(LinkSession *link = NULL);
+VOID postCommand(BYTE type, HANDLE done = NULL, FrameQueue *queue = NULL, LinkSession *link = NULL,
+    LPCSTR path = NULL);
+DWORD WINAPI engineThread(LPVOID param);
+BYTE engineIdle();
+BYTE engineBid();
+BYTE engineSend();
+BYTE engineWaitAck();
+BYTE engineWait();
+BYTE engineReceive();
+BOOL nextCommand(ENGINE_COMMAND *command);
+BOOL loadPending();
+VOID startTransfer(ENGINE_COMMAND &command);
+VOID finishTransfer();
+std::string formatLatency();
+#endif
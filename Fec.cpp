@@ -0,0 +1,527 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Fec.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  uint8_t gfMul(uint8_t a, uint8_t b);
+--                  void gfMulAdd(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+--                  void gfMulAddPath(int path, uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c,
+--                      size_t n);
+--                  void gfMulAddScalar(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+--                  void gfMulAddSsse3(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+--                  void gfMulAddAvx2(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+--                  bool gfPathSupported(int path);
+--                  int gfSelectedPath();
+--                  const char *gfPathName(int path);
+--                  size_t fecDepth(size_t len, int parity, int depth);
+--                  size_t fecParitySize(size_t len, int parity, int depth);
+--                  void fecEncode(const uint8_t *data, size_t len, int parity, int depth, uint8_t *out);
+--                  int fecDecode(uint8_t *data, size_t len, uint8_t *check, int parity, int depth);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Reed-Solomon over GF(256), with the roots of the generator at a^0 .. a^(parity-1). A block of len
+-- bytes is spread over D codewords: byte i belongs to codeword i % D. D is the configured depth, or
+-- more when the block needs more codewords of at most 255 - parity data bytes. A burst of b bad
+-- bytes therefore costs each codeword about b / D of them. The last row of a block may be short.
+-- The codewords that have no byte there use a zero in its place, which both sides know, so the
+-- receiver rejects any correction that lands on it. The check bytes go out row by row after the
+-- block, parity symbol j of every codeword in turn.
+--
+-- Rows of the block are exactly one byte of each codeword, so both the encoder and the syndromes
+-- work a row at a time across all D codewords. Each step is dst = add ^ c * src over the row, the
+-- one kernel there is:
+--   scalar - two nibble lookups per byte
+--   ssse3  - the same lookups with PSHUFB, 16 bytes per step
+--   avx2   - 32 bytes per step, picked at runtime when the CPU and the OS have it
+-- Locating and fixing the errors of a codeword (Berlekamp-Massey, Chien search, Forney) is scalar.
+-- It only runs for codewords whose syndromes are not all zero.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Fec.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GF_HAVE_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define GF_TARGET_SSSE3
+#define GF_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define GF_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define GF_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+#endif
+
+struct GF_TABLES {
+    uint8_t exp[2 * FEC_CODEWORD];
+    uint8_t log[256];
+    // c * x split in the low and the high nibble of x, the PSHUFB tables of each constant
+    uint8_t lo[256][16];
+    uint8_t hi[256][16];
+    // gen[p][i] is the x^i coefficient of the generator with p roots
+    uint8_t gen[FEC_MAX_PARITY + 1][FEC_MAX_PARITY + 1];
+};
+
+static GF_TABLES makeTables()
+{
+    GF_TABLES t;
+    memset(&t, 0, sizeof(t));
+
+    unsigned x = 1;
+    for (int i = 0; i < FEC_CODEWORD; i++)
+    {
+        t.exp[i] = t.exp[i + FEC_CODEWORD] = (uint8_t) x;
+        t.log[x] = (uint8_t) i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= GF_POLY;
+    }
+
+    for (int c = 0; c < 256; c++)
+        for (int n = 0; n < 16; n++)
+        {
+            t.lo[c][n] = c && n ? t.exp[t.log[c] + t.log[n]] : 0;
+            t.hi[c][n] = c && n ? t.exp[t.log[c] + t.log[n << 4]] : 0;
+        }
+
+    // multiply the generator with one root after the other, (x + a^(p-1))
+    t.gen[0][0] = 1;
+    for (int p = 1; p <= FEC_MAX_PARITY; p++)
+    {
+        uint8_t root = t.exp[p - 1];
+        for (int i = p; i >= 0; i--)
+        {
+            uint8_t term = t.gen[p - 1][i];
+            uint8_t prev = i > 0 ? t.gen[p - 1][i - 1] : 0;
+            t.gen[p][i] = prev ^ (term && root ? t.exp[t.log[term] + t.log[root]] : 0);
+        }
+    }
+
+    return t;
+}
+
+static const GF_TABLES &gfTables()
+{
+    static const GF_TABLES tables = makeTables();
+    return tables;
+}
+
+uint8_t gfMul(uint8_t a, uint8_t b)
+{
+    const GF_TABLES &t = gfTables();
+    return a && b ? t.exp[t.log[a] + t.log[b]] : 0;
+}
+
+static uint8_t gfInv(uint8_t a)
+{
+    const GF_TABLES &t = gfTables();
+    return t.exp[FEC_CODEWORD - t.log[a]];
+}
+
+void gfMulAddScalar(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    const uint8_t *lo = gfTables().lo[c];
+    const uint8_t *hi = gfTables().hi[c];
+
+    for (size_t i = 0; i < n; i++)
+        dst[i] = add[i] ^ lo[src[i] & 0x0F] ^ hi[src[i] >> 4];
+}
+
+#ifdef GF_HAVE_SIMD
+GF_TARGET_SSSE3 void gfMulAddSsse3(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    const __m128i lo = _mm_loadu_si128((const __m128i*) gfTables().lo[c]);
+    const __m128i hi = _mm_loadu_si128((const __m128i*) gfTables().hi[c]);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(s, nibble)),
+            _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), nibble)));
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i*) (add + i)), p));
+    }
+
+    if (i < n)
+        gfMulAddScalar(dst + i, add + i, src + i, c, n - i);
+}
+
+GF_TARGET_AVX2 void gfMulAddAvx2(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) gfTables().lo[c]));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) gfTables().hi[c]));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s, nibble)),
+            _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), nibble)));
+        _mm256_storeu_si256((__m256i*) (dst + i),
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (add + i)), p));
+    }
+
+    // a row of up to 16 codewords still takes one step
+    if (i < n)
+        gfMulAddSsse3(dst + i, add + i, src + i, c, n - i);
+}
+
+static bool ssse3Supported()
+{
+    unsigned int ecx;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned int) info[2];
+#else
+    unsigned int eax, ebx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+#endif
+    return (ecx & (1u << 9)) != 0;
+}
+
+static bool avx2Supported()
+{
+    unsigned int ecx, ebx7;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned int) info[2];
+    __cpuidex(info, 7, 0);
+    ebx7 = (unsigned int) info[1];
+#else
+    unsigned int eax, ebx, edx;
+    unsigned int ecx7;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !__get_cpuid_count(7, 0, &eax, &ebx7, &ecx7, &edx))
+        return false;
+#endif
+    // AVX and OSXSAVE, and the OS saves the YMM registers
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28)))
+        return false;
+#ifdef _MSC_VER
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xlo, xhi;
+    __asm__ volatile ("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long) xhi << 32) | xlo;
+#endif
+    return (xcr0 & 6) == 6 && (ebx7 & (1u << 5));
+}
+#else
+void gfMulAddSsse3(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    gfMulAddScalar(dst, add, src, c, n);
+}
+
+void gfMulAddAvx2(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    gfMulAddScalar(dst, add, src, c, n);
+}
+
+static bool ssse3Supported()
+{
+    return false;
+}
+
+static bool avx2Supported()
+{
+    return false;
+}
+#endif
+
+bool gfPathSupported(int path)
+{
+    switch (path)
+    {
+    case GF_SCALAR:
+        return true;
+    case GF_SSSE3:
+        return ssse3Supported();
+    case GF_AVX2:
+        return avx2Supported();
+    }
+    return false;
+}
+
+int gfSelectedPath()
+{
+    static const int path = gfPathSupported(GF_AVX2) ? GF_AVX2 :
+        gfPathSupported(GF_SSSE3) ? GF_SSSE3 : GF_SCALAR;
+    return path;
+}
+
+const char *gfPathName(int path)
+{
+    switch (path)
+    {
+    case GF_SCALAR:
+        return "scalar";
+    case GF_SSSE3:
+        return "ssse3";
+    case GF_AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+void gfMulAddPath(int path, uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    switch (path)
+    {
+    case GF_SSSE3:
+        gfMulAddSsse3(dst, add, src, c, n);
+        return;
+    case GF_AVX2:
+        gfMulAddAvx2(dst, add, src, c, n);
+        return;
+    }
+    gfMulAddScalar(dst, add, src, c, n);
+}
+
+void gfMulAdd(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n)
+{
+    gfMulAddPath(gfSelectedPath(), dst, add, src, c, n);
+}
+
+size_t fecDepth(size_t len, int parity, int depth)
+{
+    if (parity <= 0 || parity > FEC_MAX_PARITY || len == 0)
+        return 0;
+
+    size_t data = FEC_CODEWORD - parity;
+    size_t need = (len + data - 1) / data;
+    size_t d = need > (size_t) depth ? need : (size_t) depth;
+    // a block too large for the deepest interleave goes without, on both sides
+    if (need > FEC_MAX_DEPTH)
+        return 0;
+    d = d < FEC_MAX_DEPTH ? d : FEC_MAX_DEPTH;
+    return d < len ? d : len;
+}
+
+size_t fecParitySize(size_t len, int parity, int depth)
+{
+    return fecDepth(len, parity, depth) * parity;
+}
+
+// the rows are padded to whole SIMD steps, the extra lanes are never read back
+static size_t rowWidth(size_t depth)
+{
+    return (depth + 15) & ~(size_t) 15;
+}
+
+// row r of the block, the short last one padded with zeros
+static void loadRow(uint8_t *row, const uint8_t *data, size_t len, size_t depth, size_t r)
+{
+    size_t n = len - r * depth < depth ? len - r * depth : depth;
+    memcpy(row, data + r * depth, n);
+    memset(row + n, 0, depth - n);
+}
+
+void fecEncode(const uint8_t *data, size_t len, int parity, int depth, uint8_t *out)
+{
+    size_t d = fecDepth(len, parity, depth);
+    if (d == 0)
+        return;
+
+    const uint8_t *gen = gfTables().gen[parity];
+    int path = gfSelectedPath();
+    size_t width = rowWidth(d);
+    // the division register of every codeword, one row per parity symbol, kept as a ring of rows
+    uint8_t reg[FEC_MAX_PARITY][FEC_MAX_DEPTH];
+    uint8_t feedback[FEC_MAX_DEPTH];
+    memset(reg, 0, sizeof(reg));
+    memset(feedback, 0, sizeof(feedback));
+    int head = 0;
+
+    for (size_t r = 0; r * d < len; r++)
+    {
+        loadRow(feedback, data, len, d, r);
+        for (size_t k = 0; k < d; k++)
+            feedback[k] ^= reg[head][k];
+
+        // shift the register by one symbol, the top row drops out and comes back as the bottom one
+        memset(reg[head], 0, width);
+        head = head + 1 < parity ? head + 1 : 0;
+        for (int j = 0, slot = head; j < parity; j++, slot = slot + 1 < parity ? slot + 1 : 0)
+            gfMulAddPath(path, reg[slot], reg[slot], feedback, gen[parity - 1 - j], width);
+    }
+
+    for (int j = 0, slot = head; j < parity; j++, slot = slot + 1 < parity ? slot + 1 : 0)
+        memcpy(out + j * d, reg[slot], d);
+}
+
+// Corrects codeword k from its syndromes; symbols are numbered from the first row, and the one in
+// row `rows - 1` does not exist for the codewords past `shortRow`. Returns the symbols fixed.
+static int correctCodeword(const uint8_t *synd, int parity, size_t rows, size_t k, size_t shortRow,
+    uint8_t *data, uint8_t *check, size_t d)
+{
+    const GF_TABLES &t = gfTables();
+    size_t n = rows + parity;
+
+    // Berlekamp-Massey, the error locator
+    uint8_t lambda[FEC_MAX_PARITY + 1] = { 1 };
+    uint8_t prev[FEC_MAX_PARITY + 1] = { 1 };
+    uint8_t last = 1;
+    int errors = 0, shift = 1;
+    for (int r = 0; r < parity; r++)
+    {
+        uint8_t delta = synd[r];
+        for (int i = 1; i <= errors; i++)
+            delta ^= gfMul(lambda[i], synd[r - i]);
+        if (delta == 0)
+        {
+            shift++;
+            continue;
+        }
+
+        uint8_t scale = gfMul(delta, gfInv(last));
+        uint8_t saved[FEC_MAX_PARITY + 1];
+        memcpy(saved, lambda, sizeof(saved));
+        for (int i = 0; i + shift <= parity; i++)
+            lambda[i + shift] ^= gfMul(scale, prev[i]);
+
+        if (2 * errors <= r)
+        {
+            errors = r + 1 - errors;
+            memcpy(prev, saved, sizeof(prev));
+            last = delta;
+            shift = 1;
+        }
+        else
+        {
+            shift++;
+        }
+    }
+    if (2 * errors > parity)
+        return FEC_UNCORRECTABLE;
+
+    // the error evaluator, S(x) lambda(x) mod x^parity
+    uint8_t omega[FEC_MAX_PARITY];
+    for (int i = 0; i < parity; i++)
+    {
+        omega[i] = 0;
+        for (int j = 0; j <= i && j <= errors; j++)
+            omega[i] ^= gfMul(synd[i - j], lambda[j]);
+    }
+
+    // Chien search over the symbols the codeword has, Forney for the value of each error
+    size_t where[FEC_MAX_PARITY];
+    uint8_t value[FEC_MAX_PARITY];
+    int found = 0;
+
+    // symbol s has degree n - 1 - s and X^-1 = a^-(n - 1 - s), so X^-1 grows by a from one symbol to
+    // the next; term[i] = lambda_i X^-i steps by a^i
+    uint8_t term[FEC_MAX_PARITY + 1];
+    int first = (int) ((FEC_CODEWORD - (n - 1)) % FEC_CODEWORD);
+    for (int i = 0; i <= errors; i++)
+        term[i] = gfMul(lambda[i], t.exp[(first * i) % FEC_CODEWORD]);
+
+    for (size_t s = 0; s < n && found <= errors; s++)
+    {
+        uint8_t sum = term[0], odd = 0;
+        for (int i = 1; i <= errors; i++)
+        {
+            if (s > 0)
+                term[i] = gfMul(term[i], t.exp[i]);
+            sum ^= term[i];
+            if (i & 1)
+                odd ^= term[i];
+        }
+        if (sum != 0)
+            continue;
+
+        // Forney: X omega(X^-1) / lambda'(X^-1), and the odd terms are X^-1 lambda'(X^-1)
+        int power = (int) (n - 1 - s);
+        uint8_t xinv = t.exp[(FEC_CODEWORD - power) % FEC_CODEWORD];
+        uint8_t evaluator = 0;
+        for (int i = parity - 1; i >= 0; i--)
+            evaluator = gfMul(evaluator, xinv) ^ omega[i];
+        if (odd == 0 || found == errors)
+            return FEC_UNCORRECTABLE;
+
+        where[found] = s;
+        value[found] = gfMul(evaluator, gfInv(odd));
+        found++;
+    }
+    if (found != errors)
+        return FEC_UNCORRECTABLE;
+
+    for (int e = 0; e < found; e++)
+    {
+        size_t s = where[e];
+        if (s >= rows)
+        {
+            check[(s - rows) * d + k] ^= value[e];
+            continue;
+        }
+        // the padding zero of a short codeword is known, an error there is a miscorrection
+        if (s == rows - 1 && k >= shortRow)
+            return FEC_UNCORRECTABLE;
+        data[s * d + k] ^= value[e];
+    }
+
+    return found;
+}
+
+int fecDecode(uint8_t *data, size_t len, uint8_t *check, int parity, int depth)
+{
+    size_t d = fecDepth(len, parity, depth);
+    if (d == 0)
+        return 0;
+
+    const GF_TABLES &t = gfTables();
+    int path = gfSelectedPath();
+    size_t width = rowWidth(d);
+    size_t rows = (len + d - 1) / d;
+    // codewords at or past this one have no byte in the last row
+    size_t shortRow = len % d ? len % d : d;
+
+    // every row folded into the syndromes of all codewords, S_i = S_i a^i + row
+    uint8_t synd[FEC_MAX_PARITY][FEC_MAX_DEPTH];
+    uint8_t row[FEC_MAX_DEPTH];
+    memset(synd, 0, sizeof(synd));
+    memset(row, 0, sizeof(row));
+    for (size_t r = 0; r < rows + parity; r++)
+    {
+        if (r < rows)
+            loadRow(row, data, len, d, r);
+        else
+            memcpy(row, check + (r - rows) * d, d);
+
+        for (int i = 0; i < parity; i++)
+            gfMulAddPath(path, synd[i], row, synd[i], t.exp[i], width);
+    }
+
+    // repair each codeword that does not check; when one cannot be, the block is only half repaired
+    int fixed = 0;
+    for (size_t k = 0; k < d; k++)
+    {
+        uint8_t s[FEC_MAX_PARITY];
+        bool clean = true;
+        for (int i = 0; i < parity; i++)
+        {
+            s[i] = synd[i][k];
+            clean = clean && s[i] == 0;
+        }
+        if (clean)
+            continue;
+
+        int n = correctCodeword(s, parity, rows, k, shortRow, data, check, d);
+        if (n == FEC_UNCORRECTABLE)
+            return FEC_UNCORRECTABLE;
+        fixed += n;
+    }
+
+    return fixed;
+}
@@ -0,0 +1,51 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Fec.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and function declarations for the forward error
+-- correction of frames: Reed-Solomon codewords over GF(256), interleaved byte by byte across the
+-- frame, and the Galois field kernels they run on.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef FEC_H
+#define FEC_H
+#include <cstddef>
+#include <cstdint>
+
+// GF(256) with x^8 + x^4 + x^3 + x^2 + 1
+#define GF_POLY             0x11D
+// symbols in a full codeword
+#define FEC_CODEWORD        255
+// most parity symbols per codeword, each pair corrects one bad byte
+#define FEC_MAX_PARITY      64
+// most codewords a frame is spread over
+#define FEC_MAX_DEPTH       32
+// fecDecode() could not repair the block
+#define FEC_UNCORRECTABLE   (-1)
+
+// kernels, in order of preference
+#define GF_SCALAR           0
+#define GF_SSSE3            1
+#define GF_AVX2             2
+#define GF_PATHS            3
+
+// function prototypes
+uint8_t gfMul(uint8_t a, uint8_t b);
+void gfMulAdd(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+void gfMulAddPath(int path, uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+void gfMulAddScalar(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+void gfMulAddSsse3(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+void gfMulAddAvx2(uint8_t *dst, const uint8_t *add, const uint8_t *src, uint8_t c, size_t n);
+bool gfPathSupported(int path);
+int gfSelectedPath();
+const char *gfPathName(int path);
+size_t fecDepth(size_t len, int parity, int depth);
+size_t fecParitySize(size_t len, int parity, int depth);
+void fecEncode(const uint8_t *data, size_t len, int parity, int depth, uint8_t *out);
+int fecDecode(uint8_t *data, size_t len, uint8_t *check, int parity, int depth);
+#endif
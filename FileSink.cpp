@@ -0,0 +1,288 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     FileSink.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  FileSink::FileSink();
+--                  BOOL FileSink::open(LPCSTR path);
+--                  BOOL FileSink::close();
+--                  BOOL FileSink::isOpen() const;
+--                  VOID FileSink::write(const std::string &payload);
+--                  VOID FileSink::sync();
+--                  BOOL FileSink::saveAs(LPCSTR path);
+--                  uint64_t FileSink::bytes() const;
+--                  std::string FileSink::tail() const;
+--                  size_t FileSink::stalls() const;
+--                  DWORD WINAPI FileSink::writeThread(LPVOID param);
+--                  BOOL FileSink::writeBlock(uint64_t block, size_t len);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The received text used to pile up in a vector and in the receive panel, and saving it read the
+-- panel back a line at a time. The sink puts each payload in a file as it is delivered, in
+-- constant memory whatever the size of the transfer.
+--
+-- write() copies the payload into the block being filled, one of SINK_BLOCKS, and never touches the
+-- file. A full block is handed to the writer thread, which writes it whole at its own offset, a
+-- multiple of SINK_BLOCK. sync() hands over the part of the block filled so far; the writer puts it
+-- at the offset of the block, and the whole block goes there again once it is full, so every write
+-- starts on a block boundary. The engine only waits for the disk when every block is full.
+--
+-- The last SINK_TAIL bytes are kept apart for the receive panel, which shows them instead of the
+-- whole transfer.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "FileSink.h"
+#include "Common.h"
+using namespace std;
+
+FileSink::FileSink()
+    : hFile(INVALID_HANDLE_VALUE), hThread(NULL), hWork(CreateEvent(NULL, FALSE, FALSE, NULL)),
+      hSpace(CreateEvent(NULL, FALSE, FALSE, NULL)), hTail_Lock(CreateMutex(NULL, FALSE, NULL)), blocks(NULL),
+      delivered(0), filled(0), written(0), synced(0), onDisk(0), stopping(FALSE), failed(FALSE), waits(0)
+{
+}
+
+FileSink::~FileSink()
+{
+    close();
+}
+
+BOOL FileSink::open(LPCSTR path)
+{
+    close();
+    delivered = 0;
+    filled = 0;
+    written = 0;
+    synced = 0;
+    onDisk = 0;
+    stopping = FALSE;
+    failed = FALSE;
+    waits = 0;
+
+    // nothing to write to, the payloads are only counted
+    if (!path)
+        return TRUE;
+
+    try {
+        hFile = CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return FALSE;
+
+        this->path = path;
+        blocks = new char[(size_t) SINK_BLOCKS * SINK_BLOCK];
+        if ((hThread = CreateThread(NULL, 0, writeThread, this, 0, NULL)) == NULL)
+        {
+            close();
+            return FALSE;
+        }
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+        close();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL FileSink::close()
+{
+    if (hThread)
+    {
+        // the engine is done, the writer puts the rest on disk and stops
+        sync();
+        stopping = TRUE;
+        SetEvent(hWork);
+        WaitForSingleObject(hThread, INFINITE);
+        CloseHandle(hThread);
+        hThread = NULL;
+    }
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(hFile);
+        hFile = INVALID_HANDLE_VALUE;
+    }
+    delete[] blocks;
+    blocks = NULL;
+
+    return !failed;
+}
+
+BOOL FileSink::isOpen() const
+{
+    return hFile != INVALID_HANDLE_VALUE;
+}
+
+VOID FileSink::write(const string &payload)
+{
+    uint64_t pos = delivered.load(memory_order_relaxed);
+    const char *p = payload.data();
+    size_t left = payload.size();
+
+    while (hThread && left > 0)
+    {
+        uint64_t block = pos / SINK_BLOCK;
+        // the block takes the place of one the writer may still be on
+        while (block - written.load(memory_order_acquire) >= SINK_BLOCKS && !failed)
+        {
+            waits.fetch_add(1, memory_order_relaxed);
+            SetEvent(hWork);
+            WaitForSingleObject(hSpace, INFINITE);
+        }
+
+        size_t offset = (size_t) (pos % SINK_BLOCK);
+        size_t n = min<size_t>(SINK_BLOCK - offset, left);
+        memcpy(blocks + (size_t) (block % SINK_BLOCKS) * SINK_BLOCK + offset, p, n);
+        p += n;
+        left -= n;
+        pos += n;
+        if (pos % SINK_BLOCK == 0)
+        {
+            filled.store(block + 1, memory_order_release);
+            SetEvent(hWork);
+        }
+    }
+
+    // the tail the panel shows, by position in the transfer
+    WaitForSingleObject(hTail_Lock, INFINITE);
+    uint64_t end = delivered.load(memory_order_relaxed) + payload.size();
+    size_t keep = min<size_t>(payload.size(), SINK_TAIL);
+    for (size_t i = payload.size() - keep; i < payload.size(); i++)
+        tailRing[(end - payload.size() + i) % SINK_TAIL] = payload[i];
+    delivered.store(end, memory_order_release);
+    ReleaseMutex(hTail_Lock);
+}
+
+VOID FileSink::sync()
+{
+    if (!hThread)
+        return;
+
+    synced.store(delivered.load(memory_order_relaxed), memory_order_release);
+    SetEvent(hWork);
+}
+
+BOOL FileSink::saveAs(LPCSTR target)
+{
+    if (!hThread)
+        return FALSE;
+
+    // wait for the writer to catch up with the last sync
+    uint64_t size = synced.load(memory_order_acquire);
+    while (onDisk.load(memory_order_acquire) < size && !failed)
+        Sleep(1);
+    if (failed)
+        return FALSE;
+
+    HANDLE in = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (in == INVALID_HANDLE_VALUE)
+        return FALSE;
+    HANDLE out = CreateFile(target, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (out == INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(in);
+        return FALSE;
+    }
+
+    // a block at a time, the file may be larger than memory
+    vector<char> buffer(SINK_BLOCK);
+    BOOL ok = TRUE;
+    for (uint64_t copied = 0; ok && copied < size; )
+    {
+        DWORD n = (DWORD) min<uint64_t>(SINK_BLOCK, size - copied), got = 0, put = 0;
+        ok = ReadFile(in, &buffer[0], n, &got, NULL) && got == n &&
+            WriteFile(out, &buffer[0], n, &put, NULL) && put == n;
+        copied += n;
+    }
+
+    CloseHandle(in);
+    CloseHandle(out);
+    return ok;
+}
+
+uint64_t FileSink::bytes() const
+{
+    return delivered.load(memory_order_acquire);
+}
+
+string FileSink::tail() const
+{
+    string text;
+
+    WaitForSingleObject(hTail_Lock, INFINITE);
+    uint64_t end = delivered.load(memory_order_relaxed);
+    for (uint64_t i = end - min<uint64_t>(end, SINK_TAIL); i < end; i++)
+        text += tailRing[i % SINK_TAIL];
+    ReleaseMutex(hTail_Lock);
+
+    return text;
+}
+
+size_t FileSink::stalls() const
+{
+    return waits.load(memory_order_relaxed);
+}
+
+DWORD WINAPI FileSink::writeThread(LPVOID param)
+{
+    FileSink *sink = (FileSink *) param;
+
+    for (;;)
+    {
+        WaitForSingleObject(sink->hWork, INFINITE);
+        BOOL stop = sink->stopping;
+
+        // whole blocks first, a block is free again once it is on disk
+        uint64_t block = sink->written.load(memory_order_relaxed);
+        while (block < sink->filled.load(memory_order_acquire) && !sink->failed)
+        {
+            sink->writeBlock(block, SINK_BLOCK);
+            sink->written.store(++block, memory_order_release);
+            sink->onDisk.store(max<uint64_t>(sink->onDisk, block * SINK_BLOCK), memory_order_release);
+            SetEvent(sink->hSpace);
+        }
+
+        // then what sync() handed over of the block being filled; the engine only appends to it, and
+        // does not reuse it before it is written whole
+        uint64_t synced = sink->synced.load(memory_order_acquire);
+        if (synced > block * SINK_BLOCK && synced > sink->onDisk && !sink->failed)
+        {
+            // the block may have filled up since, the next pass writes it as a whole block
+            size_t len = (size_t) min<uint64_t>(synced - block * SINK_BLOCK, SINK_BLOCK);
+            sink->writeBlock(block, len);
+            sink->onDisk.store(block * SINK_BLOCK + len, memory_order_release);
+        }
+
+        if (stop || sink->failed)
+            break;
+    }
+
+    // an engine waiting for space gives up on a failed disk
+    SetEvent(sink->hSpace);
+    return 0;
+}
+
+BOOL FileSink::writeBlock(uint64_t block, size_t len)
+{
+    OVERLAPPED ov = {};
+    uint64_t offset = block * SINK_BLOCK;
+    DWORD n = 0;
+
+    // a file opened without FILE_FLAG_OVERLAPPED is written at the offset, and at once
+    ov.Offset = (DWORD) offset;
+    ov.OffsetHigh = (DWORD) (offset >> 32);
+    if (!WriteFile(hFile, blocks + (size_t) (block % SINK_BLOCKS) * SINK_BLOCK, (DWORD) len, &n, &ov) || n != len)
+    {
+        failed = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
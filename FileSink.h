@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     FileSink.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declaration for the receive sink, which
+-- streams the payloads the receiver delivers into a file.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef FILE_SINK_H
+#define FILE_SINK_H
+#include "Platform.h"
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+// Bytes per write; every block starts at a multiple of this in the file
+#define SINK_BLOCK          (64 * 1024)
+// Blocks the engine fills while the writer thread puts others on disk
+#define SINK_BLOCKS         4
+// Latest bytes kept for the receive panel
+#define SINK_TAIL           4096
+// Where the dialog receives to until the data is saved
+#define SINK_SPOOL          "rmreceived.tmp"
+
+// Payloads delivered by the receiver, written to a file by a thread of the sink. Only the engine
+// thread writes; the dialog or the driver opens, saves, closes and reads the tail.
+class FileSink {
+public:
+    FileSink();
+    ~FileSink();
+
+    // NULL only counts what is delivered
+    BOOL        open(LPCSTR path);
+    // waits for the writer, FALSE when a write failed
+    BOOL        close();
+    BOOL        isOpen() const;
+    VOID        write(const std::string &payload);
+    // puts what has been written so far on its way to the file, the engine calls it after a burst
+    VOID        sync();
+    // a copy of what the file holds as of the last sync()
+    BOOL        saveAs(LPCSTR path);
+    uint64_t    bytes() const;
+    std::string tail() const;
+    // times the engine waited for the writer with every block full
+    size_t      stalls() const;
+
+private:
+    static DWORD WINAPI writeThread(LPVOID param);
+    BOOL        writeBlock(uint64_t block, size_t len);
+
+    HANDLE                  hFile;
+    HANDLE                  hThread;
+    HANDLE                  hWork;          // set when there is something for the writer
+    HANDLE                  hSpace;         // set when the writer frees a block
+    HANDLE                  hTail_Lock;
+    std::string             path;
+    char                    *blocks;        // SINK_BLOCKS blocks of SINK_BLOCK bytes
+    std::atomic<uint64_t>   delivered;      // bytes given to write()
+    std::atomic<uint64_t>   filled;         // blocks the engine is done with
+    std::atomic<uint64_t>   written;        // blocks on disk
+    std::atomic<uint64_t>   synced;         // bytes handed over by sync()
+    std::atomic<uint64_t>   onDisk;         // bytes the writer has put in the file
+    std::atomic<BOOL>       stopping;
+    std::atomic<BOOL>       failed;
+    std::atomic<size_t>     waits;
+    char                    tailRing[SINK_TAIL];
+};
+#endif
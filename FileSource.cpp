@@ -0,0 +1,187 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     FileSource.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  FileSource::FileSource();
+--                  BOOL FileSource::open(LPCSTR path);
+--                  VOID FileSource::close();
+--                  BOOL FileSource::next(std::string &payload, size_t maxSize, BYTE mode);
+--                  BOOL FileSource::cut(uint64_t offset, size_t len, std::string &payload, size_t maxSize, BYTE mode,
+--                                       size_t *taken);
+--                  VOID FileSource::rewind();
+--                  std::string FileSource::preview(size_t len);
+--                  const char *FileSource::map(uint64_t offset, size_t len);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- A loaded file no longer goes through the send panel. It is mapped read only, one window of
+-- FILE_VIEW_SIZE bytes at a time, and next() cuts payloads straight out of the mapping, so the
+-- first frame can go out as soon as the file is opened and memory stays bounded whatever the
+-- size of the file. The panel only gets a preview of the first few kilobytes.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "FileSource.h"
+#include "Common.h"
+using namespace std;
+
+FileSource::FileSource()
+    : hFile(INVALID_HANDLE_VALUE), hMapping(NULL), view(NULL), viewOffset(0), viewSize(0),
+      fileSize(0), pos(0)
+{
+}
+
+FileSource::~FileSource()
+{
+    close();
+}
+
+BOOL FileSource::open(LPCSTR path)
+{
+    close();
+
+    try {
+        hFile = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return FALSE;
+
+        LARGE_INTEGER li;
+        if (!GetFileSizeEx(hFile, &li))
+        {
+            close();
+            return FALSE;
+        }
+        fileSize = (uint64_t) li.QuadPart;
+
+        // an empty file cannot be mapped, there is nothing to send either
+        if (fileSize > 0 && (hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL)
+        {
+            close();
+            return FALSE;
+        }
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+        close();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+VOID FileSource::close()
+{
+    if (view)
+        UnmapViewOfFile(view);
+    if (hMapping)
+        CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+
+    hFile = INVALID_HANDLE_VALUE;
+    hMapping = NULL;
+    view = NULL;
+    viewOffset = viewSize = 0;
+    fileSize = pos = 0;
+}
+
+BOOL FileSource::isOpen() const
+{
+    return hFile != INVALID_HANDLE_VALUE;
+}
+
+BOOL FileSource::next(string &payload, size_t maxSize, BYTE mode)
+{
+    if (pos >= fileSize)
+        return FALSE;
+
+    size_t taken;
+    if (!cut(pos, (size_t) min<uint64_t>(fileSize - pos, COMPRESS_MAX_RAW), payload, maxSize, mode, &taken))
+        return FALSE;
+
+    pos += taken;
+    return TRUE;
+}
+
+BOOL FileSource::cut(uint64_t offset, size_t len, string &payload, size_t maxSize, BYTE mode, size_t *taken)
+{
+    if (offset >= fileSize || len == 0)
+        return FALSE;
+
+    // a compressed block may take in up to COMPRESS_MAX_RAW bytes of the file
+    size_t want = (size_t) min<uint64_t>(min<uint64_t>(fileSize - offset, len),
+        mode == COMPRESS_NONE ? maxSize : COMPRESS_MAX_RAW);
+    const char *data = map(offset, want);
+    if (!data)
+        return FALSE;
+
+    *taken = want;
+    if (mode == COMPRESS_NONE)
+        payload.assign(data, want);
+    else
+        payload = compressNext(data, want, maxSize, mode, taken);
+    return TRUE;
+}
+
+VOID FileSource::rewind()
+{
+    pos = 0;
+}
+
+string FileSource::preview(size_t len)
+{
+    len = (size_t) min<uint64_t>(len, fileSize);
+    const char *data = len ? map(0, len) : NULL;
+    return data ? string(data, len) : string();
+}
+
+uint64_t FileSource::size() const
+{
+    return fileSize;
+}
+
+uint64_t FileSource::position() const
+{
+    return pos;
+}
+
+const char *FileSource::map(uint64_t offset, size_t len)
+{
+    // still inside the current window
+    if (view && offset >= viewOffset && offset + len <= viewOffset + viewSize)
+        return view + (offset - viewOffset);
+
+    try {
+        // views have to start on the allocation granularity
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        uint64_t start = offset - offset % si.dwAllocationGranularity;
+        size_t span = (size_t) min<uint64_t>(fileSize - start,
+            max<uint64_t>(FILE_VIEW_SIZE, offset - start + len));
+
+        if (view)
+            UnmapViewOfFile(view);
+        view = (const char*) MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(start >> 32),
+            (DWORD)(start & 0xFFFFFFFF), span);
+        if (!view)
+        {
+            viewSize = 0;
+            return NULL;
+        }
+
+        viewOffset = start;
+        viewSize = span;
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+        return NULL;
+    }
+
+    return view + (offset - viewOffset);
+}
@@ -0,0 +1,54 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     FileSource.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declaration for the transfer source
+-- that feeds a file straight from a memory mapping into the packetizer.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef FILE_SOURCE_H
+#define FILE_SOURCE_H
+#include "Platform.h"
+#include <string>
+#include <cstdint>
+
+// Bytes of the file mapped at a time, whatever the size of the file
+#define FILE_VIEW_SIZE      (1 << 20)
+// Bytes shown in the send panel for a loaded file
+#define FILE_PREVIEW_SIZE   4096
+
+class FileSource {
+public:
+    FileSource();
+    ~FileSource();
+
+    BOOL        open(LPCSTR path);
+    VOID        close();
+    BOOL        isOpen() const;
+    // next payload of at most maxSize bytes, compressed when mode asks for it; FALSE at the end
+    BOOL        next(std::string &payload, size_t maxSize, BYTE mode);
+    // the same from up to len bytes at offset, wherever next() is; taken says how many went in
+    BOOL        cut(uint64_t offset, size_t len, std::string &payload, size_t maxSize, BYTE mode, size_t *taken);
+    VOID        rewind();
+    std::string preview(size_t len);
+    uint64_t    size() const;
+    uint64_t    position() const;
+
+private:
+    // makes [offset, offset + len) readable, returns a pointer to offset
+    const char  *map(uint64_t offset, size_t len);
+
+    HANDLE      hFile;
+    HANDLE      hMapping;
+    const char  *view;
+    uint64_t    viewOffset;
+    size_t      viewSize;
+    uint64_t    fileSize;
+    uint64_t    pos;
+};
+#endif
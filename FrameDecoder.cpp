@@ -0,0 +1,157 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     FrameDecoder.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  FrameDecoder::FrameDecoder(RingBuffer &ring);
+--                  int FrameDecoder::next(FRAME_VIEW *frame);
+--                  void FrameDecoder::release(const FRAME_VIEW &frame);
+--                  void FrameDecoder::skip();
+--                  bool FrameDecoder::repair(FRAME_VIEW *frame, size_t covered, size_t check);
+--                  void FrameDecoder::reset();
+--                  size_t framePayloadCopy(const FRAME_VIEW &frame, std::string &out);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Incremental frame decoder. next() drops line noise up to the next SYN, reads the length field,
+-- waits until the whole frame is buffered, and checks its CRC directly on the ring. The returned
+-- FRAME_VIEW only points into the ring; nothing is copied until the consumer asks for the payload
+-- with framePayloadCopy(). A length above PACKET_DATA_MAX cannot start a frame, so only that SYN
+-- is dropped. Neither SYN nor LEN are checked before the CRC, so a frame that fails its CRC may have
+-- been a SYN inside a payload or a corrupted length: it gives up only its SYN, and the hunt goes on
+-- from the next byte, where the frames it would have swallowed still are. When the line goes quiet
+-- before a frame is complete, the reader drops its SYN with skip() the same way.
+--
+-- On a link with FEC, check bytes follow the CRC. A frame that passes its CRC never touches them. One
+-- that fails it is copied out, corrected, and written back into the ring only when the CRC agrees
+-- with the corrected bytes. The length has to come through the FEC unchanged, since the frame was
+-- cut at the length it had on arrival; a bad SYN or length still loses the frame.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "FrameDecoder.h"
+#include "Common.h"
+#include "LinkSession.h"
+using namespace std;
+
+FrameDecoder::FrameDecoder(RingBuffer &ring)
+    : framesDecoded(0), crcErrors(0), bytesSkipped(0), fecFrames(0), fecBytes(0), fecFailed(0), ring(ring)
+{
+}
+
+int FrameDecoder::next(FRAME_VIEW *frame)
+{
+    size_t len;
+
+    for (;;)
+    {
+        // hunt for the start of a frame
+        size_t sync = ring.find(SYN);
+        if (sync > 0)
+        {
+            ring.consume(sync);
+            bytesSkipped += sync;
+        }
+
+        if (ring.size() < PACKET_HEADER_SIZE)
+            return DECODE_NEED_MORE;
+
+        len = (ring.at(PACKET_LEN_INDEX) << 8) | ring.at(PACKET_LEN_INDEX + 1);
+        if (len <= PACKET_DATA_MAX)
+            break;
+
+        // a SYN inside noise or a payload, look for the next one
+        ring.consume(1);
+        bytesSkipped++;
+    }
+
+    // the FEC, when there is one, covers everything between SYN and the end of the CRC
+    size_t covered = PACKET_OVERHEAD - PACKET_SEQ_INDEX + len;
+    size_t check = fecParitySize(covered, session->linkParams.fecParity, session->linkParams.fecDepth);
+    size_t size = PACKET_OVERHEAD + len + check;
+    if (ring.size() < size)
+        return DECODE_NEED_MORE;
+
+    frame->seq = ring.at(PACKET_SEQ_INDEX);
+    frame->flags = ring.at(PACKET_FLAGS_INDEX);
+    frame->header = ring.span(0, PACKET_DATA_INDEX);
+    frame->payload = ring.span(PACKET_DATA_INDEX, len);
+    frame->crc = (uint16_t)((ring.at(PACKET_DATA_INDEX + len) << 8) | ring.at(PACKET_DATA_INDEX + len + 1));
+    frame->length = size;
+    frame->valid = false;
+
+    // the CRC covers everything between SYN and the CRC itself
+    RING_SPAN span = ring.span(PACKET_SEQ_INDEX, covered - 2);
+    uint16_t crc = crc16Update(crc16Update(CRC16_INIT, span.p1, span.n1), span.p2, span.n2);
+    if (crc != frame->crc && !(check > 0 && repair(frame, covered, check)))
+    {
+        crcErrors++;
+        return DECODE_CORRUPT;
+    }
+
+    frame->valid = true;
+    framesDecoded++;
+    return DECODE_FRAME;
+}
+
+bool FrameDecoder::repair(FRAME_VIEW *frame, size_t covered, size_t check)
+{
+    block.resize(covered + check);
+    spanCopy(ring.span(PACKET_SEQ_INDEX, covered + check), block.data());
+
+    // the block starts at SEQ, one byte into the frame
+    const uint8_t *b = block.data();
+    int fixed = fecDecode(block.data(), covered, block.data() + covered, session->linkParams.fecParity,
+        session->linkParams.fecDepth);
+    size_t len = (b[PACKET_LEN_INDEX - PACKET_SEQ_INDEX] << 8) | b[PACKET_LEN_INDEX + 1 - PACKET_SEQ_INDEX];
+    uint16_t crc = (uint16_t)((b[covered - 2] << 8) | b[covered - 1]);
+    // nothing to fix means the errors were past what the check bytes can see
+    if (fixed <= 0 || len != frame->payload.size() || crc16(b, covered - 2) != crc)
+    {
+        fecFailed++;
+        return false;
+    }
+
+    ring.store(PACKET_SEQ_INDEX, b, covered);
+    frame->seq = b[0];
+    frame->flags = b[PACKET_FLAGS_INDEX - PACKET_SEQ_INDEX];
+    frame->crc = crc;
+    fecFrames++;
+    fecBytes += fixed;
+    return true;
+}
+
+void FrameDecoder::release(const FRAME_VIEW &frame)
+{
+    // the SYN and LEN of a frame that failed its CRC may have been false
+    if (frame.valid)
+        ring.consume(frame.length);
+    else
+        skip();
+}
+
+void FrameDecoder::skip()
+{
+    if (ring.size() > 0)
+    {
+        ring.consume(1);
+        bytesSkipped++;
+    }
+}
+
+void FrameDecoder::reset()
+{
+    ring.clear();
+}
+
+size_t framePayloadCopy(const FRAME_VIEW &frame, string &out)
+{
+    // the payload is exactly LEN bytes, every byte value is data
+    out.clear();
+    spanAppend(frame.payload, out);
+    return out.length();
+}
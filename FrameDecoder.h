@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     FrameDecoder.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the declarations for the incremental frame decoder that runs over the
+-- receive ring and hands out views of complete, CRC-checked frames.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+#include "RingBuffer.h"
+
+// results of FrameDecoder::next()
+#define DECODE_NEED_MORE    0
+#define DECODE_FRAME        1
+#define DECODE_CORRUPT      2
+
+// A decoded frame; the views stay valid until the frame is released
+struct FRAME_VIEW {
+    uint8_t     seq;
+    uint8_t     flags;
+    RING_SPAN   header;
+    RING_SPAN   payload;
+    uint16_t    crc;
+    // bytes the frame occupies on the line
+    size_t      length;
+    // the CRC checked out; release() only takes the SYN of a frame that failed it
+    bool        valid;
+};
+
+class FrameDecoder {
+public:
+    explicit FrameDecoder(RingBuffer &ring);
+
+    int     next(FRAME_VIEW *frame);
+    void    release(const FRAME_VIEW &frame);
+    // drops the SYN of a frame that will not be completed
+    void    skip();
+    void    reset();
+
+    // counters
+    size_t  framesDecoded;
+    size_t  crcErrors;
+    size_t  bytesSkipped;
+    // frames the FEC repaired, the bytes it fixed in them, and the frames it could not repair
+    size_t  fecFrames;
+    size_t  fecBytes;
+    size_t  fecFailed;
+
+private:
+    bool    repair(FRAME_VIEW *frame, size_t covered, size_t check);
+
+    RingBuffer  &ring;
+    std::vector<uint8_t>    block;
+};
+
+// function prototypes
+size_t framePayloadCopy(const FRAME_VIEW &frame, std::string &out);
+#endif
@@ -0,0 +1,213 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     FrameQueue.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  FrameQueue::FrameQueue(size_t capacity);
+--                  BOOL FrameQueue::open();
+--                  BOOL FrameQueue::push(std::string &payload);
+--                  VOID FrameQueue::finish();
+--                  BOOL FrameQueue::pop(std::string &payload);
+--                  BOOL FrameQueue::tryPop(std::string &payload);
+--                  VOID FrameQueue::close();
+--                  VOID FrameQueue::cancel();
+--                  BOOL FrameQueue::isCancelled() const;
+--                  BOOL FrameQueue::isFinished() const;
+--                  size_t FrameQueue::depth() const;
+--                  FRAME_QUEUE_METRICS FrameQueue::metrics() const;
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Single producer, single consumer ring of payloads. The producer only moves head and the consumer
+-- only moves tail, so neither takes a lock; a payload is swapped in and out of its slot, never
+-- copied. A full queue holds the producer back until the engine takes a payload, an empty one
+-- holds the engine until the next payload is cut. A side only sleeps after saying so, and the
+-- other side only signals then, so a queue that keeps moving makes no system calls. A consumer that
+-- must not be held, like the engine in the middle of a send, takes what is there with tryPop().
+--
+-- One send uses the queue at a time: open() claims it, and it is free again once the producer
+-- called finish() and the consumer close().
+----------------------------------------------------------------------------------------------------------------------*/
+#include "FrameQueue.h"
+using namespace std;
+
+// producer and consumer, each lets go of the queue once
+#define FRAME_QUEUE_SIDES   2
+
+static size_t roundUpPow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+FrameQueue::FrameQueue(size_t capacity)
+    : slots(roundUpPow2(capacity)), mask(roundUpPow2(capacity) - 1), head(0), tail(0), users(0),
+      finished(FALSE), cancelled(FALSE), producerWaiting(FALSE), consumerWaiting(FALSE),
+      consumerEmpty(FALSE),
+      hSpace(CreateEvent(NULL, FALSE, FALSE, NULL)), hData(CreateEvent(NULL, FALSE, FALSE, NULL)),
+      maxDepth(0), fullStalls(0), emptyStalls(0)
+{
+}
+
+FrameQueue::~FrameQueue()
+{
+    CloseHandle(hSpace);
+    CloseHandle(hData);
+}
+
+BOOL FrameQueue::open()
+{
+    int idle = 0;
+    if (!users.compare_exchange_strong(idle, FRAME_QUEUE_SIDES))
+        return FALSE;
+
+    // nobody else looks at the queue until the producer pushes
+    for (auto &slot : slots)
+        slot.clear();
+    head = tail = 0;
+    finished = cancelled = FALSE;
+    consumerEmpty = FALSE;
+    maxDepth = fullStalls = emptyStalls = 0;
+    return TRUE;
+}
+
+BOOL FrameQueue::push(string &payload)
+{
+    size_t h = head.load(memory_order_relaxed);
+    BOOL stalled = FALSE;
+
+    while (h - tail.load(memory_order_acquire) > mask)
+    {
+        if (cancelled)
+            return FALSE;
+        if (!stalled)
+        {
+            fullStalls++;
+            stalled = TRUE;
+        }
+
+        // look again after saying we sleep, a pop in between would not signal
+        producerWaiting = TRUE;
+        if (h - tail.load() > mask && !cancelled)
+            WaitForSingleObject(hSpace, FRAME_QUEUE_WAIT);
+        producerWaiting = FALSE;
+    }
+    if (cancelled)
+        return FALSE;
+
+    slots[h & mask].swap(payload);
+    payload.clear();
+    head.store(h + 1, memory_order_release);
+
+    size_t waiting = h + 1 - tail.load(memory_order_relaxed);
+    if (waiting > maxDepth.load(memory_order_relaxed))
+        maxDepth.store(waiting, memory_order_relaxed);
+    if (consumerWaiting)
+        SetEvent(hData);
+    return TRUE;
+}
+
+VOID FrameQueue::finish()
+{
+    finished = TRUE;
+    SetEvent(hData);
+    users--;
+}
+
+BOOL FrameQueue::pop(string &payload)
+{
+    size_t t = tail.load(memory_order_relaxed);
+    BOOL stalled = FALSE;
+
+    while (head.load(memory_order_acquire) == t)
+    {
+        // the last push comes before finish(), so finished and still empty is the end
+        if (cancelled || (finished && head.load(memory_order_acquire) == t))
+            return FALSE;
+        if (!stalled)
+        {
+            emptyStalls++;
+            stalled = TRUE;
+        }
+
+        consumerWaiting = TRUE;
+        if (head.load() == t && !finished && !cancelled)
+            WaitForSingleObject(hData, FRAME_QUEUE_WAIT);
+        consumerWaiting = FALSE;
+    }
+
+    return tryPop(payload);
+}
+
+BOOL FrameQueue::tryPop(string &payload)
+{
+    size_t t = tail.load(memory_order_relaxed);
+
+    if (cancelled)
+        return FALSE;
+    if (head.load(memory_order_acquire) == t)
+    {
+        // a stretch of tries on an empty queue is one stall, as one wait in pop() is
+        if (!consumerEmpty && !finished)
+            emptyStalls++;
+        consumerEmpty = TRUE;
+        return FALSE;
+    }
+    consumerEmpty = FALSE;
+
+    payload.swap(slots[t & mask]);
+    slots[t & mask].clear();
+    tail.store(t + 1, memory_order_release);
+
+    if (producerWaiting)
+        SetEvent(hSpace);
+    return TRUE;
+}
+
+VOID FrameQueue::close()
+{
+    // a producer still cutting stops at its next push
+    cancel();
+    users--;
+}
+
+VOID FrameQueue::cancel()
+{
+    cancelled = TRUE;
+    SetEvent(hSpace);
+    SetEvent(hData);
+}
+
+BOOL FrameQueue::isCancelled() const
+{
+    return cancelled;
+}
+
+BOOL FrameQueue::isFinished() const
+{
+    return finished;
+}
+
+size_t FrameQueue::depth() const
+{
+    return head.load(memory_order_acquire) - tail.load(memory_order_acquire);
+}
+
+FRAME_QUEUE_METRICS FrameQueue::metrics() const
+{
+    FRAME_QUEUE_METRICS m;
+    m.popped = tail;
+    m.pushed = head;
+    m.maxDepth = maxDepth;
+    m.fullStalls = fullStalls;
+    m.emptyStalls = emptyStalls;
+    return m;
+}
@@ -0,0 +1,81 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     FrameQueue.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the declarations for the bounded queue of payloads between the
+-- packetizer thread, which cuts them, and the protocol engine, which frames and sends them.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+#include "Platform.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Payloads cut ahead of the window, rounded up to a power of two
+#define FRAME_QUEUE_DEPTH   64
+// Longest a full or empty queue sleeps before it looks again, in case a wake went missing
+#define FRAME_QUEUE_WAIT    50
+
+// Queue counters, read from either side while the queue is in use
+struct FRAME_QUEUE_METRICS {
+    size_t pushed;
+    size_t popped;
+    size_t maxDepth;        // most payloads waiting at once
+    size_t fullStalls;      // times the packetizer waited for room
+    size_t emptyStalls;     // times the engine waited for a payload
+};
+
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacity);
+    ~FrameQueue();
+
+    // producer side: claims a free queue, adds payloads, then says there are no more; push() holds
+    // the producer while the queue is full and fails once it is cancelled
+    BOOL    open();
+    BOOL    push(std::string &payload);
+    VOID    finish();
+
+    // consumer side: FALSE once the producer finished and everything was taken, or on cancel();
+    // tryPop() never waits, it is FALSE too while the queue is empty
+    BOOL    pop(std::string &payload);
+    BOOL    tryPop(std::string &payload);
+    // hands the queue back for the next open(), whatever is still in it
+    VOID    close();
+
+    // either side: the producer stops at its next push(), the consumer at its next pop()
+    VOID    cancel();
+    BOOL    isCancelled() const;
+    BOOL    isFinished() const;
+    size_t  depth() const;
+    FRAME_QUEUE_METRICS metrics() const;
+
+private:
+    std::vector<std::string>    slots;
+    size_t                      mask;
+    // running counts, the slot is count & mask; head only moves on push(), tail on pop()
+    std::atomic<size_t>         head;
+    std::atomic<size_t>         tail;
+    // sides that have not let go yet, 0 when the queue is free
+    std::atomic<int>            users;
+    std::atomic<BOOL>           finished;
+    std::atomic<BOOL>           cancelled;
+    // set by a side about to sleep, so the other only signals when someone is asleep
+    std::atomic<BOOL>           producerWaiting;
+    std::atomic<BOOL>           consumerWaiting;
+    // the consumer found the queue empty last time it tried, only moved by the consumer
+    BOOL                        consumerEmpty;
+    HANDLE                      hSpace;
+    HANDLE                      hData;
+    std::atomic<size_t>         maxDepth;
+    std::atomic<size_t>         fullStalls;
+    std::atomic<size_t>         emptyStalls;
+};
+#endif
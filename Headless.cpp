@@ -0,0 +1,824 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Headless.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  int main(int argc, char **argv);
+--                  BOOL parseOptions(int argc, char **argv, HEADLESS_OPTIONS *options);
+--                  VOID printUsage(const char *program);
+--                  int runTransfer(HEADLESS_OPTIONS &options, TRANSFER_RESULT *result);
+--                  int runBonded(HEADLESS_OPTIONS &options);
+--                  BOOL waitForLink(DWORD msec);
+--                  uint64_t sendFiles(const HEADLESS_OPTIONS &options, BOOL *ok);
+--                  DWORD receiveFrames(const HEADLESS_OPTIONS &options, DWORD start);
+--                  uint64_t saveReceived(const HEADLESS_OPTIONS &options, BOOL *ok);
+--                  BOOL saveSizeTrace(const std::string &path, DWORD start);
+--                  BOOL saveLatency(const std::string &path, const std::string &port, BOOL append);
+--                  VOID startExport(const HEADLESS_OPTIONS &options, DWORD start);
+--                  VOID stopExport();
+--                  DWORD WINAPI exportStats(LPVOID param);
+--                  std::string formatStats(const HEADLESS_OPTIONS &options, DWORD elapsed, uint64_t bytesSent,
+--                                          uint64_t bytesReceived);
+--                  std::string formatFields(const std::vector<std::pair<std::string, std::string>> &fields,
+--                                           BOOL csv);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Command line driver for unattended runs. It takes the port, the line settings and the files to send
+-- or receive as arguments and runs the same engine thread the dialog starts, queueing the link setup
+-- and one send per file for it and waiting for each send to finish.
+--
+-- When the run is over, it prints the FILE_STATISTICS counters and the timing as one JSON object
+-- (or CSV with --csv). The exit code is 0 only when every file got through. --suite runs the
+-- transfer benchmark matrix in TransferBench.cpp instead. With --stats-every, a thread of its own
+-- prints a snapshot of the counters to stderr at that rate while the link runs. --trace dumps the
+-- engine's binary trace when the run is over, --decode-trace prints a dump file as CSV.
+--
+-- The dialog's panels are not there, so the UI calls the engine makes are defined here and do
+-- nothing. It builds on Linux through Platform.h; see README.md. There the port is a TermiosTransport,
+-- and --port pty runs a peer station over a pty pair the same way --sim does over the simulated link.
+-- Each --bond joins the peer by one more simulated link, and the files go across all of them at once
+-- through a LinkBond; the line printed then is for the bond, with the share of every link.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Headless.h"
+#include "TransferBench.h"
+#include "LinkBond.h"
+#include "LinkSession.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+using namespace std;
+
+// no dialog, the engine still refers to its panels
+HWND hwnd;
+HWND hDlg;
+HWND hSendPanel;
+HWND hReadPanel;
+int progressSize;
+
+// the --stats-every thread, and the event that stops it
+HANDLE exportThread;
+HANDLE hExportStop;
+DWORD exportStart;
+
+VOID addLine(const HWND*, string) {}
+string getLine(const HWND*, int, int) { return string(); }
+int getLines(const HWND*) { return 0; }
+VOID clearBox(const HWND*) {}
+VOID setupProgressBar(const HWND*) {}
+VOID updateProgressBar(int) {}
+
+int main(int argc, char **argv)
+{
+    HEADLESS_OPTIONS options;
+    if (!parseOptions(argc, argv, &options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+#ifndef _WIN32
+    platformDebugOutput = options.verbose;
+#endif
+
+    if (options.bench)
+    {
+        fputs(runBenchmarks().c_str(), stdout);
+        return 0;
+    }
+
+    if (!options.decodeFile.empty())
+    {
+        string csv;
+        BOOL ok = decodeTrace(options.decodeFile.c_str(), csv);
+        fputs(csv.c_str(), stdout);
+        if (!ok)
+            fprintf(stderr, "%s is not a whole trace\n", options.decodeFile.c_str());
+        return ok ? 0 : 1;
+    }
+
+    if (options.suite)
+    {
+#ifndef _WIN32
+        return runSuite(options);
+#else
+        fprintf(stderr, "--suite is not available on Windows\n");
+        return 2;
+#endif
+    }
+
+    if (!options.bond.empty())
+    {
+#ifndef _WIN32
+        int code = runBonded(options);
+        if (code == 2)
+            printUsage(argv[0]);
+        return code;
+#else
+        fprintf(stderr, "--bond is not available on Windows\n");
+        return 2;
+#endif
+    }
+
+    TRANSFER_RESULT result;
+    int code = runTransfer(options, &result);
+    if (code == 2)
+    {
+        printUsage(argv[0]);
+        return code;
+    }
+    // nothing to report when the link never came up
+    if (session->linkReady)
+        fputs(formatStats(options, result.elapsed, result.bytesSent, result.bytesReceived).c_str(), stdout);
+    return code;
+}
+
+int runTransfer(HEADLESS_OPTIONS &options, TRANSFER_RESULT *result)
+{
+    result->elapsed = 0;
+    result->bytesSent = 0;
+    result->bytesReceived = 0;
+    result->peer = FALSE;
+
+    int peer = 0;
+    BOOL pty = options.sim.empty() && options.port == PTY_PORT;
+    if (!options.sim.empty() || pty)
+    {
+#ifndef _WIN32
+        // the forked peer receives whatever this station sends
+        SIM_PARAMS sim;
+        if (!pty && !parseSimSpec(options.sim.c_str(), &sim))
+            return 2;
+        if ((peer = pty ? ptyFork() : simFork(sim)) < 0)
+        {
+            fprintf(stderr, "cannot start the %s peer\n", pty ? "pty" : "simulated");
+            return 1;
+        }
+        options.port = string(pty ? "pty:" : "sim:") + (peer ? "0" : "1");
+        if (peer == 0)
+            options.sendFiles.clear();
+        else
+            options.recvFile.clear();
+        options.receive = peer == 0;
+        result->peer = peer == 0;
+#else
+        fprintf(stderr, "--sim and --port pty are not available on Windows\n");
+        return 2;
+#endif
+    }
+    else
+    {
+#ifndef _WIN32
+        // a port on Linux goes through termios and epoll, not the emulated Win32 calls
+        TermiosTransport *port = openTermios(options.port.c_str());
+        if (!port)
+        {
+            fprintf(stderr, "cannot open %s\n", options.port.c_str());
+            return 1;
+        }
+        session->transport = port;
+        if (!options.line.empty() && !port->configure(options.line.c_str()))
+        {
+            fprintf(stderr, "bad line settings \"%s\"\n", options.line.c_str());
+            return 1;
+        }
+#else
+        lpszCommName = options.port.c_str();
+        initPort();
+        if (session->hComm == INVALID_HANDLE_VALUE)
+        {
+            fprintf(stderr, "cannot open %s\n", lpszCommName);
+            return 1;
+        }
+        if (!options.line.empty() && !configLine(options.line.c_str()))
+        {
+            fprintf(stderr, "bad line settings \"%s\"\n", options.line.c_str());
+            return 1;
+        }
+#endif
+    }
+
+    // what this station receives is streamed to the file while the link runs
+    const char *sinkPath = options.recvFile.empty() || options.recvFile == "-" ? NULL : options.recvFile.c_str();
+    if (!session->fileSink.open(sinkPath))
+    {
+        fprintf(stderr, "cannot write %s\n", sinkPath);
+        return 1;
+    }
+
+    // the peer's dump goes in first, this station's is appended after it
+    if (!options.traceFile.empty() && !traceOpen(options.traceFile.c_str(), options.port.c_str(), peer > 0))
+    {
+        fprintf(stderr, "cannot write %s\n", options.traceFile.c_str());
+        return 1;
+    }
+
+    startEngine();
+    connect();
+
+    if (!waitForLink(options.timeout))
+    {
+        fprintf(stderr, "no link setup from the peer on %s\n", options.port.c_str());
+        disconnect();
+        stopEngine();
+        // the bids that went unanswered are in the trace
+        if (!options.traceFile.empty())
+            traceDump();
+        return 1;
+    }
+
+    // the transfer is timed from the link setup on, bids for the setup can take a while
+    DWORD start = GetTickCount();
+    if (options.statsEvery)
+        startExport(options, start);
+
+    BOOL ok = TRUE;
+    result->bytesSent = sendFiles(options, &ok);
+    DWORD end = GetTickCount();
+    // the quiet time a receiver waits out is not part of the transfer
+    if (options.receive)
+        end = max<DWORD>(end - start, receiveFrames(options, start) - start) + start;
+    result->elapsed = end - start;
+
+    stopExport();
+    disconnect();
+    stopEngine();
+    result->bytesReceived = saveReceived(options, &ok);
+    if (!options.sizeTraceFile.empty() && !options.receive && !saveSizeTrace(options.sizeTraceFile, start))
+        ok = FALSE;
+
+#ifndef _WIN32
+    // the peer's line comes out first, then this station's
+    if (peer > 0 && (pty ? ptyJoin(peer) : simJoin(peer)) != 0)
+        ok = FALSE;
+#endif
+    // after the peer's rows, when there is a peer
+    if (!options.latencyFile.empty() && !saveLatency(options.latencyFile, options.port, peer > 0))
+        ok = FALSE;
+    if (!options.traceFile.empty() && !traceDump())
+        ok = FALSE;
+    return ok && session->stats.snapshot().packetLost == 0 ? 0 : 1;
+}
+
+int runBonded(HEADLESS_OPTIONS &options)
+{
+#ifndef _WIN32
+    vector<SIM_PARAMS> params;
+    for (const string &spec : options.bond)
+    {
+        SIM_PARAMS sim;
+        if (!parseSimSpec(spec.c_str(), &sim))
+            return 2;
+        params.push_back(sim);
+    }
+
+    // the forked peer receives whatever this station sends, over every link at once
+    vector<Transport *> lines;
+    int peer = simForkLinks(params, lines);
+    if (peer < 0)
+    {
+        fprintf(stderr, "cannot start the simulated peer\n");
+        return 1;
+    }
+    options.port = string("bond:") + (peer ? "0" : "1");
+    BOOL receiver = peer == 0;
+
+    // the first link is the driver's own, the others take the settings from the command line off it
+    vector<LinkSession *> links;
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        LinkSession *link = i == 0 ? session : new LinkSession();
+        link->localParams = session->localParams;
+        link->transport = lines[i];
+        link->connected = TRUE;
+        link->fileSink.open(NULL);
+        links.push_back(link);
+        startEngine(link);
+    }
+
+    // every link is set up on its own, as waitForLink() does for one
+    BOOL ok = TRUE;
+    DWORD start = GetTickCount();
+    for (LinkSession *link : links)
+        postCommand(ENGINE_CMD_SETUP, NULL, NULL, link);
+    for (size_t ready = 0; ok && ready < links.size(); Sleep(HEADLESS_POLL))
+    {
+        ready = 0;
+        for (LinkSession *link : links)
+            if (link->linkReady)
+                ready++;
+        ok = !options.timeout || GetTickCount() - start < options.timeout;
+    }
+    if (!ok)
+        fprintf(stderr, "no link setup from the peer on every link of %s\n", options.port.c_str());
+
+    LinkBond *bond = new LinkBond(links);
+    const char *sinkPath = options.recvFile.empty() || options.recvFile == "-" ? NULL : options.recvFile.c_str();
+    if (ok && receiver && !bond->open(sinkPath))
+    {
+        fprintf(stderr, "cannot write %s\n", sinkPath);
+        ok = FALSE;
+    }
+
+    // the transfer is timed from the link setup on
+    start = GetTickCount();
+    for (size_t i = 0; ok && !receiver && i < options.sendFiles.size(); i++)
+        if (!bond->send(options.sendFiles[i].c_str()))
+        {
+            fprintf(stderr, "cannot send %s\n", options.sendFiles[i].c_str());
+            ok = FALSE;
+        }
+    DWORD end = GetTickCount();
+
+    // until no stripe has come in on any link for a while, or the time is up, as receiveFrames() does;
+    // the file itself stops growing while a gap waits for a link that went down
+    uint64_t seen = 0;
+    DWORD last = start;
+    while (ok && receiver)
+    {
+        Sleep(HEADLESS_POLL);
+        DWORD now = GetTickCount();
+        uint64_t in = 0;
+        for (size_t i = 0; i < bond->links(); i++)
+            in += bond->linkBytes(i);
+        if (in != seen)
+        {
+            seen = in;
+            last = now;
+        }
+        BOOL open = FALSE;
+        for (Transport *line : lines)
+            open = open || line->isOpen();
+        if ((seen > 0 && now - last >= options.idle) || (options.timeout && now - start >= options.timeout) || !open)
+            break;
+    }
+    // the quiet time a receiver waits out is not part of the transfer
+    if (receiver)
+        end = seen > 0 ? last : GetTickCount();
+
+    for (LinkSession *link : links)
+    {
+        link->connected = FALSE;
+        stopEngine(link);
+    }
+    if (receiver && !bond->close())
+    {
+        fprintf(stderr, "cannot write %s\n", options.recvFile.c_str());
+        ok = FALSE;
+    }
+
+    // the peer's line comes out first, then this station's
+    if (peer > 0 && simJoin(peer) != 0)
+        ok = FALSE;
+
+    DWORD elapsed = end - start;
+    uint64_t bytes = bond->bytes();
+    vector<pair<string, string>> fields;
+    auto add = [&fields](const string &name, double value) {
+        ostringstream text;
+        text.precision(12);
+        text << value;
+        fields.push_back(make_pair(name, text.str()));
+    };
+    fields.push_back(make_pair(string("port"), options.port));
+    add("links", (double) bond->links());
+    add("linksLost", (double) bond->linksLost());
+    add("elapsedMs", elapsed);
+    add("bytesSent", (double) (receiver ? 0 : bytes));
+    add("bytesReceived", (double) (receiver ? bytes : 0));
+    add("goodputBps", (double) (uint64_t) (elapsed ? bytes * 1000.0 / elapsed : 0.0));
+    add("stripesResent", (double) bond->restriped());
+    // the share each link carried
+    for (size_t i = 0; i < bond->links(); i++)
+    {
+        add("link" + to_string(i) + "Bytes", (double) bond->linkBytes(i));
+        add("link" + to_string(i) + "GoodputBps",
+            (double) (uint64_t) (elapsed ? bond->linkBytes(i) * 1000.0 / elapsed : 0.0));
+    }
+    fputs(formatFields(fields, options.csv).c_str(), stdout);
+
+    delete bond;
+    for (size_t i = 1; i < links.size(); i++)
+        delete links[i];
+    return ok && (receiver || bytes > 0) ? 0 : 1;
+#else
+    return 2;
+#endif
+}
+
+BOOL parseOptions(int argc, char **argv, HEADLESS_OPTIONS *options)
+{
+    options->port = "/dev/ttyS0";
+    options->idle = HEADLESS_IDLE;
+    options->timeout = 0;
+    options->statsEvery = 0;
+    options->receive = FALSE;
+    options->csv = FALSE;
+    options->verbose = FALSE;
+    options->bench = FALSE;
+    options->suite = FALSE;
+    options->bers = SUITE_BERS;
+    options->payloads = SUITE_PAYLOADS;
+    options->latencies = SUITE_LATENCIES;
+    options->suiteBytes = SUITE_BYTES;
+    options->tolerance = SUITE_TOLERANCE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        // every option but the flags takes the next argument
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        BOOL flag = arg == "--recv" || arg == "--csv" || arg == "--json" || arg == "--nocompress" ||
+            arg == "--noadapt" || arg == "--nobackoff" || arg == "--verbose" || arg == "--bench" ||
+            arg == "--suite";
+        if (!flag && !value)
+            return FALSE;
+        if (!flag)
+            i++;
+
+        if (arg == "--port")
+            options->port = value;
+        else if (arg == "--line")
+            options->line = value;
+        else if (arg == "--sim")
+            options->sim = value;
+        else if (arg == "--bond")
+            options->bond.push_back(value);
+        else if (arg == "--send")
+            options->sendFiles.push_back(value);
+        else if (arg == "--recv")
+        {
+            // an optional file name, "-" or nothing keeps the data out of the way
+            options->receive = TRUE;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                options->recvFile = argv[++i];
+        }
+        else if (arg == "--idle")
+            options->idle = (DWORD) (atof(value) * 1000);
+        else if (arg == "--timeout")
+            options->timeout = (DWORD) (atof(value) * 1000);
+        else if (arg == "--window")
+        {
+            int window = atoi(value);
+            if (window < 1 || window > ARQ_MAX_WINDOW)
+                return FALSE;
+            session->localParams.window = (BYTE) window;
+        }
+        else if (arg == "--payload")
+        {
+            // same range as "/payload N" in the dialog
+            int size = atoi(value);
+            if (size < PAYLOAD_UNIT || size > PACKET_DATA_MAX)
+                return FALSE;
+            session->localParams.maxPayload = (WORD) size;
+        }
+        else if (arg == "--nocompress")
+            session->localParams.compress = COMPRESS_NONE;
+        else if (arg == "--noadapt")
+            session->localParams.adaptive = FALSE;
+        else if (arg == "--nobackoff")
+            session->randomBackoff = FALSE;
+        else if (arg == "--burst")
+        {
+            // frames per won bid, 0 gives up the line after every window
+            int frames = atoi(value);
+            if (frames < 0 || frames > BURST_MAX_FRAMES)
+                return FALSE;
+            session->localParams.burst = (BYTE) frames;
+        }
+        else if (arg == "--fec")
+        {
+            // same range as "/fec N" in the dialog, whole pairs of check symbols
+            int parity = atoi(value);
+            if (parity < 0 || parity > FEC_MAX_PARITY || parity % 2)
+                return FALSE;
+            session->localParams.fecParity = (BYTE) parity;
+        }
+        else if (arg == "--interleave")
+        {
+            int depth = atoi(value);
+            if (depth < 1 || depth > FEC_MAX_DEPTH)
+                return FALSE;
+            session->localParams.fecDepth = (BYTE) depth;
+        }
+        else if (arg == "--size-trace")
+            options->sizeTraceFile = value;
+        else if (arg == "--state-latency")
+            options->latencyFile = value;
+        else if (arg == "--trace")
+            options->traceFile = value;
+        else if (arg == "--decode-trace")
+            options->decodeFile = value;
+        else if (arg == "--stats-every")
+            options->statsEvery = (DWORD) (atof(value) * 1000);
+        else if (arg == "--csv")
+            options->csv = TRUE;
+        else if (arg == "--json")
+            options->csv = FALSE;
+        else if (arg == "--verbose")
+            options->verbose = TRUE;
+        else if (arg == "--bench")
+            options->bench = TRUE;
+        else if (arg == "--suite")
+            options->suite = TRUE;
+        else if (arg == "--bers")
+            options->bers = value;
+        else if (arg == "--payloads")
+            options->payloads = value;
+        else if (arg == "--latencies")
+            options->latencies = value;
+        else if (arg == "--suite-bytes")
+            options->suiteBytes = (DWORD) atol(value);
+        else if (arg == "--baseline")
+            options->baseline = value;
+        else if (arg == "--tolerance")
+            options->tolerance = atof(value) / 100;
+        else
+            return FALSE;
+    }
+
+    // nothing to send means this station is the receiver
+    if (options->sendFiles.empty())
+        options->receive = TRUE;
+    return TRUE;
+}
+
+VOID printUsage(const char *program)
+{
+    fprintf(stderr,
+        "usage: %s [--port DEV|pty] [--line 9600,n,8,1] [--sim SPEC | --bond SPEC...] [--send FILE]...\n"
+        "          [--recv [FILE]] [--idle SEC] [--timeout SEC] [--window N] [--payload BYTES] [--nocompress]\n"
+        "          [--noadapt] [--nobackoff] [--burst FRAMES] [--fec PARITY] [--interleave N] [--size-trace FILE]\n"
+        "          [--state-latency FILE] [--stats-every SEC] [--trace FILE] [--json | --csv] [--verbose] [--bench]\n"
+        "       %s --decode-trace FILE\n"
+        "       %s --suite [--sim SPEC] [--send FILE]... [--bers P,...] [--payloads BYTES,...]\n"
+        "          [--latencies MS,...] [--suite-bytes N] [--baseline FILE] [--tolerance PCT] [--json | --csv]\n"
+        "SPEC: baud=N,latency=MS,turnaround=MS,ber=P,burst=P,burstlen=BITS,drop=P,buffer=BYTES,seed=N,\n"
+        "      down=MS,up=MS\n",
+        program, program, program);
+}
+
+BOOL waitForLink(DWORD msec)
+{
+    DWORD start = GetTickCount();
+
+    // the peer may come up after us, the engine keeps offering until one side answers
+    postCommand(ENGINE_CMD_SETUP);
+    while (!session->linkReady)
+    {
+        if (msec && GetTickCount() - start >= msec)
+            return FALSE;
+        Sleep(HEADLESS_POLL);
+    }
+
+    return TRUE;
+}
+
+uint64_t sendFiles(const HEADLESS_OPTIONS &options, BOOL *ok)
+{
+    uint64_t bytes = 0;
+    HANDLE sent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    for (const string &path : options.sendFiles)
+    {
+        // the engine opens the file, as it does for the dialog's load
+        postCommand(ENGINE_CMD_LOAD, sent, NULL, NULL, path.c_str());
+        WaitForSingleObject(sent, INFINITE);
+        if (!session->fileSource.isOpen())
+        {
+            fprintf(stderr, "cannot open %s\n", path.c_str());
+            *ok = FALSE;
+            continue;
+        }
+
+        // same command as the send button, the engine closes the file when it is done with it
+        postCommand(ENGINE_CMD_SEND, sent);
+        WaitForSingleObject(sent, INFINITE);
+        // only what the peer acknowledged, nothing of a file that was given up
+        bytes += session->transfer.delivered;
+    }
+
+    CloseHandle(sent);
+    return bytes;
+}
+
+DWORD receiveFrames(const HEADLESS_OPTIONS &options, DWORD start)
+{
+    int seen = session->stats.snapshot().packetReceived;
+    DWORD last = GetTickCount();
+
+    // until the line has been quiet for a while after the first frame, or the time is up
+    for (;;)
+    {
+        Sleep(HEADLESS_POLL);
+        DWORD now = GetTickCount();
+
+        int received = session->stats.snapshot().packetReceived;
+        if (received != seen)
+        {
+            seen = received;
+            last = now;
+        }
+        if (seen > 0 && now - last >= options.idle)
+            break;
+        if (options.timeout && now - start >= options.timeout)
+            break;
+        // the other end went away, nothing more is coming
+        if (!session->transport->isOpen())
+            break;
+    }
+
+    // when the last frame came in
+    return seen > 0 ? last : GetTickCount();
+}
+
+uint64_t saveReceived(const HEADLESS_OPTIONS &options, BOOL *ok)
+{
+    // the engine has stopped, the sink only has its last blocks to write
+    if (!session->fileSink.close())
+    {
+        fprintf(stderr, "cannot write %s\n", options.recvFile.c_str());
+        *ok = FALSE;
+    }
+
+    return session->fileSink.bytes();
+}
+
+BOOL saveSizeTrace(const string &path, DWORD start)
+{
+    FILE *out = fopen(path.c_str(), "w");
+    if (!out)
+    {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return FALSE;
+    }
+
+    // ms from the start of the transfer
+    fputs("ms,frames,failed,berEstimate,fromPayload,toPayload,efficiency\n", out);
+    for (size_t i = 0; i < session->sizeTrace.size(); i++)
+    {
+        const SIZE_DECISION &d = session->sizeTrace.at(i);
+        fprintf(out, "%ld,%lu,%lu,%.3g,%u,%u,%.4f\n", (long) (d.tick - start), (unsigned long) d.frames,
+            (unsigned long) d.failed, d.ber, (unsigned) d.from, (unsigned) d.to, d.efficiency);
+    }
+
+    return fclose(out) == 0;
+}
+
+BOOL saveLatency(const string &path, const string &port, BOOL append)
+{
+    FILE *out = fopen(path.c_str(), append ? "a" : "w");
+    if (!out)
+    {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return FALSE;
+    }
+
+    // the engine has stopped, the histograms hold the whole run; every row says which station it is
+    istringstream summary(formatLatency());
+    string line;
+    for (BOOL header = TRUE; getline(summary, line); header = FALSE)
+        if (!header || !append)
+            fprintf(out, "%s,%s\n", header ? "port" : port.c_str(), line.c_str());
+    return fclose(out) == 0;
+}
+
+VOID startExport(const HEADLESS_OPTIONS &options, DWORD start)
+{
+    exportStart = start;
+    hExportStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (options.csv)
+        fputs("port,ms,packetSent,packetLost,packetReceived,packetCorrupted,acksReceived,bitErrorRate\n", stderr);
+    if ((exportThread = CreateThread(NULL, 0, exportStats, (LPVOID) &options, 0, NULL)) == NULL)
+        OutputDebugString("cannot start the stats thread\n");
+}
+
+VOID stopExport()
+{
+    if (!exportThread)
+        return;
+
+    SetEvent(hExportStop);
+    WaitForSingleObject(exportThread, INFINITE);
+    CloseHandle(exportThread);
+    CloseHandle(hExportStop);
+    exportThread = NULL;
+}
+
+DWORD WINAPI exportStats(LPVOID param)
+{
+    const HEADLESS_OPTIONS &options = *(const HEADLESS_OPTIONS *) param;
+
+    // the engine is never held up, this thread only reads the counters
+    while (WaitForSingleObject(hExportStop, options.statsEvery) == WAIT_TIMEOUT)
+    {
+        FILE_STATISTICS s = session->stats.snapshot();
+        long ms = (long) (GetTickCount() - exportStart);
+        if (options.csv)
+            fprintf(stderr, "%s,%ld,%d,%d,%d,%d,%d,%d\n", options.port.c_str(), ms, s.packetSent, s.packetLost,
+                s.packetReceived, s.packetCorrupted, s.acksReceived, s.bitErrorRate);
+        else
+            fprintf(stderr, "{\"port\":\"%s\",\"ms\":%ld,\"packetSent\":%d,\"packetLost\":%d,"
+                "\"packetReceived\":%d,\"packetCorrupted\":%d,\"acksReceived\":%d,\"bitErrorRate\":%d}\n",
+                options.port.c_str(), ms, s.packetSent, s.packetLost, s.packetReceived, s.packetCorrupted,
+                s.acksReceived, s.bitErrorRate);
+    }
+
+    return 0;
+}
+
+string formatStats(const HEADLESS_OPTIONS &options, DWORD elapsed, uint64_t bytesSent, uint64_t bytesReceived)
+{
+    double goodput = elapsed ? (double) (bytesSent + bytesReceived) * 1000.0 / elapsed : 0.0;
+    FILE_STATISTICS counted = session->stats.snapshot();
+
+    vector<pair<string, string>> fields;
+    auto add = [&fields](const char *name, double value) {
+        // whole counters must not come out in exponent form
+        ostringstream text;
+        text.precision(12);
+        text << value;
+        fields.push_back(make_pair(string(name), text.str()));
+    };
+    fields.push_back(make_pair(string("port"), options.port));
+    add("elapsedMs", elapsed);
+    add("bytesSent", (double) bytesSent);
+    add("bytesReceived", (double) bytesReceived);
+    add("goodputBps", (double) (uint64_t) goodput);
+    add("packetSent", counted.packetSent);
+    add("packetLost", counted.packetLost);
+    add("packetReceived", counted.packetReceived);
+    add("packetCorrupted", counted.packetCorrupted);
+    add("packetDuplicate", (double) session->rxWindow.duplicates());
+    add("acksReceived", counted.acksReceived);
+    add("bitErrorRate", counted.bitErrorRate);
+    add("readCallsPerFrame", readCallsPerFrame());
+    // how the bids for the line went, and the time spent backing off after the ones that failed
+    add("bids", (double) session->bidMetrics.bids);
+    add("bidSuccessRate", floor(bidSuccessRate() * 1000) / 1000);
+    add("bidCollisions", (double) session->bidMetrics.collided);
+    add("backoffMs", (double) session->bidMetrics.backoffMs);
+    // bursts that went out on a bid won for an earlier one, and the turnaround that saved per MB sent
+    add("burstsHeld", (double) session->sendMetrics.burstsHeld);
+    add("turnaroundSavedMsPerMB",
+        bytesSent ? floor(session->sendMetrics.turnaroundSavedMs * (1 << 20) / bytesSent) : 0);
+    // what the line timeouts had settled on at the end
+    add("srttMs", floor(session->linkRtt.srtt() * 10) / 10);
+    add("rttvarMs", floor(session->linkRtt.rttvar() * 10) / 10);
+    add("rtoMs", session->linkRtt.timeout());
+    add("rttSamples", session->linkRtt.samples());
+    add("berEstimate", session->linkQuality.ber());
+    add("payloadEnd", session->linkParams.adaptive ? session->txPayload : session->linkParams.maxPayload);
+    add("sizeChanges", (double) session->sizeTrace.total());
+    // frames the FEC saved, the bytes it fixed in them, and the ones it could not save
+    add("fecCorrected", (double) session->rxDecoder.fecFrames);
+    add("fecBytesFixed", (double) session->rxDecoder.fecBytes);
+    add("fecUncorrectable", (double) session->rxDecoder.fecFailed);
+
+#ifndef _WIN32
+    // what the simulated channel did to the bytes this station sent
+    SIM_STATS sim;
+    if (simStats(&sim))
+    {
+        add("lineBusyMs", (double) (uint64_t) sim.lineBusyMs);
+        add("lineBytes", (double) sim.bytesSent);
+        add("bytesDropped", (double) sim.bytesDropped);
+        add("bytesOverflow", (double) sim.bytesOverflow);
+        add("bytesCollided", (double) sim.bytesCollided);
+        add("bytesHeard", (double) sim.bytesHeard);
+        add("bitsFlipped", (double) sim.bitsFlipped);
+    }
+#endif
+
+    return formatFields(fields, options.csv);
+}
+
+string formatFields(const vector<pair<string, string>> &fields, BOOL csv)
+{
+    string out;
+    if (csv)
+    {
+        for (size_t i = 0; i < fields.size(); i++)
+            out += fields[i].first + (i + 1 < fields.size() ? "," : "\n");
+        for (size_t i = 0; i < fields.size(); i++)
+            out += fields[i].second + (i + 1 < fields.size() ? "," : "\n");
+        return out;
+    }
+
+    out = "{";
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        // only the port is a string
+        string value = i == 0 ? "\"" + fields[i].second + "\"" : fields[i].second;
+        out += "\"" + fields[i].first + "\":" + value + (i + 1 < fields.size() ? "," : "}\n");
+    }
+    return out;
+}
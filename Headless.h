@@ -0,0 +1,77 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Headless.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the option struct and function declarations for the command line
+-- driver, which runs the protocol engine without the dialog.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef HEADLESS_H
+#define HEADLESS_H
+#include "Common.h"
+
+// receiver stops after this long without a new frame, longer than a few failed line bids
+#define HEADLESS_IDLE       15000
+// how often the driver looks at the stats while receiving
+#define HEADLESS_POLL       100
+
+// Transfer settings taken from the command line
+struct HEADLESS_OPTIONS {
+    std::string port;
+    std::string line;
+    std::string sim;    // channel model of a simulated link, empty for the comm port
+    std::vector<std::string> bond;  // channel model of each simulated link of a bonded transfer
+    std::vector<std::string> sendFiles;
+    std::string recvFile;
+    std::string sizeTraceFile;  // frame size decisions as CSV, none when empty
+    std::string latencyFile;    // per-state latency summary as CSV, none when empty
+    std::string traceFile;      // binary trace dumps, none when empty
+    std::string decodeFile;     // a trace to print as CSV instead of running the link
+    DWORD idle;
+    DWORD timeout;      // whole run in ms, 0 waits for the first frame forever
+    DWORD statsEvery;   // ms between stats lines on stderr while the link runs, 0 for none
+    BOOL receive;
+    BOOL csv;
+    BOOL verbose;
+    BOOL bench;
+    // transfer benchmark matrix, comma-separated values for each axis
+    BOOL suite;
+    std::string bers;
+    std::string payloads;
+    std::string latencies;
+    DWORD suiteBytes;   // size of the generated file when nothing is given to send
+    std::string baseline;
+    double tolerance;   // fraction a result may get worse than its baseline
+};
+
+// One transfer as the driver ran it
+struct TRANSFER_RESULT {
+    DWORD elapsed;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    BOOL peer;          // this process is the forked peer of a simulated link
+};
+
+// function prototypes
+BOOL parseOptions(int argc, char **argv, HEADLESS_OPTIONS *options);
+VOID printUsage(const char *program);
+int runTransfer(HEADLESS_OPTIONS &options, TRANSFER_RESULT *result);
+int runBonded(HEADLESS_OPTIONS &options);
+BOOL waitForLink(DWORD msec);
+uint64_t sendFiles(const HEADLESS_OPTIONS &options, BOOL *ok);
+DWORD receiveFrames(const HEADLESS_OPTIONS &options, DWORD start);
+uint64_t saveReceived(const HEADLESS_OPTIONS &options, BOOL *ok);
+BOOL saveSizeTrace(const std::string &path, DWORD start);
+BOOL saveLatency(const std::string &path, const std::string &port, BOOL append);
+VOID startExport(const HEADLESS_OPTIONS &options, DWORD start);
+VOID stopExport();
+DWORD WINAPI exportStats(LPVOID param);
+std::string formatStats(const HEADLESS_OPTIONS &options, DWORD elapsed, uint64_t bytesSent,
+    uint64_t bytesReceived);
+std::string formatFields(const std::vector<std::pair<std::string, std::string>> &fields, BOOL csv);
+#endif
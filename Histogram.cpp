@@ -0,0 +1,127 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Histogram.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  LatencyHistogram::LatencyHistogram();
+--                  VOID LatencyHistogram::record(uint64_t value);
+--                  uint64_t LatencyHistogram::count() const;
+--                  uint64_t LatencyHistogram::total() const;
+--                  uint64_t LatencyHistogram::maxValue() const;
+--                  uint64_t LatencyHistogram::percentile(double p) const;
+--                  VOID LatencyHistogram::reset();
+--                  size_t LatencyHistogram::bucketOf(uint64_t value);
+--                  uint64_t LatencyHistogram::bucketTop(size_t bucket);
+--                  uint64_t latencyClock();
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Log-linear histogram. A value with its highest set bit at position m >= HISTOGRAM_SUB_BITS goes
+-- into group m - HISTOGRAM_SUB_BITS + 1, and the HISTOGRAM_SUB_BITS bits below its highest pick the
+-- bucket in the group. Recording is a bit scan and a few relaxed atomic stores, cheap enough to run
+-- on every state of the engine; the buckets never move, so a reader needs no lock either. A
+-- percentile is only as exact as its bucket, within 1/16 of the value.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Histogram.h"
+#include <algorithm>
+#include <chrono>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+using namespace std;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_COUNT)
+        return (size_t) value;
+
+#ifdef _MSC_VER
+    unsigned long msb;
+    _BitScanReverse64(&msb, value);
+#else
+    int msb = 63 - __builtin_clzll(value);
+#endif
+    int shift = msb - HISTOGRAM_SUB_BITS;
+    return (size_t) (shift + 1) * HISTOGRAM_SUB_COUNT + (size_t) ((value >> shift) & (HISTOGRAM_SUB_COUNT - 1));
+}
+
+uint64_t LatencyHistogram::bucketTop(size_t bucket)
+{
+    if (bucket < HISTOGRAM_SUB_COUNT)
+        return bucket;
+
+    int shift = (int) (bucket / HISTOGRAM_SUB_COUNT) - 1;
+    uint64_t low = (uint64_t) (HISTOGRAM_SUB_COUNT + bucket % HISTOGRAM_SUB_COUNT) << shift;
+    return low + ((uint64_t) 1 << shift) - 1;
+}
+
+VOID LatencyHistogram::record(uint64_t value)
+{
+    // one writer, a plain store is enough and avoids a locked add
+    atomic<uint64_t> &bucket = buckets[bucketOf(value)];
+    bucket.store(bucket.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    values.store(values.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    sum.store(sum.load(memory_order_relaxed) + value, memory_order_relaxed);
+    if (value > largest.load(memory_order_relaxed))
+        largest.store(value, memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return values.load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::total() const
+{
+    return sum.load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::maxValue() const
+{
+    return largest.load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    uint64_t n = count();
+    if (n == 0)
+        return 0;
+
+    // the rank of the value, counted from 1
+    uint64_t rank = max<uint64_t>(1, (uint64_t) (p * n + 0.5));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+    {
+        seen += buckets[b].load(memory_order_relaxed);
+        if (seen >= rank)
+            return min<uint64_t>(bucketTop(b), maxValue());
+    }
+    return maxValue();
+}
+
+VOID LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets)
+        bucket = 0;
+    values = 0;
+    sum = 0;
+    largest = 0;
+}
+
+uint64_t latencyClock()
+{
+    // microseconds, GetTickCount() is too coarse for a frame on a fast line
+    return (uint64_t) chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Histogram.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declaration for the latency histogram
+-- the engine keeps for each of its states.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+#include "Platform.h"
+#include <atomic>
+#include <cstdint>
+
+// Values below 2^HISTOGRAM_SUB_BITS get a bucket each, every power of two above is split in
+// 2^HISTOGRAM_SUB_BITS buckets, so a bucket is within 1/16 of the values in it
+#define HISTOGRAM_SUB_BITS      4
+#define HISTOGRAM_SUB_COUNT     (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS       (HISTOGRAM_SUB_COUNT * (64 - HISTOGRAM_SUB_BITS + 1))
+
+// Counts of values in log-linear buckets, like an HDR histogram. One thread records, any thread
+// may read while it does.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    VOID        record(uint64_t value);
+    uint64_t    count() const;
+    uint64_t    total() const;
+    uint64_t    maxValue() const;
+    // the largest value of the bucket that holds fraction p of the values, at most maxValue()
+    uint64_t    percentile(double p) const;
+    VOID        reset();
+
+private:
+    static size_t   bucketOf(uint64_t value);
+    static uint64_t bucketTop(size_t bucket);
+
+    std::atomic<uint64_t>   buckets[HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t>   values;
+    std::atomic<uint64_t>   sum;
+    std::atomic<uint64_t>   largest;
+};
+
+// function prototypes
+uint64_t latencyClock();
+#endif
@@ -0,0 +1,370 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     LinkBond.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  LinkBond::LinkBond(const std::vector<LinkSession *> &links);
+--                  LinkBond::~LinkBond();
+--                  BOOL LinkBond::send(LPCSTR path);
+--                  BOOL LinkBond::open(LPCSTR path);
+--                  BOOL LinkBond::close();
+--                  BOOL LinkBond::next(std::string &payload, size_t maxSize);
+--                  VOID LinkBond::acked(const std::string &payload);
+--                  VOID LinkBond::deliver(uint64_t offset, const std::string &raw);
+--                  VOID LinkBond::sync();
+--                  uint64_t LinkBond::bytes() const;
+--                  size_t LinkBond::links() const;
+--                  uint64_t LinkBond::linkBytes(size_t i) const;
+--                  size_t LinkBond::linksLost() const;
+--                  size_t LinkBond::restriped() const;
+--                  BOND_MEMBER *LinkBond::member(LinkSession *link);
+--                  BOOL LinkBond::soonest(BOND_MEMBER *member, size_t stripe);
+--                  VOID LinkBond::drop(BOND_MEMBER *member);
+--                  VOID LinkBond::wakeWaiting(BOOL all);
+--                  uint64_t bondOffset(const std::string &payload);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- One radio caps a transfer at its line rate. A bond sends one file over several links to the same
+-- peer at once, each link with its own engine, ARQ and link setup, and the peer puts the file back
+-- together in order.
+--
+-- Every link's send window takes its payloads from the bond instead of a file or the text queue. A
+-- payload is a stripe: BOND_HEADER bytes with the offset of the stripe in the files sent so far, one
+-- after the other, then the bytes cut from there, compressed the way that link agreed to. A link
+-- whose window has room asks for the next stripe; it only gets it when no other link would get it
+-- across sooner at the goodput measured on it while it had stripes in flight, counting what it still
+-- has in flight. Otherwise the window goes without, and the link is woken to ask again once a
+-- stripe gets across on any link. The links end up with shares of the file in proportion to their
+-- goodput, and a slow link is not left holding the last stripes.
+--
+-- A link whose send ends before the file does has gone down. What it had not got acknowledged is
+-- handed out again, recut to the sizes of the links still up, and the transfer goes on without it.
+-- The receiver keeps stripes that came in ahead of the next offset, and drops any it has already.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "LinkBond.h"
+#include "Common.h"
+#include "LinkSession.h"
+using namespace std;
+
+LinkBond::LinkBond(const vector<LinkSession *> &links)
+    : hBond_Lock(CreateMutex(NULL, FALSE, NULL)), hProgress(CreateEvent(NULL, FALSE, FALSE, NULL)), base(0),
+      size(0), fileAcked(0), cursor(0), done(0), lost(0), resent(0)
+{
+    for (LinkSession *link : links)
+    {
+        BOND_MEMBER *m = new BOND_MEMBER();
+        m->link = link;
+        m->done = CreateEvent(NULL, FALSE, FALSE, NULL);
+        m->lost = FALSE;
+        m->waiting = FALSE;
+        m->busy = 0;
+        m->busySince = 0;
+        m->bytes = 0;
+        m->given = 0;
+        members.push_back(m);
+        link->bond = this;
+    }
+}
+
+LinkBond::~LinkBond()
+{
+    close();
+    for (BOND_MEMBER *m : members)
+    {
+        m->link->bond = NULL;
+        CloseHandle(m->done);
+        delete m;
+    }
+    CloseHandle(hBond_Lock);
+    CloseHandle(hProgress);
+}
+
+BOOL LinkBond::send(LPCSTR path)
+{
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    // the file goes on where the last one ended, the receiver writes them one after the other
+    base += size;
+    BOOL opened = source.open(path);
+    size = opened ? source.size() : 0;
+    fileAcked = 0;
+    cursor = 0;
+    again.clear();
+    ReleaseMutex(hBond_Lock);
+    if (!opened)
+        return FALSE;
+
+    // every link still up sends, the bond is its source
+    for (BOND_MEMBER *m : members)
+        if (!m->lost)
+            postCommand(ENGINE_CMD_SEND, m->done, NULL, m->link);
+
+    BOOL complete = FALSE;
+    while (!complete)
+    {
+        WaitForSingleObject(hProgress, BOND_WAIT);
+
+        size_t up = 0;
+        WaitForSingleObject(hBond_Lock, INFINITE);
+        complete = fileAcked >= size;
+        for (BOND_MEMBER *m : members)
+        {
+            // a send that ended before the file did gave up on its link
+            if (!complete && !m->lost && WaitForSingleObject(m->done, 0) == WAIT_OBJECT_0)
+                drop(m);
+            if (!m->lost)
+                up++;
+        }
+        ReleaseMutex(hBond_Lock);
+
+        if (up == 0)
+            break;
+    }
+
+    // the links still up see there is nothing left and end their sends
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    wakeWaiting(TRUE);
+    ReleaseMutex(hBond_Lock);
+    for (BOND_MEMBER *m : members)
+        if (!m->lost)
+            WaitForSingleObject(m->done, INFINITE);
+
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    source.close();
+    ReleaseMutex(hBond_Lock);
+    return complete;
+}
+
+BOOL LinkBond::open(LPCSTR path)
+{
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    held.clear();
+    done = 0;
+    BOOL opened = sink.open(path);
+    ReleaseMutex(hBond_Lock);
+
+    return opened;
+}
+
+BOOL LinkBond::close()
+{
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    // stripes still held never got their gap filled
+    held.clear();
+    BOOL ok = sink.close();
+    ReleaseMutex(hBond_Lock);
+
+    return ok;
+}
+
+BOOL LinkBond::next(string &payload, size_t maxSize)
+{
+    payload.clear();
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    BOND_MEMBER *m = member(session);
+
+    // the send of a link only ends once the whole file got across, another link may still go down
+    BOOL more = m && !m->lost && source.isOpen() && fileAcked < size;
+    if (more && (cursor < size || !again.empty()) && maxSize > BOND_HEADER && soonest(m, maxSize))
+    {
+        BOOL retry = !again.empty();
+        uint64_t offset = retry ? again.begin()->first : cursor;
+        size_t len = retry ? again.begin()->second : (size_t) min<uint64_t>(size - cursor, COMPRESS_MAX_RAW);
+        size_t taken;
+        string block;
+        if (source.cut(offset, len, block, maxSize - BOND_HEADER, session->linkParams.compress, &taken))
+        {
+            payload.resize(BOND_HEADER);
+            for (int i = 0; i < BOND_HEADER; i++)
+                payload[i] = (char) ((base + offset) >> (8 * i));
+            payload += block;
+
+            // what is left of a stripe handed out again goes in another one
+            if (retry)
+            {
+                again.erase(again.begin());
+                if (taken < len)
+                    again[offset + taken] = len - taken;
+            }
+            else
+                cursor += taken;
+
+            if (m->unacked.empty())
+                m->busySince = GetTickCount();
+            m->unacked[offset] = taken;
+            m->given += taken;
+        }
+    }
+    if (more && payload.empty())
+        m->waiting = TRUE;
+
+    ReleaseMutex(hBond_Lock);
+    return more;
+}
+
+VOID LinkBond::acked(const string &payload)
+{
+    if (payload.size() < BOND_HEADER)
+        return;
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    uint64_t offset = bondOffset(payload) - base;
+    BOND_MEMBER *m = member(session);
+    if (m && m->unacked.count(offset))
+    {
+        size_t len = m->unacked[offset];
+        m->bytes += len;
+        fileAcked += len;
+        done += len;
+        m->unacked.erase(offset);
+        if (m->unacked.empty())
+        {
+            m->busy += GetTickCount() - m->busySince;
+            m->busySince = 0;
+        }
+    }
+    // the links turned away may have the next stripe now; once the file is across they end their sends
+    wakeWaiting(fileAcked >= size);
+    ReleaseMutex(hBond_Lock);
+
+    SetEvent(hProgress);
+}
+
+VOID LinkBond::deliver(uint64_t offset, const string &raw)
+{
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    BOND_MEMBER *m = member(session);
+    if (m)
+        m->bytes += raw.size();
+
+    // a stripe that came again is dropped, one ahead of the next offset waits for the gap
+    uint64_t next = done;
+    if (offset + raw.size() > next)
+    {
+        if (offset <= next)
+        {
+            sink.write(raw.substr((size_t) (next - offset)));
+            next = offset + raw.size();
+        }
+        else if (raw.size() > held[offset].size())
+            held[offset] = raw;
+    }
+
+    // and everything it lets through
+    while (!held.empty() && held.begin()->first <= next)
+    {
+        const string &stripe = held.begin()->second;
+        uint64_t end = held.begin()->first + stripe.size();
+        if (end > next)
+        {
+            sink.write(stripe.substr((size_t) (next - held.begin()->first)));
+            next = end;
+        }
+        held.erase(held.begin());
+    }
+    done = next;
+    ReleaseMutex(hBond_Lock);
+}
+
+VOID LinkBond::sync()
+{
+    WaitForSingleObject(hBond_Lock, INFINITE);
+    sink.sync();
+    ReleaseMutex(hBond_Lock);
+}
+
+uint64_t LinkBond::bytes() const
+{
+    return done;
+}
+
+size_t LinkBond::links() const
+{
+    return members.size();
+}
+
+uint64_t LinkBond::linkBytes(size_t i) const
+{
+    return members[i]->bytes;
+}
+
+size_t LinkBond::linksLost() const
+{
+    return lost;
+}
+
+size_t LinkBond::restriped() const
+{
+    return resent;
+}
+
+BOND_MEMBER *LinkBond::member(LinkSession *link)
+{
+    for (BOND_MEMBER *m : members)
+        if (m->link == link)
+            return m;
+    return NULL;
+}
+
+BOOL LinkBond::soonest(BOND_MEMBER *m, size_t stripe)
+{
+    DWORD now = GetTickCount();
+
+    // ms until the link would have the stripe across, at the goodput it has shown while it had stripes
+    // in flight; -1 before it has shown any. Time spent turned away does not count against it
+    auto eta = [now, stripe](const BOND_MEMBER *link) -> double {
+        DWORD elapsed = link->busy + (link->busySince ? now - link->busySince : 0);
+        if (!link->bytes || !elapsed)
+            return -1;
+        return (double) (link->given - link->bytes + stripe) * elapsed / link->bytes;
+    };
+
+    // a link without a measure yet takes what it asks for, its window keeps that small
+    double mine = eta(m);
+    if (mine < 0)
+        return TRUE;
+    for (BOND_MEMBER *other : members)
+    {
+        double theirs = other != m && !other->lost ? eta(other) : -1;
+        if (theirs >= 0 && theirs < mine)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+VOID LinkBond::drop(BOND_MEMBER *m)
+{
+    m->lost = TRUE;
+    lost++;
+
+    // the other links take over what the peer never acknowledged
+    for (const auto &stripe : m->unacked)
+        again[stripe.first] = stripe.second;
+    resent += m->unacked.size();
+    m->unacked.clear();
+    m->busySince = 0;
+    wakeWaiting(FALSE);
+}
+
+VOID LinkBond::wakeWaiting(BOOL all)
+{
+    for (BOND_MEMBER *m : members)
+        if (!m->lost && (all || m->waiting))
+        {
+            m->waiting = FALSE;
+            m->link->transport->wake();
+        }
+}
+
+uint64_t bondOffset(const string &payload)
+{
+    uint64_t offset = 0;
+    for (int i = BOND_HEADER - 1; i >= 0; i--)
+        offset = (offset << 8) | (BYTE) payload[i];
+    return offset;
+}
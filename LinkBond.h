@@ -0,0 +1,101 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     LinkBond.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declaration for a bond, which stripes
+-- one transfer across several links to the same peer and puts it back together on the other side.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef LINK_BOND_H
+#define LINK_BOND_H
+#include "Platform.h"
+#include "FileSource.h"
+#include "FileSink.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// In front of every payload of a bonded link: the offset of its stripe in the stream of files, low byte first
+#define BOND_HEADER         8
+// Longest the sender sleeps before it looks at the links again, in case a wake went missing
+#define BOND_WAIT           50
+
+class LinkSession;
+
+// One link of a bond, and what the sender has given it
+struct BOND_MEMBER {
+    LinkSession                 *link;
+    HANDLE                      done;       // set when the link's send ends
+    BOOL                        lost;       // the send ended before the file did
+    BOOL                        waiting;    // turned away, woken when a stripe gets across
+    DWORD                       busy;       // ms it had stripes in flight, up to busySince
+    DWORD                       busySince;  // tick it last went from none in flight to some, 0 for none
+    std::atomic<uint64_t>       bytes;      // stripe bytes acknowledged, or delivered on the receiver
+    uint64_t                    given;      // stripe bytes handed to the link
+    std::map<uint64_t, size_t>  unacked;    // offset and length of the stripes the peer does not have yet
+};
+
+// Stripes for a file across the links, or puts the stripes back in order. Either side works through
+// links that are set up with engines running; every link gets the bond as its session's bond.
+class LinkBond {
+public:
+    explicit LinkBond(const std::vector<LinkSession *> &links);
+    ~LinkBond();
+
+    // sender: the whole file across the links, FALSE when every link went down before the end
+    BOOL        send(LPCSTR path);
+    // receiver: where the file goes, NULL only counts it
+    BOOL        open(LPCSTR path);
+    BOOL        close();
+
+    // the engines: the next stripe for the calling thread's link, empty when another link should have
+    // it; a stripe the peer acknowledged; a stripe that came in
+    BOOL        next(std::string &payload, size_t maxSize);
+    VOID        acked(const std::string &payload);
+    VOID        deliver(uint64_t offset, const std::string &raw);
+    VOID        sync();
+
+    // bytes of the file sent and acknowledged, or put in order on the receiver
+    uint64_t    bytes() const;
+    size_t      links() const;
+    uint64_t    linkBytes(size_t i) const;
+    // links that went down, and stripes sent again over another link because of it
+    size_t      linksLost() const;
+    size_t      restriped() const;
+
+private:
+    BOND_MEMBER *member(LinkSession *link);
+    BOOL        soonest(BOND_MEMBER *member, size_t stripe);
+    VOID        drop(BOND_MEMBER *member);
+    VOID        wakeWaiting(BOOL all);
+
+    std::vector<BOND_MEMBER *>  members;
+    HANDLE                      hBond_Lock;
+    HANDLE                      hProgress;      // set when a stripe is acknowledged
+    FileSource                  source;
+    // sender: where the file being sent starts in the stream of every file sent, its size, the bytes
+    // of it acknowledged, the next offset never handed out, and stripes of a lost link to hand out again
+    uint64_t                    base;
+    uint64_t                    size;
+    uint64_t                    fileAcked;
+    uint64_t                    cursor;
+    std::map<uint64_t, size_t>  again;
+    // receiver: stripes ahead of the next stream offset, by offset
+    FileSink                    sink;
+    std::map<uint64_t, std::string> held;
+    // acknowledged bytes of every file sent, or bytes put in order
+    std::atomic<uint64_t>       done;
+    size_t                      lost;
+    size_t                      resent;
+};
+
+// function prototypes
+uint64_t bondOffset(const std::string &payload);
+#endif
@@ -0,0 +1,325 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     LinkPool.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  LinkPool::LinkPool();
+--                  LinkPool::~LinkPool();
+--                  BOOL LinkPool::start(const std::vector<LinkSession *> &links, size_t workers);
+--                  VOID LinkPool::stop();
+--                  uint64_t LinkPool::switches() const;
+--                  DWORD WINAPI LinkPool::workerThread(LPVOID param);
+--                  int poolPoll(struct pollfd *fds, int count, int msec);
+--                  VOID poolSleep(double msec);
+--                  static double clockMs();
+--                  static VOID park(POOL_LINK *link, double deadline);
+--                  static VOID linkEntry();
+--                  static BOOL makeContext(POOL_LINK *link);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- A base station has a modem per link, and an engine thread per link spends nearly all its time
+-- asleep on the line. The pool runs the engine of every link on one of a few worker threads instead,
+-- each engine on a stack of its own. The engine code is the same one engineThread() runs: where it
+-- would sleep on the line, the transport calls poolPoll() or poolSleep(), which hand the worker back
+-- to its scheduler until the line is ready or the time is up.
+--
+-- A worker runs every link that can go on, in turn, then sleeps in epoll_wait() on the fds its links
+-- wait for, until the nearest deadline. A link stays on the worker it started on, so the engine's
+-- thread_local session stays right for it; the worker sets it before every switch.
+--
+-- A link whose engine blocks some other way, on a full text queue or a slow disk, holds up the other
+-- links of its worker for as long. Linux only, like the transports that call it.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "LinkPool.h"
+#include "Common.h"
+#include "LinkSession.h"
+#ifndef _WIN32
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <thread>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+using namespace std;
+
+// One link's engine in the pool
+struct POOL_LINK {
+    LinkSession     *link;
+    POOL_WORKER     *worker;
+    ucontext_t      context;
+    char            *stack;
+    BOOL            finished;
+    // waiting for its fds or its deadline, ms on clockMs(); -1 for no deadline
+    BOOL            parked;
+    double          deadline;
+};
+
+// One thread of the pool and the links it runs
+struct POOL_WORKER {
+    int                         epfd;
+    ucontext_t                  scheduler;
+    HANDLE                      thread;
+    std::vector<POOL_LINK *>    links;
+    std::deque<POOL_LINK *>     runnable;
+    size_t                      live;
+    // only the worker writes it
+    std::atomic<uint64_t>       switches;
+};
+
+// the link the calling worker is running, NULL outside a pool
+static thread_local POOL_LINK *running;
+
+static double clockMs()
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// back to the scheduler until a fd the link watches is ready or the deadline passes
+static VOID park(POOL_LINK *link, double deadline)
+{
+    link->parked = TRUE;
+    link->deadline = deadline;
+    swapcontext(&link->context, &link->worker->scheduler);
+}
+
+static VOID linkEntry()
+{
+    POOL_LINK *self = running;
+    engineThread(self->link);
+    // uc_link goes back to the scheduler
+    self->finished = TRUE;
+}
+
+// the engine's stack and the context that starts it; getcontext() is kept out of the frame of the
+// loop in start(), whose counter would not survive a second return from it
+static BOOL makeContext(POOL_LINK *link)
+{
+    // the lowest page stays unmapped, an engine that overruns its stack faults
+    void *stack = mmap(NULL, POOL_STACK, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    link->stack = stack == MAP_FAILED ? NULL : (char *) stack;
+    if (!link->stack)
+        return FALSE;
+    mprotect(link->stack, (size_t) sysconf(_SC_PAGESIZE), PROT_NONE);
+
+    getcontext(&link->context);
+    link->context.uc_stack.ss_sp = link->stack;
+    link->context.uc_stack.ss_size = POOL_STACK;
+    link->context.uc_link = &link->worker->scheduler;
+    makecontext(&link->context, linkEntry, 0);
+    return TRUE;
+}
+
+LinkPool::LinkPool()
+    : stoppedSwitches(0)
+{
+}
+
+LinkPool::~LinkPool()
+{
+    stop();
+}
+
+BOOL LinkPool::start(const vector<LinkSession *> &links, size_t count)
+{
+    if (!workers.empty() || links.empty() || count == 0)
+        return FALSE;
+
+    try {
+        count = min<size_t>(count, links.size());
+        for (size_t i = 0; i < count; i++)
+        {
+            POOL_WORKER *worker = new POOL_WORKER();
+            worker->epfd = epoll_create1(0);
+            worker->thread = NULL;
+            worker->live = 0;
+            workers.push_back(worker);
+            if (worker->epfd < 0)
+            {
+                stop();
+                return FALSE;
+            }
+        }
+
+        for (size_t i = 0; i < links.size(); i++)
+        {
+            POOL_WORKER *worker = workers[i % count];
+            POOL_LINK *p = new POOL_LINK();
+            p->link = links[i];
+            p->worker = worker;
+            p->finished = FALSE;
+            p->parked = FALSE;
+            p->deadline = -1;
+            worker->links.push_back(p);
+            if (!makeContext(p))
+            {
+                stop();
+                return FALSE;
+            }
+
+            links[i]->engineRunning = TRUE;
+            links[i]->engineState = ENGINE_IDLE;
+            worker->runnable.push_back(p);
+            worker->live++;
+        }
+        this->links = links;
+
+        for (POOL_WORKER *worker : workers)
+            if ((worker->thread = CreateThread(NULL, 0, workerThread, worker, 0, NULL)) == NULL)
+            {
+                stop();
+                return FALSE;
+            }
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+        stop();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+VOID LinkPool::stop()
+{
+    // as stopEngine() does for a link with a thread of its own
+    for (LinkSession *link : links)
+    {
+        link->engineRunning = FALSE;
+        if (link->transport)
+            link->transport->wake();
+    }
+
+    for (POOL_WORKER *worker : workers)
+    {
+        if (worker->thread)
+        {
+            WaitForSingleObject(worker->thread, INFINITE);
+            CloseHandle(worker->thread);
+        }
+        stoppedSwitches += worker->switches.load(memory_order_relaxed);
+        for (POOL_LINK *p : worker->links)
+        {
+            if (p->stack)
+                munmap(p->stack, POOL_STACK);
+            delete p;
+        }
+        if (worker->epfd >= 0)
+            ::close(worker->epfd);
+        delete worker;
+    }
+    workers.clear();
+    links.clear();
+}
+
+uint64_t LinkPool::switches() const
+{
+    uint64_t n = stoppedSwitches;
+    for (POOL_WORKER *worker : workers)
+        n += worker->switches.load(memory_order_relaxed);
+    return n;
+}
+
+DWORD WINAPI LinkPool::workerThread(LPVOID param)
+{
+    POOL_WORKER *worker = (POOL_WORKER *) param;
+    struct epoll_event ev[POOL_EVENTS];
+
+    for (;;)
+    {
+        // every link that can go on runs until it waits again
+        while (!worker->runnable.empty())
+        {
+            POOL_LINK *link = worker->runnable.front();
+            worker->runnable.pop_front();
+            running = link;
+            session = link->link;
+            swapcontext(&worker->scheduler, &link->context);
+            running = NULL;
+            worker->switches.store(worker->switches.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            if (link->finished)
+                worker->live--;
+        }
+        if (worker->live == 0)
+            break;
+
+        // asleep until a line is ready or the nearest deadline
+        double nearest = -1;
+        for (POOL_LINK *link : worker->links)
+            if (link->parked && link->deadline >= 0 && (nearest < 0 || link->deadline < nearest))
+                nearest = link->deadline;
+        int msec = nearest < 0 ? -1 : (int) ceil(max<double>(0, nearest - clockMs()));
+
+        int n = epoll_wait(worker->epfd, ev, POOL_EVENTS, msec);
+        for (int i = 0; i < n; i++)
+        {
+            POOL_LINK *link = (POOL_LINK *) ev[i].data.ptr;
+            if (link->parked)
+            {
+                link->parked = FALSE;
+                worker->runnable.push_back(link);
+            }
+        }
+
+        double now = clockMs();
+        for (POOL_LINK *link : worker->links)
+            if (link->parked && link->deadline >= 0 && link->deadline <= now)
+            {
+                link->parked = FALSE;
+                worker->runnable.push_back(link);
+            }
+    }
+
+    session = &defaultSession;
+    return 0;
+}
+
+int poolPoll(struct pollfd *fds, int count, int msec)
+{
+    POOL_LINK *self = running;
+    if (!self)
+        return poll(fds, count, msec);
+
+    double deadline = msec < 0 ? -1 : clockMs() + msec;
+    for (;;)
+    {
+        int n = poll(fds, count, 0);
+        if (n != 0 || msec == 0 || (deadline >= 0 && clockMs() >= deadline))
+            return n;
+
+        // the worker watches the fds while the link is parked; poll and epoll share the event bits
+        for (int i = 0; i < count; i++)
+        {
+            struct epoll_event ev = {};
+            ev.events = (uint32_t) fds[i].events;
+            ev.data.ptr = self;
+            epoll_ctl(self->worker->epfd, EPOLL_CTL_ADD, fds[i].fd, &ev);
+        }
+        park(self, deadline);
+        for (int i = 0; i < count; i++)
+            epoll_ctl(self->worker->epfd, EPOLL_CTL_DEL, fds[i].fd, NULL);
+    }
+}
+
+VOID poolSleep(double msec)
+{
+    POOL_LINK *self = running;
+    if (!self)
+    {
+        this_thread::sleep_for(chrono::duration<double, milli>(msec));
+        return;
+    }
+
+    double deadline = clockMs() + msec;
+    while (clockMs() < deadline)
+        park(self, deadline);
+}
+#endif
@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     LinkPool.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions, class and function declarations for the pool that
+-- runs the engines of many links on a few worker threads. Linux only.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef LINK_POOL_H
+#define LINK_POOL_H
+#include "Platform.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#ifndef _WIN32
+#include <poll.h>
+
+// Stack of each link's engine
+#define POOL_STACK          (256 * 1024)
+// Ready links taken off the line in one wait
+#define POOL_EVENTS         64
+
+class LinkSession;
+struct POOL_WORKER;
+
+// The engines of many links, each link on one of the workers for as long as the pool runs. The links
+// are set up and connected before start(); the driver posts them commands as it would to a link with
+// an engine thread of its own.
+class LinkPool {
+public:
+    LinkPool();
+    ~LinkPool();
+
+    // the links are spread over the workers in turn
+    BOOL        start(const std::vector<LinkSession *> &links, size_t workers);
+    // every engine finishes the exchange it is in, then the workers stop
+    VOID        stop();
+    // times a worker went from one link's engine to another's since the pool was made
+    uint64_t    switches() const;
+
+private:
+    static DWORD WINAPI workerThread(LPVOID param);
+
+    std::vector<POOL_WORKER *>  workers;
+    std::vector<LinkSession *>  links;
+    // switches of the workers of earlier runs
+    uint64_t                    stoppedSwitches;
+};
+
+// poll() and a sleep for the engines; in a pool they let the worker run other links meanwhile
+int poolPoll(struct pollfd *fds, int count, int msec);
+VOID poolSleep(double msec);
+#endif
+#endif
@@ -0,0 +1,189 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     LinkQuality.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  LinkQuality::LinkQuality();
+--                  VOID LinkQuality::reset();
+--                  VOID LinkQuality::record(size_t lineBytes, BOOL ok);
+--                  VOID LinkQuality::recordBurst(size_t bytes, DWORD msec);
+--                  double LinkQuality::ber() const;
+--                  double LinkQuality::lineRate() const;
+--                  DWORD LinkQuality::frames() const;
+--                  DWORD LinkQuality::failed() const;
+--                  SizeTrace::SizeTrace();
+--                  VOID SizeTrace::clear();
+--                  VOID SizeTrace::record(const SIZE_DECISION &decision);
+--                  uint64_t SizeTrace::total() const;
+--                  size_t SizeTrace::size() const;
+--                  const SIZE_DECISION &SizeTrace::at(size_t i) const;
+--                  double payloadEfficiency(size_t payload, double ber, double burstOverhead, size_t window,
+--                                           size_t fill);
+--                  size_t bestPayload(double ber, double burstOverhead, size_t window, size_t maxPayload,
+--                                     size_t fill);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The sender's view of the line. Each frame it sent and learned about from a SACK is one outcome.
+-- With S of the last N frames through and L their average size in bits, the bit error rate is
+--
+--     BER = -ln((S + 1/2) / (N + 1)) / L
+--
+-- where the halves keep a clean history from reading as a perfect line.
+--
+-- A frame of payload P carries `overhead` more bytes: the framing, and the check bytes on a link with
+-- FEC, where the estimate is of the errors the FEC leaves behind. It gets through with probability
+-- (1 - BER)^(8 (P + overhead)). Each burst of `window` frames also pays for the line bid and the
+-- SACK. The payload that makes the most of the line is
+--
+--     P (1 - BER)^(8 (P + overhead)) / (P + overhead + burstOverhead / window)
+--
+-- so small frames win on a noisy line and large ones on a clean one. P is what a frame carries on
+-- the line, compressed. When the source has not filled frames of the current size lately (short
+-- lines of text, data that compresses well), a larger size would not give it larger frames, and the
+-- frame is modelled at the most the source filled instead.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "LinkQuality.h"
+#include "Common.h"
+#include <cmath>
+using namespace std;
+
+LinkQuality::LinkQuality()
+    : failures(0), bits(0), rate(0)
+{
+}
+
+VOID LinkQuality::reset()
+{
+    history.clear();
+    failures = 0;
+    bits = 0;
+    rate = 0;
+}
+
+VOID LinkQuality::record(size_t lineBytes, BOOL ok)
+{
+    history.push_back(make_pair(lineBytes * 8, ok));
+    bits += lineBytes * 8;
+    if (!ok)
+        failures++;
+
+    if (history.size() > QUALITY_HISTORY)
+    {
+        bits -= history.front().first;
+        if (!history.front().second)
+            failures--;
+        history.pop_front();
+    }
+}
+
+VOID LinkQuality::recordBurst(size_t bytes, DWORD msec)
+{
+    // a write that returned within the tick says nothing about the line
+    if (msec == 0)
+        return;
+
+    double sample = (double) bytes / msec;
+    rate = rate == 0 ? sample : 0.875 * rate + 0.125 * sample;
+}
+
+double LinkQuality::ber() const
+{
+    if (history.empty())
+        return 0;
+
+    double n = (double) history.size();
+    double through = n - failures;
+    double meanBits = (double) bits / n;
+    return -log((through + 0.5) / (n + 1)) / meanBits;
+}
+
+double LinkQuality::lineRate() const
+{
+    return rate;
+}
+
+DWORD LinkQuality::frames() const
+{
+    return (DWORD) history.size();
+}
+
+DWORD LinkQuality::failed() const
+{
+    return failures;
+}
+
+SizeTrace::SizeTrace()
+    : next(0)
+{
+}
+
+VOID SizeTrace::clear()
+{
+    records.clear();
+    next = 0;
+}
+
+VOID SizeTrace::record(const SIZE_DECISION &decision)
+{
+    // a link that runs for days changes size as often as the line does, only the latest are kept
+    if (records.size() < SIZE_TRACE_RECORDS)
+        records.push_back(decision);
+    else
+        records[next % SIZE_TRACE_RECORDS] = decision;
+    next++;
+}
+
+uint64_t SizeTrace::total() const
+{
+    return next;
+}
+
+size_t SizeTrace::size() const
+{
+    return records.size();
+}
+
+const SIZE_DECISION &SizeTrace::at(size_t i) const
+{
+    // once the ring is full, the oldest is the one the next change overwrites
+    return records[(records.size() < SIZE_TRACE_RECORDS ? i : next + i) % SIZE_TRACE_RECORDS];
+}
+
+double payloadEfficiency(size_t payload, double ber, double burstOverhead, size_t window, size_t fill)
+{
+    // the source puts no more than fill bytes in a frame, whatever the payload size; 0 fills any
+    if (fill)
+        payload = min<size_t>(payload, fill);
+    double frame = (double) frameSize(payload);
+    double through = exp(8 * frame * log1p(-min<double>(ber, 0.5)));
+    return payload * through / (frame + burstOverhead / max<size_t>(1, window));
+}
+
+size_t bestPayload(double ber, double burstOverhead, size_t window, size_t maxPayload, size_t fill)
+{
+    size_t best = PAYLOAD_UNIT;
+    double most = 0;
+
+    // PAYLOAD_UNIT steps like the setup, up to the agreed maximum itself
+    for (size_t step = PAYLOAD_UNIT; ; step += PAYLOAD_UNIT)
+    {
+        size_t payload = min<size_t>(step, maxPayload);
+        double efficiency = payloadEfficiency(payload, ber, burstOverhead, window, fill);
+        if (efficiency > most)
+        {
+            most = efficiency;
+            best = payload;
+        }
+        if (payload == maxPayload)
+            break;
+    }
+
+    return best;
+}
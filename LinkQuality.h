@@ -0,0 +1,83 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     LinkQuality.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions, structs and class declaration for the link
+-- quality estimate the sender sizes its frames by.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef LINK_QUALITY_H
+#define LINK_QUALITY_H
+#include "Platform.h"
+#include <deque>
+#include <vector>
+
+// Frame outcomes the estimate looks back over
+#define QUALITY_HISTORY     64
+// Outcomes needed before the first size change
+#define QUALITY_MIN_FRAMES  8
+// Size changes a link keeps for --size-trace, the oldest are overwritten after that
+#define SIZE_TRACE_RECORDS  1024
+// A size has to promise this much more goodput than the current one before the sender switches
+#define QUALITY_HYSTERESIS  1.05
+
+// One frame size change, kept so a run can be checked against the channel it ran on
+struct SIZE_DECISION {
+    DWORD   tick;
+    DWORD   frames;         // outcomes the estimate was made from
+    DWORD   failed;
+    double  ber;            // estimated bit error rate
+    WORD    from;
+    WORD    to;
+    double  efficiency;     // expected share of the line that carries payload at the new size
+};
+
+class LinkQuality {
+public:
+    LinkQuality();
+
+    VOID    reset();
+    // a frame that took this many bytes on the line got through, or did not
+    VOID    record(size_t lineBytes, BOOL ok);
+    // a burst of this many bytes took this long to write
+    VOID    recordBurst(size_t bytes, DWORD msec);
+    // the bit error rate that best explains the outcomes in the history
+    double  ber() const;
+    // bytes per ms the line takes, 0 until a burst was slow enough to time
+    double  lineRate() const;
+    DWORD   frames() const;
+    DWORD   failed() const;
+
+private:
+    std::deque<std::pair<size_t, BOOL>> history;
+    DWORD   failures;
+    size_t  bits;
+    double  rate;
+};
+
+// The latest size changes, in a ring that grows to SIZE_TRACE_RECORDS and then stays that size
+class SizeTrace {
+public:
+    SizeTrace();
+
+    VOID    clear();
+    VOID    record(const SIZE_DECISION &decision);
+    // changes ever recorded, the ones still held, and the i-th of those, oldest first
+    uint64_t total() const;
+    size_t  size() const;
+    const SIZE_DECISION &at(size_t i) const;
+
+private:
+    std::vector<SIZE_DECISION> records;
+    uint64_t next;
+};
+
+// function prototypes
+double payloadEfficiency(size_t payload, double ber, double burstOverhead, size_t window, size_t fill);
+size_t bestPayload(double ber, double burstOverhead, size_t window, size_t maxPayload, size_t fill);
+#endif
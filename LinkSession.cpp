@@ -0,0 +1,50 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     LinkSession.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  LinkSession::LinkSession();
+--                  LinkSession::~LinkSession();
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The engine used to keep the line, the ARQ windows, the link setup, the counters and the files in
+-- globals, so one process could run one port. They live in a LinkSession now. The dialog and the
+-- headless driver run one link, the default session; a LinkPool runs as many as there are modems.
+--
+-- Code on the engine's path reaches its link through session, a pointer of the calling thread. The
+-- engine thread, or the pool worker running a link, points it at the link; every other thread starts
+-- out on the default session, so the dialog and the driver work on the link they always did.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "LinkSession.h"
+#include <random>
+
+LinkSession defaultSession;
+thread_local LinkSession *session = &defaultSession;
+
+// an adaptive sender only goes up to the largest payload once the line has shown it can take it;
+// the nonce is new every time the station starts, and never 0, which is a peer that sends none
+LinkSession::LinkSession()
+    : transport(NULL), hComm(INVALID_HANDLE_VALUE), connected(FALSE), bidFailures(0),
+      bidsLost(0), bidRandom(0), randomBackoff(TRUE), bidMetrics(), rxRing(RX_RING_SIZE), rxDecoder(rxRing),
+      readMetrics(),
+      localParams{ ARQ_WINDOW, PACKET_DATA_MAX, COMPRESS_LZ_DICT, TRUE, 0, 1, BURST_FRAMES,
+          (DWORD) std::random_device()() | 1, RESYNC_NONE },
+      linkParams{ 1, PACKET_DATA_SIZE, COMPRESS_NONE, FALSE, 0, 1, 0, 0, RESYNC_NONE }, linkReady(FALSE), setupPending(FALSE),
+      setupSent(0), rxHeld(FALSE), txSeq(0),
+      txPayload(PACKET_DATA_SIZE), sendMetrics(), engineState(ENGINE_IDLE), engineHandle(NULL),
+      engineThreadId(0), engineRunning(FALSE), hEngine_Lock(CreateMutex(NULL, FALSE, ENGINE_LOCK)), transfer(),
+      bond(NULL)
+{
+}
+
+LinkSession::~LinkSession()
+{
+    CloseHandle(hEngine_Lock);
+}
@@ -0,0 +1,104 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     LinkSession.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the class declaration for the state of one radio link. It is not part
+-- of Common.h: every type it holds has to be declared first, so source files include it after their
+-- own header.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef LINK_SESSION_H
+#define LINK_SESSION_H
+#include "Common.h"
+#include <atomic>
+#include <deque>
+
+class LinkBond;
+
+// Everything the engine keeps about one link: the line, both sides of the ARQ, the link setup, the
+// counters and the files. Only the thread running the link's engine changes it, other threads read
+// the counters and queue commands. The flags other threads set or poll are atomic.
+class LinkSession {
+public:
+    LinkSession();
+    ~LinkSession();
+
+    // the line, the comm port unless a simulated link or a tty was set up
+    Transport       *transport;
+    HANDLE          hComm;
+    std::atomic<BOOL> connected;
+    // the contention for the line: failed bids in a row, contention rounds in a row the peer won,
+    // and the generator of the backoffs, seeded on first use. Without randomBackoff a failed bid
+    // waits the same turnaround every time
+    DWORD           bidFailures;
+    DWORD           bidsLost;
+    uint64_t        bidRandom;
+    BOOL            randomBackoff;
+    BID_METRICS     bidMetrics;
+
+    // bytes pulled off the line, shared by every reader
+    RingBuffer      rxRing;
+    FrameDecoder    rxDecoder;
+    READ_METRICS    readMetrics;
+    // reused by every read, waitForData() hands out pointers into it
+    std::vector<char> readBuffer;
+    // round trips on the line
+    RttEstimator    linkRtt;
+
+    // parameters this station offers, and the ones agreed with the peer
+    LINK_PARAMS     localParams;
+    LINK_PARAMS     linkParams;
+    // set once the peer has answered a setup
+    std::atomic<BOOL> linkReady;
+    // a setup this station sent that the peer has not answered yet, and when it last went out
+    BOOL            setupPending;
+    DWORD           setupSent;
+
+    // receive side of the sliding window
+    ReceiveWindow   rxWindow;
+    // the sender keeps the line after our last SACK, its next burst does not answer an ACK
+    BOOL            rxHeld;
+    // sequence number of the next new outgoing frame
+    BYTE            txSeq;
+    // payload size new frames are cut to, follows the link quality on an adaptive link
+    WORD            txPayload;
+    SEND_METRICS    sendMetrics;
+    // the estimate from the SACKs of every burst, and every size change since the link was set up
+    LinkQuality     linkQuality;
+    SizeTrace       sizeTrace;
+    LinkStats       stats;
+
+    // where the engine is, and the thread running it when it has one of its own
+    BYTE            engineState;
+    HANDLE          engineHandle;
+    DWORD           engineThreadId;
+    // cleared by stopEngine(), the engine stops the next time it is idle
+    std::atomic<BOOL> engineRunning;
+    // commands not taken yet
+    HANDLE          hEngine_Lock;
+    std::deque<ENGINE_COMMAND> engineQueue;
+    // send in progress
+    ENGINE_TRANSFER transfer;
+    // time spent in each state
+    LatencyHistogram stateLatency[LATENCY_SLOTS];
+    // events of the link, recorded once traceOpen() named it
+    TRACE_RING      trace;
+
+    // the file to send, and where what is received goes
+    FileSource      fileSource;
+    FileSink        fileSink;
+    // the bond the link stripes a transfer with, its payloads go through it
+    LinkBond        *bond;
+};
+
+// the dialog's link, and the one of the headless driver
+extern LinkSession defaultSession;
+// the link the calling thread works on; an engine sets it to its own, every other thread starts out
+// on the default one
+extern thread_local LinkSession *session;
+#endif
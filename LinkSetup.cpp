@@ -0,0 +1,245 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     LinkSetup.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  VOID requestSetup();
+--                  VOID receiveSetup();
+--                  BOOL applySetup(const LINK_PARAMS &remote);
+--                  BOOL sameParams(const LINK_PARAMS &a, const LINK_PARAMS &b);
+--                  std::string encodeSetup(BYTE kind, const LINK_PARAMS &params);
+--                  BOOL decodeSetup(const char *body, DWORD len, LINK_PARAMS *params);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- On connect a station sends a SETUP_REQUEST with the parameters it offers. The peer's idle engine
+-- answers with a SETUP_REPLY carrying its own, and both sides keep the smaller of each value. Until
+-- the exchange happens the link runs with a window of one, which is plain stop-and-wait, and with
+-- the default payload size. A peer that does not send PARAM_MAX_PAYLOAD is assumed to take
+-- PACKET_DATA_SIZE, and one that does not send PARAM_COMPRESS gets uncompressed text. The modes are
+-- ordered so that the smaller one is understood by both sides. Frames change size mid-transfer only
+-- when both stations send PARAM_ADAPTIVE. Frames carry FEC check bytes only when both send
+-- PARAM_FEC, with the fewer check symbols of the two and the deeper interleave. A sender keeps the
+-- line for more than one window only when both send PARAM_BURST, up to the fewer frames of the two.
+--
+-- A station that asked goes on asking every TIME_OUT_LONG from its idle engine until a reply comes
+-- back, and a request is answered every time it arrives, so a lost reply costs one more round. A
+-- setup that agrees on what the link already runs with changes nothing; the sequence numbers, the
+-- receive window and the estimate of the line start over only when the parameters change or the
+-- peer started over. Every station draws a PARAM_NONCE when it starts and sends it with each setup,
+-- a new one from the peer means its sequence numbers are back at 0. While a send is under way a
+-- change of parameters is not taken at all and the request goes unanswered, the peer keeps asking
+-- until the send is over; a peer that started over has lost that send already, it is given up.
+--
+-- A send given up when the peer stopped answering leaves the peer's receive window wherever the
+-- last frames it got put it, with frames of that send held in it. The station then sends
+-- PARAM_RESYNC with the sequence number of its next frame in every setup, and the peer's receive
+-- window starts over there. No frame of the next send goes out before a reply comes back, the
+-- unanswered setups count as unanswered bids.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "LinkSetup.h"
+#include "LinkSession.h"
+using namespace std;
+
+VOID requestSetup()
+{
+    string frame = encodeSetup(SETUP_REQUEST, session->localParams);
+    sendData(&frame[0], frame.length());
+    TRACE(TRACE_SETUP_SENT, session->txSeq, session->localParams.resync != RESYNC_NONE, 0);
+    // asked again from engineIdle() until the reply is in
+    session->setupPending = TRUE;
+    session->setupSent = GetTickCount();
+}
+
+VOID receiveSetup()
+{
+    try {
+        const char *header, *body;
+        DWORD length;
+
+        // the SOH has already been consumed by the idle engine
+        if (!waitForData(&header, SETUP_HEADER_SIZE, TIME_OUT, &length) || length < SETUP_HEADER_SIZE)
+            return;
+
+        // the buffer behind header is reused by the next read
+        string covered(header, SETUP_HEADER_SIZE);
+        BYTE kind = (BYTE) covered[0];
+        DWORD bodySize = (BYTE) covered[1] + 2;
+        if (bodySize > SETUP_MAX_BODY + 2)
+            return;
+
+        if (!waitForData(&body, bodySize, TIME_OUT, &length) || length < bodySize)
+            return;
+
+        string crcs(body + bodySize - 2, 2);
+        covered += string(body, bodySize - 2);
+        if (CRCtoString(calculateCRC16(covered)) != crcs)
+            return;
+
+        LINK_PARAMS remote = { 1, PACKET_DATA_SIZE, COMPRESS_NONE, FALSE, 0, 1, 0, 0, RESYNC_NONE };
+        if (!decodeSetup(body, bodySize - 2, &remote))
+            return;
+
+        // a change held back by a send is not confirmed, the peer asks again
+        if (!applySetup(remote))
+            return;
+
+        if (kind == SETUP_REQUEST)
+        {
+            string reply = encodeSetup(SETUP_REPLY, session->localParams);
+            sendData(&reply[0], reply.length());
+        }
+        else
+        {
+            // the peer has taken up our sequence numbers as well
+            session->setupPending = FALSE;
+            session->localParams.resync = RESYNC_NONE;
+        }
+        OutputDebugString("Link parameters negotiated\n");
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+    }
+}
+
+BOOL applySetup(const LINK_PARAMS &remote)
+{
+    LINK_PARAMS agreed;
+    agreed.window = max<BYTE>(1, min<BYTE>(session->localParams.window, remote.window));
+    agreed.maxPayload = max<WORD>(PAYLOAD_UNIT,
+        min<WORD>(PACKET_DATA_MAX, min<WORD>(session->localParams.maxPayload, remote.maxPayload)));
+    agreed.compress = min<BYTE>(session->localParams.compress, remote.compress);
+    agreed.adaptive = session->localParams.adaptive && remote.adaptive;
+    agreed.fecParity = min<BYTE>(session->localParams.fecParity, remote.fecParity);
+    agreed.fecDepth = agreed.fecParity ? max<BYTE>(session->localParams.fecDepth, remote.fecDepth) : 1;
+    agreed.burst = min<BYTE>(BURST_MAX_FRAMES, min<BYTE>(session->localParams.burst, remote.burst));
+    agreed.nonce = remote.nonce;
+    agreed.resync = RESYNC_NONE;
+
+    // a retry of the setup the link already runs with, the frames in flight keep their numbers; a peer
+    // that gave up a send goes on from the number it sends
+    BOOL restarted = session->linkReady && agreed.nonce != session->linkParams.nonce;
+    if (session->linkReady && !restarted && sameParams(agreed, session->linkParams))
+    {
+        if (remote.resync != RESYNC_NONE)
+            session->rxWindow.reset((BYTE) remote.resync, session->linkParams.window);
+        return TRUE;
+    }
+    // both sides have to switch between two sends, not in the middle of one; a peer that started
+    // over has none of our send any more
+    if (session->transfer.window)
+    {
+        if (!restarted)
+            return FALSE;
+        finishTransfer();
+    }
+    session->linkParams = agreed;
+
+    // both directions restart their sequence numbers on a new link, but for a send given up that the
+    // peer has not been told of yet, or one the peer gave up
+    session->txSeq = session->localParams.resync == RESYNC_NONE ? 0 : (BYTE) session->localParams.resync;
+    // and the frame size, from the usual one, with a fresh estimate of the line
+    session->txPayload = session->linkParams.adaptive ? min<WORD>(PACKET_DATA_SIZE, session->linkParams.maxPayload) :
+        session->linkParams.maxPayload;
+    session->linkQuality.reset();
+    session->sizeTrace.clear();
+    session->rxWindow.reset(remote.resync == RESYNC_NONE ? 0 : (BYTE) remote.resync, session->linkParams.window);
+    session->linkReady = TRUE;
+    return TRUE;
+}
+
+BOOL sameParams(const LINK_PARAMS &a, const LINK_PARAMS &b)
+{
+    return a.window == b.window && a.maxPayload == b.maxPayload && a.compress == b.compress &&
+        a.adaptive == b.adaptive && a.fecParity == b.fecParity && a.fecDepth == b.fecDepth && a.burst == b.burst;
+    // the nonce says who the peer is, not how the link runs
+}
+
+string encodeSetup(BYTE kind, const LINK_PARAMS &params)
+{
+    string body;
+    body += (char) PARAM_WINDOW;
+    body += (char) params.window;
+    body += (char) PARAM_MAX_PAYLOAD;
+    body += (char) min<WORD>(0xFF, params.maxPayload / PAYLOAD_UNIT);
+    body += (char) PARAM_COMPRESS;
+    body += (char) params.compress;
+    body += (char) PARAM_ADAPTIVE;
+    body += (char) (params.adaptive ? 1 : 0);
+    body += (char) PARAM_FEC;
+    body += (char) params.fecParity;
+    body += (char) PARAM_INTERLEAVE;
+    body += (char) params.fecDepth;
+    body += (char) PARAM_BURST;
+    body += (char) params.burst;
+    body += (char) PARAM_NONCE;
+    for (int shift = 24; shift >= 0; shift -= 8)
+        body += (char) (params.nonce >> shift);
+    if (params.resync != RESYNC_NONE)
+    {
+        body += (char) PARAM_RESYNC;
+        body += (char) params.resync;
+    }
+
+    string frame;
+    frame += (char) kind;
+    frame += (char) body.length();
+    frame += body;
+    frame += CRCtoString(calculateCRC16(frame));
+    return string(1, (char) SOH) + frame;
+}
+
+BOOL decodeSetup(const char *body, DWORD len, LINK_PARAMS *params)
+{
+    // unknown parameter types are skipped so newer stations can talk to older ones; the type says
+    // how long the value is
+    for (DWORD i = 0; i < len; )
+    {
+        BYTE type = (BYTE) body[i];
+        DWORD width = type & PARAM_WIDE ? 4 : 1;
+        if (i + 1 + width > len)
+            break;
+        const BYTE *value = (const BYTE *) body + i + 1;
+        i += 1 + width;
+
+        switch (type)
+        {
+        case PARAM_WINDOW:
+            params->window = value[0];
+            break;
+        case PARAM_MAX_PAYLOAD:
+            params->maxPayload = (WORD)(value[0] * PAYLOAD_UNIT);
+            break;
+        case PARAM_COMPRESS:
+            params->compress = min<BYTE>(value[0], COMPRESS_LZ_DICT);
+            break;
+        case PARAM_ADAPTIVE:
+            params->adaptive = value[0] != 0;
+            break;
+        case PARAM_FEC:
+            // whole pairs of check symbols, each pair fixes one byte
+            params->fecParity = (BYTE) (min<BYTE>(value[0], FEC_MAX_PARITY) & ~1);
+            break;
+        case PARAM_INTERLEAVE:
+            params->fecDepth = max<BYTE>(1, min<BYTE>(value[0], FEC_MAX_DEPTH));
+            break;
+        case PARAM_BURST:
+            params->burst = value[0];
+            break;
+        case PARAM_NONCE:
+            params->nonce = (DWORD) value[0] << 24 | (DWORD) value[1] << 16 | (DWORD) value[2] << 8 | value[3];
+            break;
+        case PARAM_RESYNC:
+            params->resync = value[0];
+            break;
+        }
+    }
+
+    return params->window > 0 && params->maxPayload > 0;
+}
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     LinkSetup.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and function declarations for the parameter
+-- exchange performed when a link is connected.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef LINK_SETUP_H
+#define LINK_SETUP_H
+#include "Common.h"
+
+// SOH | kind | length | parameters (type, value) | CRC16; a value is one byte, four most significant
+// first for the types with PARAM_WIDE set
+#define PARAM_WIDE          0x80
+#define SETUP_REQUEST       0x01
+#define SETUP_REPLY         0x02
+#define SETUP_HEADER_SIZE   2
+#define SETUP_MAX_BODY      64
+
+// parameter types
+#define PARAM_WINDOW        0x01
+// largest payload, in PAYLOAD_UNIT bytes
+#define PARAM_MAX_PAYLOAD   0x02
+// compression mode, COMPRESS_NONE when absent
+#define PARAM_COMPRESS      0x03
+// 1 when the station takes frames of any size up to the maximum, fixed-size frames when absent
+#define PARAM_ADAPTIVE      0x04
+// Reed-Solomon check symbols per codeword, no FEC when absent or 0
+#define PARAM_FEC           0x05
+// least codewords a frame is spread over, 1 when absent
+#define PARAM_INTERLEAVE    0x06
+// most frames one won bid carries, window after window; a window per bid when absent or 0
+#define PARAM_BURST         0x07
+// drawn by the station when it starts; a new one from the peer means it started over, 0 when absent
+#define PARAM_NONCE         (PARAM_WIDE | 0x08)
+// sent by a station that gave up a send, the sequence number of its next frame; the peer's receive
+// window starts over there. Only sent until the peer has answered
+#define PARAM_RESYNC        0x09
+#define RESYNC_NONE         0xFFFF
+
+#define PAYLOAD_UNIT        64
+
+// Frames per bid this station offers, and the most it agrees to whatever the peer offers, so the
+// peer is never kept off the line for long
+#define BURST_FRAMES        32
+#define BURST_MAX_FRAMES    64
+
+// Link parameters offered by a station or agreed for the link
+struct LINK_PARAMS {
+    BYTE window;
+    WORD maxPayload;
+    BYTE compress;
+    BYTE adaptive;      // the sender may size frames by the link quality
+    BYTE fecParity;     // check symbols per codeword, 0 sends frames without FEC
+    BYTE fecDepth;      // least codewords per frame, more spread a burst of errors thinner
+    BYTE burst;         // most frames per won bid, 0 gives up the line after every window
+    DWORD nonce;        // not agreed on, ours in the offer and the peer's once the link is set up
+    WORD resync;        // not agreed on, our next sequence number in the offer, RESYNC_NONE when absent
+};
+
+// function prototypes
+VOID requestSetup();
+VOID receiveSetup();
+BOOL applySetup(const LINK_PARAMS &remote);
+BOOL sameParams(const LINK_PARAMS &a, const LINK_PARAMS &b);
+std::string encodeSetup(BYTE kind, const LINK_PARAMS &params);
+BOOL decodeSetup(const char *body, DWORD len, LINK_PARAMS *params);
+#endif
@@ -10,15 +10,16 @@
 --              DWORD WINAPI createFileWriter(LPVOID lpParam);
 --              void loadFile(const HWND *box, LPSTR file);
 --              void addLine(const HWND *box, std::string line);
---              vector<std::string> parseData();
 --              string getLine(const HWND *box, int line, int flag);
 --              void setupProgressBar(const HWND *box);
 --              void updateProgressBar(int currentPos);
 --              int getLines(const HWND *box);
---              void saveFile(const HWND *box, LPSTR file);
+--              void saveFile(LPSTR file);
 --              void clearBox(const HWND *box);
 --              void clearStats();
 --              void updateStats(int stat, int label);
+--              void refreshStats();
+--              void refreshReceived();
 --
 -- DATE:        December 3, 2016
 --
@@ -30,6 +31,7 @@
 -- This program is designed to create a file opener and handle file loading and saving.
 ----------------------------------------------------------------------------------------------------------------------*/
 #include "OpenFile.h"
+#include "LinkSession.h"
 using namespace std;
 
 // file opener dialog structure.
@@ -59,8 +61,14 @@ int progressSize;
 // file path
 char szFile[FILE_NAME_LEN];
 
-// vector to contain strings from sender control
-vector<std::string> v_packets;
+// counters as the stats labels show them
+FILE_STATISTICS shownStats;
+
+// bytes received when the receive panel was last redrawn
+uint64_t shownBytes;
+
+// a file is loaded for the next send; the engine has the file itself, this is the dialog's view of it
+BOOL fileLoaded;
 
 regex addNewLine("(?!\r)\n");
 
@@ -90,45 +98,39 @@ DWORD WINAPI createFileWriter(LPVOID lpParam) {
 }
 
 void loadFile(const HWND *box, LPSTR file) {
-    int idx;
-    string tmp;
-    ifstream input(file);
     clearBox(box);
     SendMessage(*box, EM_SETREADONLY, (LPARAM) FALSE, NULL);
 
-    while (getline(input, tmp)) {
-        tmp += "\n";
-        idx = GetWindowTextLength(*box);
-        SendMessage(*box, EM_SETSEL, (LPARAM) idx, (LPARAM) idx);
-        SendMessage(*box, EM_REPLACESEL, 0, (LPARAM) (tmp.c_str()));
+    // the engine sends the file from a mapping of its own, the panel only shows the start of it
+    FileSource source;
+    if (!source.open(file)) {
+        MessageBox(NULL, "Failed to open the file", "Error", MB_OK);
+        return;
     }
+    postCommand(ENGINE_CMD_LOAD, NULL, NULL, NULL, file);
+    fileLoaded = TRUE;
+
+    string preview;
+    for (char c : source.preview(FILE_PREVIEW_SIZE)) {
+        if (c == '\n' && (preview.empty() || preview.back() != '\r'))
+            preview += '\r';
+        preview += c;
+    }
+    if (source.size() > FILE_PREVIEW_SIZE)
+        preview += "\r\n... " + to_string(source.size()) + " bytes, sent from the file\r\n";
+
+    SetWindowText(*box, preview.c_str());
+    SendMessage(*box, EM_SETREADONLY, (LPARAM) TRUE, NULL);
     sendLines = SendMessage(*box, EM_GETLINECOUNT, NULL, NULL);
 
     setupProgressBar(&hSendPanel);
-    input.close();
 }
 
-void saveFile(const HWND *box, LPSTR file) {
-    size_t onLine = 0;
-    size_t totalLines = getLines(box);
-    ofstream output(file);
-
-    for (; onLine < totalLines; onLine++) {
-        //output << getLine(box, onLine, 1) << endl;
-        string s = getLine(box, onLine, 1);
-        s.erase(remove_if(s.begin(), s.end(), INVALID_CHAR()), s.end());
-        for (auto& c : s) {
-            if (c == '\r' || c == '\n') {
-                output << endl;
-            }
-            else {
-                output << c;
-            }
-        }
-        output << endl;
+void saveFile(LPSTR file) {
+    // the received data is in the sink's file already, the panel only has the tail of it
+    if (!session->fileSink.saveAs(file)) {
+        MessageBox(NULL, "Failed to save the file", "Error", MB_OK);
     }
-
-    output.close();
 }
 
 void clearBox(const HWND *box) {
@@ -139,24 +141,6 @@ int getLines(const HWND *box) {
     return SendMessage(*box, EM_GETLINECOUNT, NULL, NULL);
 }
 
-std::vector<std::string> parseData() {
-    if (sendLines < 1) {
-        sendLines = getLines(&hSendPanel);
-    }
-
-    rawStr = "";
-    for (int i = 0; i < sendLines; i++) {
-        rawStr += getLine(&hSendPanel, i, 0);
-        updateProgressBar(i);
-    }
-
-    fileSize = rawStr.length();
-
-    v_packets.clear();
-    v_packets = parketize();
-    return v_packets;
-}
-
 void initFileOpener() {
     ZeroMemory(&fileName, sizeof(fileName));
     fileName.lStructSize = sizeof(fileName);
@@ -206,4 +190,44 @@ void clearStats() {
             SendMessage(GetDlgItem(hDlg, label), WM_SETTEXT, NULL, (LPARAM) "0");
         }
     }
-}
\ No newline at end of file
+}
+
+void refreshStats() {
+    // runs on the dialog's timer, only the labels whose counter moved are redrawn
+    FILE_STATISTICS s = session->stats.snapshot();
+
+    if (s.packetSent != shownStats.packetSent) {
+        updateStats(s.packetSent, IDC_SDATA0);
+    }
+    if (s.packetLost != shownStats.packetLost) {
+        updateStats(s.packetLost, IDC_SDATA1);
+    }
+    if (s.packetReceived != shownStats.packetReceived) {
+        updateStats(s.packetReceived, IDC_SDATA2);
+    }
+    if (s.packetCorrupted != shownStats.packetCorrupted) {
+        updateStats(s.packetCorrupted, IDC_SDATA3);
+    }
+    if (s.acksReceived != shownStats.acksReceived) {
+        updateStats(s.acksReceived, IDC_SDATA4);
+    }
+    if (s.bitErrorRate != shownStats.bitErrorRate) {
+        updateStats(s.bitErrorRate, IDC_SDATA6);
+    }
+
+    shownStats = s;
+}
+
+void refreshReceived() {
+    // runs on the same timer, the panel shows the last few kilobytes and never grows
+    uint64_t bytes = session->fileSink.bytes();
+    if (bytes == shownBytes) {
+        return;
+    }
+
+    string text = session->fileSink.tail();
+    text.erase(remove_if(text.begin(), text.end(), INVALID_CHAR()), text.end());
+    SetWindowText(hReadPanel, regex_replace(text, addNewLine, "\r\n").c_str());
+    SendMessage(hReadPanel, EM_LINESCROLL, NULL, (LPARAM) getLines(&hReadPanel));
+    shownBytes = bytes;
+}
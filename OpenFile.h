@@ -14,10 +14,17 @@
 #ifndef OPENFILE_H
 #define OPENFILE_H
 #include "Common.h"
+#ifdef _WIN32
 #include <commctrl.h>
+#endif
 #include <iostream>
 extern HWND hSendPanel;
 extern HWND hReadPanel;
+extern HWND hDlg;
+// the max size of the progress bar
+extern int progressSize;
+// a file is loaded for the next send
+extern BOOL fileLoaded;
 
 // function prototypes
 void initFileOpener();
@@ -26,13 +33,14 @@ DWORD WINAPI createFileReader(LPVOID lpParam);
 DWORD WINAPI createFileWriter(LPVOID lpParam);
 void loadFile(const HWND *box, LPSTR file);
 void addLine(const HWND *box, std::string line);
-std::vector<std::string> parseData();
 std::string getLine(const HWND *box, int line, int flag);
 void setupProgressBar(const HWND *box);
 void updateProgressBar(int currentPos);
 int getLines(const HWND *box);
-void saveFile(const HWND *box, LPSTR file);
+void saveFile(LPSTR file);
 void clearBox(const HWND *box);
 void clearStats();
 void updateStats(int stat, int label);
+void refreshStats();
+void refreshReceived();
 #endif
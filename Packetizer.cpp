@@ -0,0 +1,182 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Packetizer.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  BOOL startPacketizer();
+--                  DWORD WINAPI packetizeThread(LPVOID);
+--                  BOOL cutPayloads(std::string &pending, BOOL last, FrameQueue &queue);
+--                  BOOL nextText(FrameQueue &queue, std::string &pending, std::string &payload, size_t maxSize);
+--                  static size_t textBlock(size_t maxPayload, BYTE mode);
+--                  std::string buildFrame(BYTE seq, BYTE flags, const std::string &payload);
+--                  size_t frameSize(size_t payload);
+--                  uint16_t calculateCRC16(const std::string &data);
+--                  std::string CRCtoString(uint16_t crc);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Splits the text gathered from the send panel into payloads of at most the agreed size and frames
+-- them as SYN | SEQ | FLAGS | LEN | DATA | CRC16. LEN is the payload size, big endian, and the CRC
+-- covers SEQ, FLAGS, LEN and DATA. When the link agreed on compression, the text goes through the
+-- compression stage instead and every payload is a compressed block. When it agreed on FEC, the
+-- Reed-Solomon check bytes of everything from SEQ to the CRC follow the CRC.
+--
+-- A send of the panel text does not wait for all of it. The packetizer thread reads the panel a
+-- line at a time and puts the text in the send queue a block at a time, while the engine sends the
+-- ones before it. The window cuts its payloads from the blocks at the payload size it is at, the way
+-- a file's are cut from its mapping, so the frame size the sender adapts applies to text too. A
+-- payload is framed only when it goes on the line, since its sequence number is not known before.
+-- The engine never waits on the queue: while the packetizer has not cut enough yet, nextText()
+-- hands the window nothing and the engine goes on answering the line.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Packetizer.h"
+#include "LinkSession.h"
+using namespace std;
+
+FrameQueue sendQueue(FRAME_QUEUE_DEPTH);
+
+BOOL startPacketizer()
+{
+    HANDLE thread;
+
+    // the last text sent may still be going out
+    if (!sendQueue.open())
+        return FALSE;
+    if ((thread = CreateThread(NULL, 0, packetizeThread, NULL, 0, NULL)) == NULL)
+    {
+        sendQueue.finish();
+        sendQueue.close();
+        return FALSE;
+    }
+
+    CloseHandle(thread);
+    return TRUE;
+}
+
+DWORD WINAPI packetizeThread(LPVOID)
+{
+    try {
+        string pending;
+        int lines = getLines(&hSendPanel);
+
+        for (int i = 0; i < lines; i++)
+        {
+            pending += getLine(&hSendPanel, i, 0);
+            if (!cutPayloads(pending, i == lines - 1, sendQueue))
+                break;
+        }
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+    }
+
+    sendQueue.finish();
+    return 0;
+}
+
+static size_t textBlock(size_t maxPayload, BYTE mode)
+{
+    // as much text as compressNext() would try to fit in one payload
+    return mode == COMPRESS_NONE ? maxPayload : min<size_t>((maxPayload - 1) * COMPRESS_SPAN, COMPRESS_MAX_RAW);
+}
+
+BOOL cutPayloads(string &pending, BOOL last, FrameQueue &queue)
+{
+    // a block holds as much text as a payload of the agreed maximum could take, whatever size the
+    // window is at when it gets to it
+    size_t block = textBlock(session->linkParams.maxPayload, session->linkParams.compress);
+    size_t cut = 0;
+
+    while (pending.length() - cut >= block || (last && cut < pending.length()))
+    {
+        size_t taken = min<size_t>(pending.length() - cut, block);
+        string text = pending.substr(cut, taken);
+        // the send was cancelled
+        if (!queue.push(text))
+            return FALSE;
+        cut += taken;
+    }
+
+    pending.erase(0, cut);
+    return TRUE;
+}
+
+BOOL nextText(FrameQueue &queue, string &pending, string &payload, size_t maxSize)
+{
+    BYTE mode = session->linkParams.compress;
+    string text;
+
+    // a cancelled send stops with the frames already in the window
+    if (queue.isCancelled())
+        return FALSE;
+
+    // enough text for a payload of this size, or all that is left once the packetizer is done; the
+    // last push comes before finish(), so a queue finished before it is drained has nothing after
+    BOOL finished = queue.isFinished();
+    while (pending.length() < textBlock(maxSize, mode) && queue.tryPop(text))
+        pending += text;
+    if (pending.length() < textBlock(maxSize, mode) && !finished)
+    {
+        payload.clear();
+        return TRUE;
+    }
+    if (pending.empty())
+        return FALSE;
+
+    size_t taken = min<size_t>(pending.length(), maxSize);
+    payload = mode == COMPRESS_NONE ? pending.substr(0, taken) :
+        compressNext(pending.data(), pending.length(), maxSize, mode, &taken);
+    pending.erase(0, taken);
+    return TRUE;
+}
+
+string buildFrame(BYTE seq, BYTE flags, const string &payload)
+{
+    size_t len = min<size_t>(payload.length(), PACKET_DATA_MAX);
+
+    string frame;
+    frame.reserve(frameSize(len));
+    frame += (char) SYN;
+    frame += (char) seq;
+    frame += (char) flags;
+    frame += (char)(len >> 8);
+    frame += (char)(len & 0xFF);
+    frame.append(payload, 0, len);
+    frame += CRCtoString(crc16((const uint8_t*) frame.data() + PACKET_SEQ_INDEX, frame.length() - PACKET_SEQ_INDEX));
+
+    size_t covered = frame.length() - PACKET_SEQ_INDEX;
+    size_t check = fecParitySize(covered, session->linkParams.fecParity, session->linkParams.fecDepth);
+    if (check > 0)
+    {
+        frame.resize(frame.length() + check);
+        fecEncode((const uint8_t*) &frame[PACKET_SEQ_INDEX], covered, session->linkParams.fecParity,
+            session->linkParams.fecDepth, (uint8_t*) &frame[PACKET_SEQ_INDEX + covered]);
+    }
+    return frame;
+}
+
+size_t frameSize(size_t payload)
+{
+    size_t covered = PACKET_OVERHEAD - PACKET_SEQ_INDEX + payload;
+    return PACKET_OVERHEAD + payload +
+        fecParitySize(covered, session->linkParams.fecParity, session->linkParams.fecDepth);
+}
+
+uint16_t calculateCRC16(const string &data)
+{
+    return crc16((const uint8_t*) data.data(), data.length());
+}
+
+string CRCtoString(uint16_t crc)
+{
+    string s;
+    s += (char)(crc >> 8);
+    s += (char)(crc & 0xFF);
+    return s;
+}
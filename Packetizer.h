@@ -0,0 +1,31 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Packetizer.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and function declarations used to split the
+-- outgoing text into payloads, to hand them to the engine through the send queue, and to frame them
+-- for the line.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef PACKETIZER_H
+#define PACKETIZER_H
+#include "Common.h"
+
+// blocks of the text being sent, cut by the packetizer thread and taken by the engine
+extern FrameQueue sendQueue;
+
+// function prototypes
+BOOL startPacketizer();
+DWORD WINAPI packetizeThread(LPVOID);
+BOOL cutPayloads(std::string &pending, BOOL last, FrameQueue &queue);
+BOOL nextText(FrameQueue &queue, std::string &pending, std::string &payload, size_t maxSize);
+std::string buildFrame(BYTE seq, BYTE flags, const std::string &payload);
+size_t frameSize(size_t payload);
+uint16_t calculateCRC16(const std::string &data);
+std::string CRCtoString(uint16_t crc);
+#endif
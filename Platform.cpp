@@ -0,0 +1,990 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Platform.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  HANDLE CreateEvent(LPVOID, BOOL manualReset, BOOL initialState, LPCSTR);
+--                  BOOL SetEvent(HANDLE event);
+--                  BOOL ResetEvent(HANDLE event);
+--                  HANDLE CreateMutex(LPVOID, BOOL initialOwner, LPCSTR);
+--                  BOOL ReleaseMutex(HANDLE mutex);
+--                  DWORD WaitForSingleObject(HANDLE handle, DWORD msec);
+--                  BOOL CloseHandle(HANDLE handle);
+--                  HANDLE CreateThread(LPVOID, size_t, LPTHREAD_START_ROUTINE start, LPVOID param, DWORD,
+--                                      DWORD *threadId);
+--                  VOID ExitThread(DWORD exitCode);
+--                  HANDLE CreateFile(LPCSTR path, DWORD access, DWORD, LPVOID, DWORD disposition, DWORD flags,
+--                                    HANDLE);
+--                  BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD size, DWORD *read, OVERLAPPED *ov);
+--                  BOOL WriteFile(HANDLE file, const void *buffer, DWORD size, DWORD *written, OVERLAPPED *ov);
+--                  BOOL GetOverlappedResult(HANDLE file, OVERLAPPED *ov, DWORD *transferred, BOOL wait);
+--                  BOOL CancelIo(HANDLE file);
+--                  BOOL SetCommMask(HANDLE port, DWORD mask);
+--                  BOOL WaitCommEvent(HANDLE port, DWORD *mask, OVERLAPPED *ov);
+--                  BOOL ClearCommError(HANDLE port, DWORD *errors, COMSTAT *stat);
+--                  BOOL PurgeComm(HANDLE port, DWORD flags);
+--                  BOOL GetCommState(HANDLE port, DCB *dcb);
+--                  BOOL SetCommState(HANDLE port, DCB *dcb);
+--                  BOOL BuildCommDCB(LPCSTR def, DCB *dcb);
+--                  HANDLE CreateFileMapping(HANDLE file, LPVOID, DWORD, DWORD, DWORD, LPCSTR);
+--                  LPVOID MapViewOfFile(HANDLE mapping, DWORD, DWORD offsetHigh, DWORD offsetLow, size_t size);
+--                  BOOL UnmapViewOfFile(const void *view);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- POSIX implementation of the Win32 calls declared in Platform.h. Handles point to small objects
+-- (events, mutexes, threads, files, mappings). A comm port is a nonblocking termios fd:
+--
+-- - An overlapped ReadFile() with nothing buffered stays pending on its event, and the read
+--   happens in WaitForSingleObject() when the fd becomes readable.
+-- - WriteFile() completes before it returns.
+-- - SetCommMask() wakes a thread blocked in WaitCommEvent() with a mask of 0, like Win32 does.
+--   The engine relies on this to take a queued command while it is idle.
+--
+-- Mutexes are recursive and owned by a thread, as on Windows. The whole file is empty on Windows.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef _WIN32
+#include "Platform.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+BOOL platformDebugOutput = FALSE;
+
+static thread_local DWORD lastError = ERROR_SUCCESS;
+
+#define OBJ_EVENT       1
+#define OBJ_MUTEX       2
+#define OBJ_THREAD      3
+#define OBJ_FILE        4
+#define OBJ_MAPPING     5
+
+struct PLATFORM_OBJECT {
+    explicit PLATFORM_OBJECT(int type) : type(type) {}
+    virtual ~PLATFORM_OBJECT() {}
+    int type;
+};
+
+// An overlapped read waiting for its fd; it lives on the event passed in the OVERLAPPED
+struct PENDING_READ {
+    int         fd;
+    uint8_t     *buffer;
+    DWORD       size;
+    DWORD       done;
+    DWORD       error;
+    BOOL        active;
+    BOOL        complete;
+    pthread_t   issuer;
+};
+
+struct EVENT_OBJECT : PLATFORM_OBJECT {
+    EVENT_OBJECT(BOOL manual, BOOL signaled)
+        : PLATFORM_OBJECT(OBJ_EVENT), manual(manual), signaled(signaled) { memset(&io, 0, sizeof(io)); }
+    mutex               lock;
+    condition_variable  cv;
+    BOOL                manual;
+    BOOL                signaled;
+    PENDING_READ        io;
+};
+
+struct MUTEX_OBJECT : PLATFORM_OBJECT {
+    MUTEX_OBJECT() : PLATFORM_OBJECT(OBJ_MUTEX), owned(FALSE), count(0) {}
+    mutex               lock;
+    condition_variable  cv;
+    BOOL                owned;
+    pthread_t           owner;
+    DWORD               count;
+};
+
+struct THREAD_OBJECT : PLATFORM_OBJECT {
+    THREAD_OBJECT() : PLATFORM_OBJECT(OBJ_THREAD), finished(TRUE, FALSE) {}
+    EVENT_OBJECT            finished;
+    LPTHREAD_START_ROUTINE  start;
+    LPVOID                  param;
+};
+
+struct FILE_OBJECT : PLATFORM_OBJECT {
+    FILE_OBJECT() : PLATFORM_OBJECT(OBJ_FILE), fd(-1), port(FALSE), mask(0), waiting(FALSE)
+    {
+        wake[0] = wake[1] = -1;
+        memset(&timeouts, 0, sizeof(timeouts));
+    }
+    int                     fd;
+    BOOL                    port;
+    int                     wake[2];
+    DWORD                   mask;
+    BOOL                    waiting;
+    COMMTIMEOUTS            timeouts;
+    mutex                   lock;
+    vector<EVENT_OBJECT*>   pending;
+};
+
+struct MAPPING_OBJECT : PLATFORM_OBJECT {
+    MAPPING_OBJECT() : PLATFORM_OBJECT(OBJ_MAPPING), fd(-1) {}
+    int fd;
+};
+
+template <class T>
+static T *object(HANDLE h, int type)
+{
+    PLATFORM_OBJECT *o = (PLATFORM_OBJECT*) h;
+    if (!o || h == INVALID_HANDLE_VALUE || o->type != type)
+    {
+        lastError = ERROR_INVALID_HANDLE;
+        return NULL;
+    }
+    return static_cast<T*>(o);
+}
+
+static int remaining(chrono::steady_clock::time_point deadline)
+{
+    auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+    return (int) max<long long>(0, left);
+}
+
+// waits for fd to become readable; -1 waits forever
+static BOOL waitReadable(int fd, int msec)
+{
+    struct pollfd p = { fd, POLLIN, 0 };
+    int r;
+    while ((r = poll(&p, 1, msec)) < 0 && errno == EINTR)
+        ;
+    return r > 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- events, mutexes and threads
+----------------------------------------------------------------------------------------------------------------------*/
+HANDLE CreateEvent(LPVOID, BOOL manualReset, BOOL initialState, LPCSTR)
+{
+    return new EVENT_OBJECT(manualReset, initialState);
+}
+
+BOOL SetEvent(HANDLE event)
+{
+    EVENT_OBJECT *e = object<EVENT_OBJECT>(event, OBJ_EVENT);
+    if (!e)
+        return FALSE;
+
+    lock_guard<mutex> guard(e->lock);
+    e->signaled = TRUE;
+    if (e->manual)
+        e->cv.notify_all();
+    else
+        e->cv.notify_one();
+    return TRUE;
+}
+
+BOOL ResetEvent(HANDLE event)
+{
+    EVENT_OBJECT *e = object<EVENT_OBJECT>(event, OBJ_EVENT);
+    if (!e)
+        return FALSE;
+
+    lock_guard<mutex> guard(e->lock);
+    e->signaled = FALSE;
+    return TRUE;
+}
+
+HANDLE CreateMutex(LPVOID, BOOL initialOwner, LPCSTR)
+{
+    MUTEX_OBJECT *m = new MUTEX_OBJECT();
+    if (initialOwner)
+    {
+        m->owned = TRUE;
+        m->owner = pthread_self();
+        m->count = 1;
+    }
+    return m;
+}
+
+BOOL ReleaseMutex(HANDLE mutexHandle)
+{
+    MUTEX_OBJECT *m = object<MUTEX_OBJECT>(mutexHandle, OBJ_MUTEX);
+    if (!m)
+        return FALSE;
+
+    lock_guard<mutex> guard(m->lock);
+    // only the owner may release, like Win32
+    if (!m->owned || !pthread_equal(m->owner, pthread_self()))
+    {
+        lastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+    if (--m->count == 0)
+    {
+        m->owned = FALSE;
+        m->cv.notify_one();
+    }
+    return TRUE;
+}
+
+// runs the pending read of an event once its fd is readable
+static DWORD waitPendingRead(EVENT_OBJECT *e, DWORD msec)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(msec == INFINITE ? 0 : msec);
+
+    for (;;)
+    {
+        {
+            lock_guard<mutex> guard(e->lock);
+            if (!e->io.active || e->io.complete)
+                return WAIT_OBJECT_0;
+        }
+
+        int left = msec == INFINITE ? -1 : remaining(deadline);
+        if (!waitReadable(e->io.fd, left))
+        {
+            if (left == 0)
+                return WAIT_TIMEOUT;
+            continue;
+        }
+
+        ssize_t n = read(e->io.fd, e->io.buffer, e->io.size);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR))
+            continue;
+
+        // 0 is the other end going away, report it as a failed read
+        lock_guard<mutex> guard(e->lock);
+        e->io.complete = TRUE;
+        e->io.done = n > 0 ? (DWORD) n : 0;
+        e->io.error = n > 0 ? ERROR_SUCCESS : ERROR_OPERATION_ABORTED;
+        e->signaled = TRUE;
+        return WAIT_OBJECT_0;
+    }
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD msec)
+{
+    PLATFORM_OBJECT *o = (PLATFORM_OBJECT*) handle;
+    if (!o || handle == INVALID_HANDLE_VALUE)
+    {
+        lastError = ERROR_INVALID_HANDLE;
+        return WAIT_FAILED;
+    }
+
+    if (o->type == OBJ_THREAD)
+        return WaitForSingleObject(&static_cast<THREAD_OBJECT*>(o)->finished, msec);
+
+    if (o->type == OBJ_EVENT)
+    {
+        EVENT_OBJECT *e = static_cast<EVENT_OBJECT*>(o);
+        if (e->io.active && !e->io.complete)
+            return waitPendingRead(e, msec);
+
+        unique_lock<mutex> guard(e->lock);
+        auto ready = [e] { return e->signaled != FALSE; };
+        if (msec == INFINITE)
+            e->cv.wait(guard, ready);
+        else if (!e->cv.wait_for(guard, chrono::milliseconds(msec), ready))
+            return WAIT_TIMEOUT;
+        if (!e->manual)
+            e->signaled = FALSE;
+        return WAIT_OBJECT_0;
+    }
+
+    if (o->type == OBJ_MUTEX)
+    {
+        MUTEX_OBJECT *m = static_cast<MUTEX_OBJECT*>(o);
+        unique_lock<mutex> guard(m->lock);
+        pthread_t self = pthread_self();
+        auto ready = [m, self] { return !m->owned || pthread_equal(m->owner, self); };
+        if (msec == INFINITE)
+            m->cv.wait(guard, ready);
+        else if (!m->cv.wait_for(guard, chrono::milliseconds(msec), ready))
+            return WAIT_TIMEOUT;
+        m->owned = TRUE;
+        m->owner = self;
+        m->count++;
+        return WAIT_OBJECT_0;
+    }
+
+    lastError = ERROR_INVALID_HANDLE;
+    return WAIT_FAILED;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+    PLATFORM_OBJECT *o = (PLATFORM_OBJECT*) handle;
+    if (!o || handle == INVALID_HANDLE_VALUE)
+    {
+        lastError = ERROR_INVALID_HANDLE;
+        return FALSE;
+    }
+
+    switch (o->type)
+    {
+    case OBJ_FILE: {
+        FILE_OBJECT *f = static_cast<FILE_OBJECT*>(o);
+        close(f->fd);
+        if (f->port)
+        {
+            close(f->wake[0]);
+            close(f->wake[1]);
+        }
+        break;
+    }
+    case OBJ_MAPPING:
+        close(static_cast<MAPPING_OBJECT*>(o)->fd);
+        break;
+    case OBJ_THREAD:
+        // the thread may still be running and owns the object, it is kept
+        return TRUE;
+    }
+
+    delete o;
+    return TRUE;
+}
+
+// marks the thread finished however it ends, ExitThread() included
+struct THREAD_EXIT {
+    THREAD_OBJECT *thread;
+    ~THREAD_EXIT() { SetEvent(&thread->finished); }
+};
+
+static void *threadStart(void *arg)
+{
+    THREAD_OBJECT *t = (THREAD_OBJECT*) arg;
+    THREAD_EXIT done = { t };
+    t->start(t->param);
+    return NULL;
+}
+
+HANDLE CreateThread(LPVOID, size_t, LPTHREAD_START_ROUTINE start, LPVOID param, DWORD, DWORD *threadId)
+{
+    THREAD_OBJECT *t = new THREAD_OBJECT();
+    t->start = start;
+    t->param = param;
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, threadStart, t) != 0)
+    {
+        delete t;
+        return NULL;
+    }
+    pthread_detach(tid);
+
+    static DWORD nextId = 1;
+    if (threadId)
+        *threadId = __sync_fetch_and_add(&nextId, 1);
+    return t;
+}
+
+VOID ExitThread(DWORD)
+{
+    pthread_exit(NULL);
+}
+
+VOID Sleep(DWORD msec)
+{
+    usleep((useconds_t) msec * 1000);
+}
+
+DWORD GetTickCount()
+{
+    return (DWORD) chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+DWORD GetLastError()
+{
+    return lastError;
+}
+
+VOID SetLastError(DWORD error)
+{
+    lastError = error;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- files and comm ports
+----------------------------------------------------------------------------------------------------------------------*/
+static speed_t baudToSpeed(DWORD baud)
+{
+    switch (baud)
+    {
+    case 1200:      return B1200;
+    case 2400:      return B2400;
+    case 4800:      return B4800;
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 115200:    return B115200;
+    case 230400:    return B230400;
+    }
+    return B0;
+}
+
+static DWORD speedToBaud(speed_t speed)
+{
+    const DWORD bauds[] = { 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400 };
+    for (DWORD baud : bauds)
+        if (baudToSpeed(baud) == speed)
+            return baud;
+    return 0;
+}
+
+HANDLE CreateFile(LPCSTR path, DWORD access, DWORD, LPVOID, DWORD disposition, DWORD flags, HANDLE)
+{
+    FILE_OBJECT *f = new FILE_OBJECT();
+
+    // overlapped handles are the comm port, everything else is a plain file
+    f->port = (flags & FILE_FLAG_OVERLAPPED) != 0;
+    if (f->port)
+    {
+        f->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    }
+    else
+    {
+        int mode = (access & GENERIC_WRITE) ? ((access & GENERIC_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+        if (disposition == CREATE_ALWAYS)
+            mode |= O_CREAT | O_TRUNC;
+        f->fd = open(path, mode, 0644);
+    }
+
+    if (f->fd < 0 || (f->port && pipe(f->wake) != 0))
+    {
+        lastError = (DWORD) errno;
+        if (f->fd >= 0)
+            close(f->fd);
+        delete f;
+        return INVALID_HANDLE_VALUE;
+    }
+
+    if (f->port)
+    {
+        fcntl(f->wake[0], F_SETFL, O_NONBLOCK);
+        fcntl(f->wake[1], F_SETFL, O_NONBLOCK);
+
+        // raw 9600 8N1 until SetCommState() says otherwise; pipes and sockets are taken as they are
+        struct termios tio;
+        if (tcgetattr(f->fd, &tio) == 0)
+        {
+            cfmakeraw(&tio);
+            tio.c_cflag |= CLOCAL | CREAD;
+            tio.c_cc[VMIN] = 0;
+            tio.c_cc[VTIME] = 0;
+            cfsetispeed(&tio, B9600);
+            cfsetospeed(&tio, B9600);
+            tcsetattr(f->fd, TCSANOW, &tio);
+        }
+    }
+
+    return f;
+}
+
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD size, DWORD *readBytes, OVERLAPPED *ov)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(file, OBJ_FILE);
+    if (!f)
+        return FALSE;
+    if (readBytes)
+        *readBytes = 0;
+
+    if (!f->port)
+    {
+        ssize_t n = read(f->fd, buffer, size);
+        if (n < 0)
+        {
+            lastError = (DWORD) errno;
+            return FALSE;
+        }
+        if (readBytes)
+            *readBytes = (DWORD) n;
+        return TRUE;
+    }
+
+    ssize_t n = read(f->fd, buffer, size);
+    if (n > 0)
+    {
+        if (readBytes)
+            *readBytes = (DWORD) n;
+        return TRUE;
+    }
+    if (n < 0 && errno != EAGAIN && errno != EINTR)
+    {
+        lastError = (DWORD) errno;
+        return FALSE;
+    }
+
+    // nothing buffered: without an OVERLAPPED wait out the total timeout right here
+    if (!ov || !ov->hEvent)
+    {
+        if (waitReadable(f->fd, (int) f->timeouts.ReadTotalTimeoutConstant))
+        {
+            n = read(f->fd, buffer, size);
+            if (readBytes && n > 0)
+                *readBytes = (DWORD) n;
+        }
+        return TRUE;
+    }
+
+    EVENT_OBJECT *e = object<EVENT_OBJECT>(ov->hEvent, OBJ_EVENT);
+    if (!e)
+        return FALSE;
+    {
+        lock_guard<mutex> guard(e->lock);
+        e->signaled = FALSE;
+        e->io.fd = f->fd;
+        e->io.buffer = (uint8_t*) buffer;
+        e->io.size = size;
+        e->io.done = 0;
+        e->io.error = ERROR_SUCCESS;
+        e->io.active = TRUE;
+        e->io.complete = FALSE;
+        e->io.issuer = pthread_self();
+    }
+    {
+        lock_guard<mutex> guard(f->lock);
+        if (find(f->pending.begin(), f->pending.end(), e) == f->pending.end())
+            f->pending.push_back(e);
+    }
+
+    lastError = ERROR_IO_PENDING;
+    return FALSE;
+}
+
+BOOL WriteFile(HANDLE file, const void *buffer, DWORD size, DWORD *written, OVERLAPPED *ov)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(file, OBJ_FILE);
+    if (!f)
+        return FALSE;
+
+    // the write always completes here, so there is nothing to wait for on ov; a plain file is
+    // written at the offset ov gives, as Windows does
+    const uint8_t *p = (const uint8_t*) buffer;
+    DWORD total = 0;
+    off_t offset = ov ? (off_t) (((uint64_t) ov->OffsetHigh << 32) | ov->Offset) : 0;
+    while (total < size)
+    {
+        ssize_t n = (ov && !f->port) ? pwrite(f->fd, p + total, size - total, offset + total) :
+            write(f->fd, p + total, size - total);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+            {
+                struct pollfd pf = { f->fd, POLLOUT, 0 };
+                poll(&pf, 1, -1);
+                continue;
+            }
+            lastError = (DWORD) errno;
+            break;
+        }
+        total += (DWORD) n;
+    }
+
+    if (written)
+        *written = total;
+    if (ov && ov->hEvent)
+        SetEvent(ov->hEvent);
+    return total == size;
+}
+
+BOOL GetOverlappedResult(HANDLE file, OVERLAPPED *ov, DWORD *transferred, BOOL wait)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(file, OBJ_FILE);
+    EVENT_OBJECT *e = ov ? object<EVENT_OBJECT>(ov->hEvent, OBJ_EVENT) : NULL;
+    if (!f || !e)
+        return FALSE;
+
+    if (wait)
+        waitPendingRead(e, INFINITE);
+
+    BOOL ok;
+    {
+        lock_guard<mutex> guard(e->lock);
+        if (!e->io.complete)
+        {
+            lastError = e->io.active ? ERROR_IO_INCOMPLETE : ERROR_OPERATION_ABORTED;
+            if (transferred)
+                *transferred = 0;
+            if (e->io.active)
+                return FALSE;
+            ok = FALSE;
+        }
+        else
+        {
+            if (transferred)
+                *transferred = e->io.done;
+            lastError = e->io.error;
+            ok = e->io.error == ERROR_SUCCESS;
+        }
+        e->io.active = FALSE;
+        e->io.complete = FALSE;
+    }
+
+    lock_guard<mutex> guard(f->lock);
+    f->pending.erase(remove(f->pending.begin(), f->pending.end(), e), f->pending.end());
+    return ok;
+}
+
+BOOL CancelIo(HANDLE file)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(file, OBJ_FILE);
+    if (!f)
+        return FALSE;
+
+    // only the reads this thread started, like Win32
+    lock_guard<mutex> guard(f->lock);
+    for (EVENT_OBJECT *e : f->pending)
+    {
+        lock_guard<mutex> eguard(e->lock);
+        if (e->io.active && !e->io.complete && pthread_equal(e->io.issuer, pthread_self()))
+        {
+            e->io.active = FALSE;
+            e->signaled = TRUE;
+            e->cv.notify_all();
+        }
+    }
+    return TRUE;
+}
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER *size)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(file, OBJ_FILE);
+    struct stat st;
+    if (!f || fstat(f->fd, &st) != 0)
+        return FALSE;
+
+    size->QuadPart = (LONGLONG) st.st_size;
+    return TRUE;
+}
+
+BOOL SetCommMask(HANDLE port, DWORD mask)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    if (!f || !f->port)
+        return FALSE;
+
+    lock_guard<mutex> guard(f->lock);
+    f->mask = mask;
+    // a pending WaitCommEvent() returns with no events
+    if (f->waiting)
+    {
+        char c = 0;
+        if (write(f->wake[1], &c, 1) < 0)
+            lastError = (DWORD) errno;
+    }
+    return TRUE;
+}
+
+BOOL WaitCommEvent(HANDLE port, DWORD *mask, OVERLAPPED *)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    if (!f || !f->port)
+        return FALSE;
+
+    char drain[16];
+    {
+        lock_guard<mutex> guard(f->lock);
+        // a mask change from before this wait does not end it
+        while (read(f->wake[0], drain, sizeof(drain)) > 0)
+            ;
+        f->waiting = TRUE;
+    }
+
+    struct pollfd p[2] = { { f->fd, POLLIN, 0 }, { f->wake[0], POLLIN, 0 } };
+    while (poll(p, 2, -1) < 0 && errno == EINTR)
+        ;
+
+    lock_guard<mutex> guard(f->lock);
+    f->waiting = FALSE;
+    if (p[1].revents & POLLIN)
+    {
+        while (read(f->wake[0], drain, sizeof(drain)) > 0)
+            ;
+        *mask = 0;
+    }
+    else
+    {
+        *mask = (p[0].revents & POLLIN) ? (f->mask & EV_RXCHAR) : 0;
+    }
+    return TRUE;
+}
+
+BOOL ClearCommError(HANDLE port, DWORD *errors, COMSTAT *stat)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    if (!f)
+        return FALSE;
+
+    int in = 0, out = 0;
+    ioctl(f->fd, FIONREAD, &in);
+#ifdef TIOCOUTQ
+    ioctl(f->fd, TIOCOUTQ, &out);
+#endif
+    if (errors)
+        *errors = 0;
+    if (stat)
+    {
+        stat->cbInQue = (DWORD) max(0, in);
+        stat->cbOutQue = (DWORD) max(0, out);
+    }
+    return TRUE;
+}
+
+BOOL PurgeComm(HANDLE port, DWORD flags)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    if (!f)
+        return FALSE;
+
+    if (flags & PURGE_RXCLEAR)
+    {
+        // not a tty (a pipe or socket in tests), drop what is buffered by reading it
+        if (tcflush(f->fd, TCIFLUSH) != 0)
+        {
+            char drop[256];
+            while (read(f->fd, drop, sizeof(drop)) > 0)
+                ;
+        }
+    }
+    if (flags & PURGE_TXCLEAR)
+        tcflush(f->fd, TCOFLUSH);
+    return TRUE;
+}
+
+BOOL SetCommTimeouts(HANDLE port, COMMTIMEOUTS *timeouts)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    if (!f)
+        return FALSE;
+
+    f->timeouts = *timeouts;
+    return TRUE;
+}
+
+BOOL GetCommState(HANDLE port, DCB *dcb)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    struct termios tio;
+    if (!f || tcgetattr(f->fd, &tio) != 0)
+        return FALSE;
+
+    dcb->BaudRate = speedToBaud(cfgetospeed(&tio));
+    switch (tio.c_cflag & CSIZE)
+    {
+    case CS5: dcb->ByteSize = 5; break;
+    case CS6: dcb->ByteSize = 6; break;
+    case CS7: dcb->ByteSize = 7; break;
+    default:  dcb->ByteSize = 8; break;
+    }
+    dcb->Parity = !(tio.c_cflag & PARENB) ? NOPARITY : (tio.c_cflag & PARODD) ? ODDPARITY : EVENPARITY;
+    dcb->StopBits = (tio.c_cflag & CSTOPB) ? TWOSTOPBITS : ONESTOPBIT;
+    return TRUE;
+}
+
+BOOL SetCommState(HANDLE port, DCB *dcb)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(port, OBJ_FILE);
+    struct termios tio;
+    if (!f || tcgetattr(f->fd, &tio) != 0)
+        return FALSE;
+
+    speed_t speed = baudToSpeed(dcb->BaudRate);
+    if (speed == B0)
+    {
+        lastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+    switch (dcb->ByteSize)
+    {
+    case 5:  tio.c_cflag |= CS5; break;
+    case 6:  tio.c_cflag |= CS6; break;
+    case 7:  tio.c_cflag |= CS7; break;
+    default: tio.c_cflag |= CS8; break;
+    }
+    if (dcb->Parity == ODDPARITY)
+        tio.c_cflag |= PARENB | PARODD;
+    else if (dcb->Parity == EVENPARITY)
+        tio.c_cflag |= PARENB;
+    if (dcb->StopBits == TWOSTOPBITS)
+        tio.c_cflag |= CSTOPB;
+
+    return tcsetattr(f->fd, TCSANOW, &tio) == 0;
+}
+
+BOOL BuildCommDCB(LPCSTR def, DCB *dcb)
+{
+    // either the mode form "9600,n,8,1" or "baud=9600 parity=n data=8 stop=1"
+    string s(def);
+    for (char &c : s)
+        c = (char) tolower((unsigned char) c);
+
+    unsigned baud = 0, data = 8, stop = 1;
+    char parity = 'n';
+    if (s.find("baud=") != string::npos)
+    {
+        size_t p;
+        if ((p = s.find("baud=")) != string::npos)
+            baud = (unsigned) atoi(s.c_str() + p + 5);
+        if ((p = s.find("parity=")) != string::npos)
+            parity = s[p + 7];
+        if ((p = s.find("data=")) != string::npos)
+            data = (unsigned) atoi(s.c_str() + p + 5);
+        if ((p = s.find("stop=")) != string::npos)
+            stop = (unsigned) atoi(s.c_str() + p + 5);
+    }
+    else if (sscanf(s.c_str(), "%u,%c,%u,%u", &baud, &parity, &data, &stop) < 1)
+    {
+        lastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+
+    if (baudToSpeed(baud) == B0 || data < 5 || data > 8 || (stop != 1 && stop != 2) ||
+        (parity != 'n' && parity != 'o' && parity != 'e'))
+    {
+        lastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+
+    dcb->BaudRate = baud;
+    dcb->ByteSize = (BYTE) data;
+    dcb->Parity = parity == 'o' ? ODDPARITY : parity == 'e' ? EVENPARITY : NOPARITY;
+    dcb->StopBits = stop == 2 ? TWOSTOPBITS : ONESTOPBIT;
+    return TRUE;
+}
+
+BOOL GetCommConfig(HANDLE port, COMMCONFIG *cc, DWORD *)
+{
+    return GetCommState(port, &cc->dcb);
+}
+
+BOOL CommConfigDialog(LPCSTR, HWND, COMMCONFIG *)
+{
+    // there is no dialog; the line settings come from the command line
+    return FALSE;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- memory mapped files
+----------------------------------------------------------------------------------------------------------------------*/
+static mutex viewsLock;
+
+static map<const void*, size_t> &views()
+{
+    static map<const void*, size_t> sizes;
+    return sizes;
+}
+
+HANDLE CreateFileMapping(HANDLE file, LPVOID, DWORD, DWORD, DWORD, LPCSTR)
+{
+    FILE_OBJECT *f = object<FILE_OBJECT>(file, OBJ_FILE);
+    if (!f)
+        return NULL;
+
+    MAPPING_OBJECT *m = new MAPPING_OBJECT();
+    m->fd = dup(f->fd);
+    return m;
+}
+
+LPVOID MapViewOfFile(HANDLE mapping, DWORD, DWORD offsetHigh, DWORD offsetLow, size_t size)
+{
+    MAPPING_OBJECT *m = object<MAPPING_OBJECT>(mapping, OBJ_MAPPING);
+    if (!m)
+        return NULL;
+
+    off_t offset = (off_t)(((uint64_t) offsetHigh << 32) | offsetLow);
+    void *view = mmap(NULL, size, PROT_READ, MAP_SHARED, m->fd, offset);
+    if (view == MAP_FAILED)
+    {
+        lastError = (DWORD) errno;
+        return NULL;
+    }
+
+    lock_guard<mutex> guard(viewsLock);
+    views()[view] = size;
+    return view;
+}
+
+BOOL UnmapViewOfFile(const void *view)
+{
+    size_t size;
+    {
+        lock_guard<mutex> guard(viewsLock);
+        auto it = views().find(view);
+        if (it == views().end())
+            return FALSE;
+        size = it->second;
+        views().erase(it);
+    }
+    return munmap((void*) view, size) == 0;
+}
+
+VOID GetSystemInfo(SYSTEM_INFO *info)
+{
+    info->dwPageSize = (DWORD) sysconf(_SC_PAGESIZE);
+    // keep the Windows granularity so views line up the same on both
+    info->dwAllocationGranularity = max<DWORD>(info->dwPageSize, 65536);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- diagnostics and window calls
+----------------------------------------------------------------------------------------------------------------------*/
+VOID OutputDebugString(LPCSTR msg)
+{
+    if (platformDebugOutput && msg)
+        fputs(msg, stderr);
+}
+
+VOID OutputDebugStringW(const wchar_t *msg)
+{
+    if (platformDebugOutput && msg)
+        fprintf(stderr, "%ls", msg);
+}
+
+DWORD FormatMessageW(DWORD, const void *, DWORD id, DWORD, wchar_t *buffer, DWORD size, void *)
+{
+    if (!buffer || size == 0)
+        return 0;
+
+    string text = strerror((int) id);
+    int n = swprintf(buffer, size, L"%s\n", text.c_str());
+    return n > 0 ? (DWORD) n : 0;
+}
+
+int MessageBox(HWND, LPCSTR text, LPCSTR caption, UINT)
+{
+    fprintf(stderr, "%s: %s\n", caption ? caption : "", text ? text : "");
+    return 1;
+}
+
+LPARAM SendMessage(HWND, UINT, WPARAM, LPARAM)
+{
+    return 0;
+}
+
+BOOL PostMessage(HWND, UINT, WPARAM, LPARAM)
+{
+    return TRUE;
+}
+#endif
@@ -0,0 +1,210 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Platform.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes <windows.h> on Windows. Everywhere else it declares the part of the
+-- Win32 API the protocol engine uses, implemented over POSIX in Platform.cpp, so the engine and
+-- the headless driver build unchanged on Linux. Nothing of the dialog is provided here.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef PLATFORM_H
+#define PLATFORM_H
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// basic types
+typedef int                 BOOL;
+typedef uint8_t             BYTE;
+typedef uint16_t            WORD;
+typedef uint32_t            DWORD;
+typedef int32_t             LONG;
+typedef uint32_t            ULONG;
+typedef int64_t             LONGLONG;
+typedef uint64_t            ULONGLONG;
+typedef uintptr_t           ULONG_PTR;
+typedef char                CHAR;
+typedef char                TCHAR;
+typedef unsigned int        UINT;
+typedef intptr_t            INT_PTR;
+typedef uintptr_t           WPARAM;
+typedef intptr_t            LPARAM;
+typedef void                *HANDLE;
+typedef void                *HWND;
+typedef void                *HINSTANCE;
+typedef void                *LPVOID;
+typedef const char          *LPCSTR;
+typedef const char          *LPCTSTR;
+typedef char                *LPSTR;
+#define VOID                void
+
+#define TRUE                1
+#define FALSE               0
+#define WINAPI
+#define CALLBACK
+#define TEXT(s)             s
+#define MAXDWORD            0xFFFFFFFF
+#define INFINITE            0xFFFFFFFF
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t) -1)
+
+// waits
+#define WAIT_OBJECT_0       0x00000000
+#define WAIT_TIMEOUT        0x00000102
+#define WAIT_FAILED         0xFFFFFFFF
+
+// errors
+#define ERROR_SUCCESS           0
+#define ERROR_INVALID_HANDLE    6
+#define ERROR_INVALID_PARAMETER 87
+#define ERROR_OPERATION_ABORTED 995
+#define ERROR_IO_INCOMPLETE     996
+#define ERROR_IO_PENDING        997
+
+// files
+#define GENERIC_READ                0x80000000
+#define GENERIC_WRITE               0x40000000
+#define FILE_SHARE_READ             0x00000001
+#define FILE_SHARE_WRITE            0x00000002
+#define CREATE_ALWAYS               2
+#define OPEN_EXISTING               3
+#define FILE_ATTRIBUTE_NORMAL       0x00000080
+#define FILE_FLAG_OVERLAPPED        0x40000000
+#define FILE_FLAG_SEQUENTIAL_SCAN   0x08000000
+#define PAGE_READONLY               0x02
+#define FILE_MAP_READ               0x0004
+
+// comm ports
+#define EV_RXCHAR           0x0001
+#define PURGE_TXABORT       0x0001
+#define PURGE_RXABORT       0x0002
+#define PURGE_TXCLEAR       0x0004
+#define PURGE_RXCLEAR       0x0008
+#define NOPARITY            0
+#define ODDPARITY           1
+#define EVENPARITY          2
+#define ONESTOPBIT          0
+#define TWOSTOPBITS         2
+
+// messages, only what the engine sends to its panels and posts to the dialog
+#define MB_OK               0x00000000
+#define EM_SETREADONLY      0x00CF
+#define WM_APP              0x8000
+#define FORMAT_MESSAGE_FROM_SYSTEM  0x00001000
+#define LANG_NEUTRAL        0x00
+#define SUBLANG_DEFAULT     0x01
+#define MAKELANGID(p, s)    ((((WORD)(s)) << 10) | (WORD)(p))
+
+struct OVERLAPPED {
+    ULONG_PTR   Internal;
+    ULONG_PTR   InternalHigh;
+    DWORD       Offset;
+    DWORD       OffsetHigh;
+    HANDLE      hEvent;
+};
+
+struct COMSTAT {
+    DWORD   cbInQue;
+    DWORD   cbOutQue;
+};
+
+struct COMMTIMEOUTS {
+    DWORD   ReadIntervalTimeout;
+    DWORD   ReadTotalTimeoutMultiplier;
+    DWORD   ReadTotalTimeoutConstant;
+    DWORD   WriteTotalTimeoutMultiplier;
+    DWORD   WriteTotalTimeoutConstant;
+};
+
+struct DCB {
+    DWORD   DCBlength;
+    DWORD   BaudRate;
+    BYTE    ByteSize;
+    BYTE    Parity;
+    BYTE    StopBits;
+};
+
+struct COMMCONFIG {
+    DWORD   dwSize;
+    WORD    wVersion;
+    WORD    wReserved;
+    DCB     dcb;
+};
+
+union LARGE_INTEGER {
+    struct {
+        DWORD   LowPart;
+        LONG    HighPart;
+    };
+    LONGLONG    QuadPart;
+};
+
+struct SYSTEM_INFO {
+    DWORD   dwPageSize;
+    DWORD   dwAllocationGranularity;
+};
+
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID);
+
+// OutputDebugString() goes to stderr when set
+extern BOOL platformDebugOutput;
+
+// synchronization and threads
+HANDLE CreateEvent(LPVOID attributes, BOOL manualReset, BOOL initialState, LPCSTR name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+HANDLE CreateMutex(LPVOID attributes, BOOL initialOwner, LPCSTR name);
+BOOL ReleaseMutex(HANDLE mutex);
+DWORD WaitForSingleObject(HANDLE handle, DWORD msec);
+BOOL CloseHandle(HANDLE handle);
+HANDLE CreateThread(LPVOID attributes, size_t stackSize, LPTHREAD_START_ROUTINE start, LPVOID param,
+    DWORD flags, DWORD *threadId);
+VOID ExitThread(DWORD exitCode);
+VOID Sleep(DWORD msec);
+DWORD GetTickCount();
+DWORD GetLastError();
+VOID SetLastError(DWORD error);
+
+// files and comm ports
+HANDLE CreateFile(LPCSTR path, DWORD access, DWORD share, LPVOID attributes, DWORD disposition,
+    DWORD flags, HANDLE templateFile);
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD size, DWORD *read, OVERLAPPED *ov);
+BOOL WriteFile(HANDLE file, const void *buffer, DWORD size, DWORD *written, OVERLAPPED *ov);
+BOOL GetOverlappedResult(HANDLE file, OVERLAPPED *ov, DWORD *transferred, BOOL wait);
+BOOL CancelIo(HANDLE file);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER *size);
+BOOL SetCommMask(HANDLE port, DWORD mask);
+BOOL WaitCommEvent(HANDLE port, DWORD *mask, OVERLAPPED *ov);
+BOOL ClearCommError(HANDLE port, DWORD *errors, COMSTAT *stat);
+BOOL PurgeComm(HANDLE port, DWORD flags);
+BOOL SetCommTimeouts(HANDLE port, COMMTIMEOUTS *timeouts);
+BOOL GetCommState(HANDLE port, DCB *dcb);
+BOOL SetCommState(HANDLE port, DCB *dcb);
+BOOL BuildCommDCB(LPCSTR def, DCB *dcb);
+BOOL GetCommConfig(HANDLE port, COMMCONFIG *cc, DWORD *size);
+BOOL CommConfigDialog(LPCSTR name, HWND owner, COMMCONFIG *cc);
+
+// memory mapped files
+HANDLE CreateFileMapping(HANDLE file, LPVOID attributes, DWORD protect, DWORD sizeHigh, DWORD sizeLow,
+    LPCSTR name);
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, size_t size);
+BOOL UnmapViewOfFile(const void *view);
+VOID GetSystemInfo(SYSTEM_INFO *info);
+
+// diagnostics and the few window calls the engine makes
+VOID OutputDebugString(LPCSTR msg);
+VOID OutputDebugStringW(const wchar_t *msg);
+DWORD FormatMessageW(DWORD flags, const void *source, DWORD id, DWORD lang, wchar_t *buffer, DWORD size,
+    void *args);
+int MessageBox(HWND owner, LPCSTR text, LPCSTR caption, UINT type);
+LPARAM SendMessage(HWND window, UINT msg, WPARAM wParam, LPARAM lParam);
+BOOL PostMessage(HWND window, UINT msg, WPARAM wParam, LPARAM lParam);
+#endif
+#endif
@@ -20,6 +20,7 @@
 ----------------------------------------------------------------------------------------------------------------------*/
 #define STRICT
 #include "RMProtocol.h"
+#include "LinkSession.h"
 
 #pragma comment(linker,"\"/manifestdependency:type='win32' \
 name='Microsoft.Windows.Common-Controls' version='6.0.0.0' \
@@ -37,6 +38,61 @@ DWORD   fileRWThreadId;
 
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hprevInstance,
                   LPSTR lspszCmdParam, int nCmdShow) {
+    // "/bench" runs the micro benchmarks instead of the dialog
+    if (lspszCmdParam && strstr(lspszCmdParam, "/bench")) {
+        std::string report = runBenchmarks();
+        OutputDebugString(report.c_str());
+        MessageBox(NULL, report.c_str(), "RMProtocol benchmarks", MB_OK);
+        return 0;
+    }
+
+    // "/payload N" caps the payload this station offers, the link agrees on the smaller one
+    const char *payloadArg = lspszCmdParam ? strstr(lspszCmdParam, "/payload ") : NULL;
+    if (payloadArg) {
+        int size = atoi(payloadArg + strlen("/payload "));
+        if (size >= PAYLOAD_UNIT && size <= PACKET_DATA_MAX)
+            session->localParams.maxPayload = (WORD) size;
+    }
+
+    // "/nocompress" sends the text as it is
+    if (lspszCmdParam && strstr(lspszCmdParam, "/nocompress"))
+        session->localParams.compress = COMPRESS_NONE;
+
+    // "/noadapt" keeps every frame at the agreed payload size
+    if (lspszCmdParam && strstr(lspszCmdParam, "/noadapt"))
+        session->localParams.adaptive = FALSE;
+
+    // "/burst N" offers N frames per won bid, 0 gives up the line after every window
+    const char *burstArg = lspszCmdParam ? strstr(lspszCmdParam, "/burst ") : NULL;
+    if (burstArg) {
+        int frames = atoi(burstArg + strlen("/burst "));
+        if (frames >= 0 && frames <= BURST_MAX_FRAMES)
+            session->localParams.burst = (BYTE) frames;
+    }
+
+    // "/fec N" offers N Reed-Solomon check symbols per codeword, "/interleave N" spreads a frame over
+    // at least N codewords
+    const char *fecArg = lspszCmdParam ? strstr(lspszCmdParam, "/fec ") : NULL;
+    if (fecArg) {
+        int parity = atoi(fecArg + strlen("/fec "));
+        if (parity >= 0 && parity <= FEC_MAX_PARITY && parity % 2 == 0)
+            session->localParams.fecParity = (BYTE) parity;
+    }
+    const char *interleaveArg = lspszCmdParam ? strstr(lspszCmdParam, "/interleave ") : NULL;
+    if (interleaveArg) {
+        int depth = atoi(interleaveArg + strlen("/interleave "));
+        if (depth >= 1 && depth <= FEC_MAX_DEPTH)
+            session->localParams.fecDepth = (BYTE) depth;
+    }
+
+    // "/trace FILE" records the engine's events, the ring is dumped into FILE on exit and on a crash
+    const char *traceArg = lspszCmdParam ? strstr(lspszCmdParam, "/trace ") : NULL;
+    if (traceArg) {
+        char path[TRACE_PATH_LEN];
+        if (sscanf(traceArg + strlen("/trace "), "%259s", path) == 1 && !traceOpen(path, lpszCommName, FALSE))
+            OutputDebugString("cannot write the trace file\n");
+    }
+
     // State - Build Window
     hDlg = CreateDialogParam(hInst, MAKEINTRESOURCE(IDD_DIALOG1), 0, WndProc, 0);
     ShowWindow(hDlg, nCmdShow);
@@ -46,6 +102,10 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hprevInstance,
     // initialize file opener
     initFileOpener();
 
+    // received data goes to a spool file as it comes in, "Save" copies it
+    if (!session->fileSink.open(SINK_SPOOL))
+        MessageBox(NULL, "Failed to create " SINK_SPOOL, "Error", MB_OK);
+
     // register read/write panels
     SendMessage(GetDlgItem(hDlg, IDC_READERFILE), EM_SETLIMITTEXT, (LPARAM) FILE_LEN, NULL);
     SendMessage(GetDlgItem(hDlg, IDC_WRITERFILE), EM_SETLIMITTEXT, (LPARAM) FILE_LEN, NULL);
@@ -56,8 +116,11 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hprevInstance,
     // State - Enter Comm param 
     configComm();
 
-    // State - Engine Read Thread Start
-    initRead();
+    // State - Engine Thread Start
+    startEngine();
+
+    // the engine only counts, the labels and the receive panel follow it on a timer
+    SetTimer(hDlg, IDT_STATS, STATS_REFRESH, NULL);
 
     while (GetMessage(&Msg, NULL, 0, 0)) {
         TranslateMessage(&Msg);
@@ -113,24 +176,54 @@ INT_PTR CALLBACK WndProc(HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lParam) {
             break;
         case IDC_OPEN:
             setFileOpenerFlags(OPEN_BROWSER);
+            // the file source opens the file itself, sharing it for reading
             if (GetOpenFileName(&fileName) == TRUE) {
-                fileRWThread = CreateThread(NULL, 0, createFileReader, NULL, 0, &fileRWThreadId);
+                loadFile(&hSendPanel, fileName.lpstrFile);
+            }
+            break;
+        case IDC_SAVE:
+            setFileOpenerFlags(SAVE_BROWSER);
+            if (GetSaveFileName(&fileName) == TRUE) {
+                saveFile(fileName.lpstrFile);
             }
-            loadFile(&hSendPanel, fileName.lpstrFile);
             break;
         case IDC_CLEAR_SENDER:
-            write_packets.clear();
+            // a text send stops with the frames already in the window, a file send when the engine
+            // takes the load that closes the file
+            sendQueue.cancel();
+            postCommand(ENGINE_CMD_LOAD);
+            fileLoaded = FALSE;
             clearBox(&hSendPanel);
+            SendMessage(hSendPanel, EM_SETREADONLY, (LPARAM) FALSE, NULL);
             break;
         case IDC_BUTTONSEND:
             setupProgressBar(&hSendPanel);
-            errorCheck((writeThread = CreateThread(NULL, 0, loadPacketThread, NULL, 0, &writeThreadId)) == NULL ?
-                ERR_WRITE_THREAD : NO_ERR);
+            // a loaded file is read by the engine, the text by the packetizer while the engine sends it
+            if (fileLoaded)
+                postCommand(ENGINE_CMD_SEND);
+            else if (startPacketizer())
+                postCommand(ENGINE_CMD_SEND, NULL, &sendQueue);
+            else
+                OutputDebugString("the last text is still being sent\n");
             break;
         }
         break;
 
+    case WM_SEND_DONE: // the engine finished a send and closed its file, the panel takes new text
+        fileLoaded = FALSE;
+        clearBox(&hSendPanel);
+        SendMessage(hSendPanel, EM_SETREADONLY, FALSE, 0);
+        break;
+
+    case WM_TIMER:
+        if (wParam == IDT_STATS) {
+            refreshStats();
+            refreshReceived();
+        }
+        break;
+
     case WM_CLOSE: // Terminate program
+        traceDump();
         PostQuitMessage(0);
         break;
         default:
@@ -15,6 +15,12 @@
 #define RMPROTOCOL_H
 #include "Common.h"
 
+// dialog timer that puts the link counters on the stats labels
+#define IDT_STATS           1
+
+// handle to the current window
+extern HWND hwnd;
+
 // function prototypes
 INT_PTR CALLBACK WndProc(HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lParam);
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hprevInstance,
@@ -0,0 +1,138 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     RingBuffer.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  RingBuffer::RingBuffer(size_t capacity);
+--                  size_t RingBuffer::write(const uint8_t *data, size_t len);
+--                  uint8_t *RingBuffer::writePtr(size_t *contiguous);
+--                  void RingBuffer::commit(size_t len);
+--                  RING_SPAN RingBuffer::span(size_t offset, size_t len) const;
+--                  size_t RingBuffer::find(uint8_t value, size_t from) const;
+--                  void RingBuffer::store(size_t offset, const uint8_t *data, size_t len);
+--                  void RingBuffer::consume(size_t len);
+--                  void RingBuffer::clear();
+--                  size_t spanCopy(const RING_SPAN &span, uint8_t *out);
+--                  void spanAppend(const RING_SPAN &span, std::string &out);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Single reader, single writer byte ring. The storage is allocated once; the capacity is rounded up
+-- to a power of two so positions wrap with a mask.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "RingBuffer.h"
+#include <cstring>
+using namespace std;
+
+static size_t roundUpPow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+    : buf(roundUpPow2(capacity)), mask(roundUpPow2(capacity) - 1), head(0), tail(0)
+{
+}
+
+size_t RingBuffer::write(const uint8_t *data, size_t len)
+{
+    size_t total = 0;
+
+    while (len > 0)
+    {
+        size_t room;
+        uint8_t *dst = writePtr(&room);
+        if (room == 0)
+            break;
+
+        size_t n = len < room ? len : room;
+        memcpy(dst, data, n);
+        commit(n);
+        data += n;
+        len -= n;
+        total += n;
+    }
+
+    return total;
+}
+
+uint8_t *RingBuffer::writePtr(size_t *contiguous)
+{
+    size_t index = head & mask;
+    size_t toEnd = buf.size() - index;
+    size_t free = space();
+    *contiguous = free < toEnd ? free : toEnd;
+    return &buf[index];
+}
+
+void RingBuffer::commit(size_t len)
+{
+    head += len;
+}
+
+RING_SPAN RingBuffer::span(size_t offset, size_t len) const
+{
+    RING_SPAN s;
+    size_t index = (tail + offset) & mask;
+    size_t toEnd = buf.size() - index;
+
+    s.p1 = &buf[index];
+    s.n1 = len < toEnd ? len : toEnd;
+    s.p2 = &buf[0];
+    s.n2 = len - s.n1;
+    return s;
+}
+
+size_t RingBuffer::find(uint8_t value, size_t from) const
+{
+    size_t n = size();
+
+    while (from < n)
+    {
+        RING_SPAN s = span(from, n - from);
+        const void *hit = memchr(s.p1, value, s.n1);
+        if (hit)
+            return from + ((const uint8_t*) hit - s.p1);
+        from += s.n1;
+    }
+
+    return n;
+}
+
+void RingBuffer::store(size_t offset, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        buf[(tail + offset + i) & mask] = data[i];
+}
+
+void RingBuffer::consume(size_t len)
+{
+    tail += len < size() ? len : size();
+}
+
+void RingBuffer::clear()
+{
+    tail = head;
+}
+
+size_t spanCopy(const RING_SPAN &span, uint8_t *out)
+{
+    memcpy(out, span.p1, span.n1);
+    memcpy(out + span.n1, span.p2, span.n2);
+    return span.size();
+}
+
+void spanAppend(const RING_SPAN &span, string &out)
+{
+    out.append((const char*) span.p1, span.n1);
+    out.append((const char*) span.p2, span.n2);
+}
@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     RingBuffer.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the declarations for the fixed size byte ring the receive path reads
+-- into. Readers get views into the ring (at most two pieces when the data wraps) instead of copies.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A run of bytes in the ring, split in two when it wraps around the end
+struct RING_SPAN {
+    const uint8_t   *p1;
+    size_t          n1;
+    const uint8_t   *p2;
+    size_t          n2;
+
+    size_t size() const { return n1 + n2; }
+};
+
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity);
+
+    size_t      size() const { return head - tail; }
+    size_t      space() const { return buf.size() - size(); }
+    size_t      capacity() const { return buf.size(); }
+
+    // producer side: copy in, or fill the contiguous free region in place and commit it
+    size_t      write(const uint8_t *data, size_t len);
+    uint8_t     *writePtr(size_t *contiguous);
+    void        commit(size_t len);
+
+    // consumer side
+    uint8_t     at(size_t offset) const { return buf[(tail + offset) & mask]; }
+    RING_SPAN   span(size_t offset, size_t len) const;
+    size_t      find(uint8_t value, size_t from = 0) const;
+    // overwrites bytes that are already in the ring, e.g. with their corrected values
+    void        store(size_t offset, const uint8_t *data, size_t len);
+    void        consume(size_t len);
+    void        clear();
+
+private:
+    std::vector<uint8_t>    buf;
+    size_t                  mask;
+    // running byte counts, the index into buf is count & mask
+    size_t                  head;
+    size_t                  tail;
+};
+
+// function prototypes
+size_t spanCopy(const RING_SPAN &span, uint8_t *out);
+void spanAppend(const RING_SPAN &span, std::string &out);
+#endif
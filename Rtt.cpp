@@ -0,0 +1,84 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Rtt.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  RttEstimator::RttEstimator();
+--                  VOID RttEstimator::sample(DWORD msec);
+--                  VOID RttEstimator::backoff();
+--                  DWORD RttEstimator::timeout() const;
+--                  double RttEstimator::srtt() const;
+--                  double RttEstimator::rttvar() const;
+--                  DWORD RttEstimator::samples() const;
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- Retransmission timeout from measured round trips. The first sample sets SRTT to the sample and
+-- RTTVAR to half of it. Each later sample R moves them by
+--
+--     RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+--     SRTT   = 7/8 SRTT + 1/8 R
+--
+-- and the timeout is SRTT + max(granularity, 4 RTTVAR), kept within RTT_MIN_RTO and RTT_MAX_RTO.
+-- A wait that runs out doubles the timeout, up to RTT_MAX_RTO, until a fresh sample brings it
+-- back to the estimate.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Rtt.h"
+#include "Common.h"
+#include <cmath>
+using namespace std;
+
+RttEstimator::RttEstimator()
+    : smoothed(0), variance(0), rto(RTT_INITIAL_RTO), count(0)
+{
+}
+
+VOID RttEstimator::sample(DWORD msec)
+{
+    double r = (double) msec;
+
+    if (count++ == 0)
+    {
+        smoothed = r;
+        variance = r / 2;
+    }
+    else
+    {
+        variance = 0.75 * variance + 0.25 * fabs(smoothed - r);
+        smoothed = 0.875 * smoothed + 0.125 * r;
+    }
+
+    double next = smoothed + max<double>(RTT_GRANULARITY, 4 * variance);
+    rto = (DWORD) min<double>(RTT_MAX_RTO, max<double>(RTT_MIN_RTO, ceil(next)));
+}
+
+VOID RttEstimator::backoff()
+{
+    rto = min<DWORD>(RTT_MAX_RTO, rto * 2);
+}
+
+DWORD RttEstimator::timeout() const
+{
+    return rto;
+}
+
+double RttEstimator::srtt() const
+{
+    return smoothed;
+}
+
+double RttEstimator::rttvar() const
+{
+    return variance;
+}
+
+DWORD RttEstimator::samples() const
+{
+    return count;
+}
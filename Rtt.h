@@ -0,0 +1,47 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Rtt.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declaration for the round-trip time
+-- estimator that sets how long the engine waits for an answer on the line.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef RTT_H
+#define RTT_H
+#include "Platform.h"
+
+// Timeout before the first sample, the old fixed TIME_OUT_LONG
+#define RTT_INITIAL_RTO     2000
+// Bounds of the timeout in ms, the floor keeps scheduler jitter from looking like a loss
+#define RTT_MIN_RTO         100
+#define RTT_MAX_RTO         8000
+// Resolution of GetTickCount()
+#define RTT_GRANULARITY     16
+
+// Smoothed round-trip time and its variance, as in RFC 6298. A sample is the time from a request
+// going out to the first byte of its answer; only exchanges that were not repeated are sampled.
+class RttEstimator {
+public:
+    RttEstimator();
+
+    VOID    sample(DWORD msec);
+    // the wait ran out; the timeout doubles until the next sample
+    VOID    backoff();
+    // how long to wait for an answer right now
+    DWORD   timeout() const;
+    double  srtt() const;
+    double  rttvar() const;
+    DWORD   samples() const;
+
+private:
+    double  smoothed;
+    double  variance;
+    DWORD   rto;
+    DWORD   count;
+};
+#endif
@@ -6,10 +6,15 @@
 -- Functions
 --                  VOID connect();
 --                  VOID disconnect();
---                  BOOL waitForData(char **str, DWORD buffer_size, DWORD TIMEOUT);
---                  VOID sendData(char* msg, DWORD size, HANDLE lock);
+--                  DWORD readChunk(DWORD msec);
+--                  BOOL waitForData(const char **str, DWORD buffer_size, DWORD TIMEOUT, DWORD *length);
+--                  int waitForFrame(FRAME_VIEW *frame, DWORD TIMEOUT);
+--                  VOID purgeInput();
+--                  VOID drainInput();
+--                  double readCallsPerFrame();
+--                  VOID sendData(char* msg, DWORD size);
 --                  BOOL timeout(DWORD msec);
---                  BOOL waitForENQ();
+--                  BOOL waitForENQ(DWORD msec);
 --
 -- DATE:            December 3, 2016
 --
@@ -21,61 +26,72 @@
 -- This class wraps the timing and flow control operations pertaining to the serial port.
 ----------------------------------------------------------------------------------------------------------------------*/
 #include "Serial.h"
+#include "LinkSession.h"
 using namespace std;
 
-// sender / receiver priorities
-BOOL senderPriority = FALSE;
-BOOL receiverPriority = FALSE;
-
-BOOL connected;
-FILE_STATISTICS stats;
-
 VOID connect() {
-    connected = TRUE;
+    session->connected = TRUE;
+    // offer our link parameters, the engine sends them until the reply is in
+    postCommand(ENGINE_CMD_SETUP);
 }
 
 VOID disconnect() {
-    connected = FALSE;
+    session->connected = FALSE;
+    session->setupPending = FALSE;
 }
 
-BOOL waitForData (
-    char    **str,
-    DWORD   buffer_size,
-    DWORD   TIMEOUT)
+DWORD readChunk(DWORD msec)
 {
+    DWORD bytes_read = 0;
+
     try {
-        string s;
-        DWORD total = 0, bytes_read;
-        *str = new char[buffer_size];
-        OVERLAPPED ovRead = { NULL };
-        ovRead.hEvent = CreateEvent(NULL, FALSE, FALSE, EV_OVREAD);
+        size_t room;
+        uint8_t *dst = session->rxRing.writePtr(&room);
+        // the ring is full, the consumer has to drain it first
+        if (room == 0)
+            return 0;
+
+        // everything buffered on the line, up to the free space in the ring
+        bytes_read = session->transport->read(dst, (DWORD) room, msec);
+        session->rxRing.commit(bytes_read);
+        session->readMetrics.bytesRead += bytes_read;
+    }
+    catch (exception& e) {
+        OutputDebugString(e.what());
+        return 0;
+    }
 
-        if (!timeout(TIMEOUT))
-        {
-            return FALSE;
-        }
+    return bytes_read;
+}
 
-        // while characters read are smaller than the buffer size
-        while (total < buffer_size)
+BOOL waitForData (
+    const char **str,
+    DWORD   buffer_size,
+    DWORD   TIMEOUT,
+    DWORD   *length)
+{
+    try {
+        // TIMEOUT for the first byte, then the usual inter-byte gap
+        DWORD wait = TIMEOUT;
+        while (session->rxRing.size() < buffer_size)
         {
-            char tmp[1] = "";
-            if (!ReadFile(hComm, tmp, 1, &bytes_read, &ovRead))
-            {
-                if (GetLastError() == ERROR_IO_PENDING)
-                    if (WaitForSingleObject(ovRead.hEvent, 50) != WAIT_OBJECT_0)
-                        return FALSE;
-            }
-            if (tmp[0] == EOT)
+            if (readChunk(wait) == 0)
             {
-                s += tmp[0];
-                break;
+                // a partial response is as good as none, drop it
+                session->rxRing.consume(min<size_t>(session->rxRing.size(), buffer_size));
+                return FALSE;
             }
-            s += tmp[0];
-            total++;
+            wait = TIME_OUT_BYTE;
         }
 
-        *str = (char*) malloc(strlen(s.c_str()));
-        strcpy(*str, s.c_str());
+        if (session->readBuffer.size() < buffer_size)
+            session->readBuffer.resize(buffer_size);
+        spanCopy(session->rxRing.span(0, buffer_size), (uint8_t*) &session->readBuffer[0]);
+        session->rxRing.consume(buffer_size);
+
+        *str = &session->readBuffer[0];
+        if (length)
+            *length = buffer_size;
     }
     catch (exception& e) {
         OutputDebugString(e.what());
@@ -85,89 +101,107 @@ BOOL waitForData (
     return TRUE;
 }
 
-VOID sendData(char* msg, DWORD size, HANDLE lock)
+int waitForFrame(FRAME_VIEW *frame, DWORD TIMEOUT)
 {
-    try {
-        COMSTAT cs;
-        DWORD err, result, bytes_written;
-        OVERLAPPED ovWrite = { NULL };
-        ovWrite.hEvent = CreateEvent(NULL, FALSE, FALSE, EV_OVWRITE);
-        // Lock this thread
-        WaitForSingleObject(lock, INFINITE);
-
-        if (!WriteFile(hComm, msg, size, &bytes_written, &ovWrite))
+    int result;
+    BOOL quiet = FALSE;
+    DWORD heard = GetTickCount();
+
+    // TIMEOUT of a quiet line until a frame starts, the inter-byte gap while one is coming in; noise
+    // or a frame too garbled to start keeps the line busy all the same
+    while ((result = session->rxDecoder.next(frame)) == DECODE_NEED_MORE)
+    {
+        DWORD elapsed = GetTickCount() - heard;
+        BOOL partial = session->rxRing.size() > 0;
+        // a long frame at a slow rate may take longer than TIMEOUT to come in
+        if (!partial && elapsed >= TIMEOUT)
+            return DECODE_NEED_MORE;
+
+        // the line went quiet in the middle of a frame, what is buffered is all there is; the SYN or
+        // the length may have been false, and whole frames may still follow it
+        if (partial && quiet)
         {
-            if (GetLastError() == ERROR_IO_PENDING)
-            {
-                if ((result = WaitForSingleObject(ovWrite.hEvent, INFINITE)) == WAIT_OBJECT_0)
-                {
-                    if (GetOverlappedResult(hComm, &ovWrite, &bytes_written, FALSE))
-                        OutputDebugString("Write Successfully\n");
-                    else
-                        OutputDebugString("Write Failed\n");
-                }
-                else
-                    OutputDebugString("Error occured in Send()::WaitForSingleObject()\n");
-                }
+            session->rxDecoder.skip();
+            continue;
         }
-        // Release this thread
-        ReleaseMutex(hWrite_Lock);
-        CloseHandle(ovWrite.hEvent);
-        ClearCommError(hComm, &err, &cs);
-    }
-    catch (exception& e) {
-        OutputDebugString(e.what());
+
+        size_t calls = session->readMetrics.readCalls;
+        DWORD got = readChunk(partial ? TIME_OUT_BYTE : TIMEOUT - elapsed);
+        if (got == 0)
+            quiet = partial;
+        else
+        {
+            quiet = FALSE;
+            heard = GetTickCount();
+        }
+
+        // the polls of an idle line say how long it was idle, not what a frame costs; before a frame
+        // starts only the read that brought its first bytes in counts
+        if (partial)
+            session->readMetrics.frameReads += session->readMetrics.readCalls - calls;
+        else if (got > 0)
+            session->readMetrics.frameReads++;
     }
+
+    session->readMetrics.frames++;
+    return result;
 }
 
-BOOL timeout(DWORD msec)
+VOID purgeInput()
 {
-    try {
-        COMSTAT cs;
-        DWORD fdwCommMask, err;
-        SetCommMask(hComm, EV_RXCHAR);
-        OVERLAPPED OverLapped;
-        memset((char *)&OverLapped, 0, sizeof(OVERLAPPED));
-        OverLapped.hEvent = CreateEvent(NULL, TRUE, TRUE, 0);
-
-        if (!WaitCommEvent(hComm, &fdwCommMask, &OverLapped))
-        {
-            if (GetLastError() == ERROR_IO_PENDING)
-            {
-                if (WaitForSingleObject(OverLapped.hEvent, (DWORD)msec) != WAIT_OBJECT_0)
-                    return FALSE;
-            }
-        }
+    session->rxRing.clear();
+    session->transport->purge();
+}
+
+VOID drainInput()
+{
+    // the rest of an answer may still be on its way, it goes until the line has been quiet for as
+    // long as the bytes of one frame may be apart
+    do
+        purgeInput();
+    while (readChunk(TIME_OUT_BYTE) > 0);
+}
+
+double readCallsPerFrame()
+{
+    return session->readMetrics.frames ? (double) session->readMetrics.frameReads / session->readMetrics.frames : 0.0;
+}
 
-        CloseHandle(OverLapped.hEvent);
-        ClearCommError(hComm, &err, &cs);
+VOID sendData(char* msg, DWORD size)
+{
+    try {
+        // only the engine thread writes to the line
+        BOOL ok = session->transport->write((const uint8_t*) msg, size);
+        TRACE(TRACE_WRITE, 0, size, ok);
     }
     catch (exception& e) {
         OutputDebugString(e.what());
-        return FALSE;
     }
+}
 
-    return TRUE;
+BOOL timeout(DWORD msec)
+{
+    // TRUE as soon as there is something to read
+    return session->rxRing.size() > 0 || readChunk(msec) > 0;
 }
 
-BOOL waitForENQ()
+BOOL waitForENQ(DWORD msec)
 {
     try {
-        char *response = "";
-        if (!waitForData(&response, 1, TIME_OUT_SHORT))
-        {
-            SetEvent(Ev_Send_Thread_Finish);
-            SetEvent(Ev_Read_Thread_Finish);
-            //If time'd out, go to idle state
-            OutputDebugString("Time'd out from wait state, calling initRead()\n");
-            return FALSE;
-        }
-        else if (response[0] == ENQ)
+        const char *response = "";
+        BOOL heard = waitForData(&response, 1, msec);
+        if (heard && response[0] == ENQ)
         {
-            ResetEvent(Ev_Send_Thread_Finish);
-            OutputDebugString("Got an ENQ from the wait state\n");
+            TRACE(TRACE_ENQ_RECEIVED, 0, 0, 0);
             return TRUE;
         }
+
+        // a garbled byte is as good as silence, go back to idle; it may be the first of a late SACK,
+        // and none of the rest must be left to answer our next bid
+        if (heard)
+            drainInput();
+        TRACE(TRACE_WAIT_TIMEOUT, 0, msec, 0);
+        return FALSE;
     }
     catch (exception& e) {
         OutputDebugString(e.what());
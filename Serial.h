@@ -15,11 +15,25 @@
 #define SERIAL_H
 #include "Common.h"
 
+// Read path counters. readCalls counts every read of the line, idle polls included; syscalls per
+// frame is frameReads / frames, the reads that took in a frame that had started
+struct READ_METRICS {
+    size_t readCalls;
+    size_t frameReads;
+    size_t bytesRead;
+    size_t frames;
+};
+
 // function prototypes
 VOID connect();
 VOID disconnect();
-BOOL waitForData(char **str, DWORD buffer_size, DWORD TIMEOUT);
-VOID sendData(char* msg, DWORD size, HANDLE lock);
+DWORD readChunk(DWORD msec);
+BOOL waitForData(const char **str, DWORD buffer_size, DWORD TIMEOUT, DWORD *length = NULL);
+int waitForFrame(FRAME_VIEW *frame, DWORD TIMEOUT);
+VOID purgeInput();
+VOID drainInput();
+double readCallsPerFrame();
+VOID sendData(char* msg, DWORD size);
 BOOL timeout(DWORD msec);
-BOOL waitForENQ();
+BOOL waitForENQ(DWORD msec);
 #endif
\ No newline at end of file
@@ -4,16 +4,16 @@
 -- PROGRAM:         RMProtocol
 --
 -- Functions
---                  int getBER();
 --                  VOID initPort();
---                  VOID initRead();
---                  DWORD WINAPI readIdle(LPVOID);
 --                  VOID sendACK();
+--                  VOID sendSACK();
 --                  CHAR readInput();
 --                  BOOL evaluateInput(CHAR);
---                  VOID waitForPacket();
---                  BOOL validatePacket(const char*);
---                  BOOL validateCheckSum(std::string, std::string);
+--                  BOOL waitForPacket();
+--                  BOOL validatePacket(const FRAME_VIEW&, BOOL*);
+--                  BOOL unpackPayload(std::string&);
+--                  VOID deliverPacket(std::string&);
+--                  BOOL validateCheckSum(const char*, size_t, const char*);
 --
 -- DATE:            December 3, 2016
 --
@@ -22,24 +22,21 @@
 -- PROGRAMMER:      Fred Yang
 --
 -- NOTES:
--- This class wraps the basic reading operations on serial comm port.
+-- This class wraps the basic reading operations on serial comm port. The engine thread in Engine.cpp
+-- calls them from its idle and receive states.
 ----------------------------------------------------------------------------------------------------------------------*/
 #include "SerialRead.h"
+#include "LinkBond.h"
+#include "LinkSession.h"
 using namespace std;
 
-// handle to the comm port
-HANDLE hComm;
-// read lock
-HANDLE hRead_Lock = CreateMutex(NULL, FALSE, READ_LOCK);
-// read thread finish event
-HANDLE Ev_Read_Thread_Finish = CreateEvent(NULL, TRUE, TRUE, 0);
-// ENQ in wait flag
-BOOL receivedENQinWait;
+// default port#
+LPCSTR lpszCommName = "com1";
 
 VOID initPort()
 {
     try {
-        errorCheck((hComm = CreateFile(lpszCommName, 
+        errorCheck((session->hComm = CreateFile(lpszCommName, 
             GENERIC_READ | GENERIC_WRITE, 
             0,
             NULL, 
@@ -47,99 +44,67 @@ VOID initPort()
             FILE_FLAG_OVERLAPPED,
             NULL)) == INVALID_HANDLE_VALUE ?
             ERR_INIT_COMM : NO_ERR);
-    }
-    catch (exception& e) {
-        OutputDebugString(e.what());
-    }
-}
 
-VOID initRead()
-{
-    try {
-        errorCheck((readThread = CreateThread(NULL, 0, readIdle, NULL , 0, &readThreadId)) 
-                    == NULL ? ERR_READ_THREAD : NO_ERR);
+        // reads return whatever is buffered at once, and wait for the first byte otherwise
+        COMMTIMEOUTS timeouts = { MAXDWORD, MAXDWORD, TIME_OUT_LONG, 0, 0 };
+        SetCommTimeouts(session->hComm, &timeouts);
+        session->transport = new CommTransport(session->hComm);
     }
     catch (exception& e) {
         OutputDebugString(e.what());
     }
 }
 
-DWORD WINAPI readIdle(LPVOID lpvoid)
+VOID sendACK()
 {
-    try {
-        while (1)
-        {
-            // If we got an ENQ already from the wait state, go directly to sending 
-            // an ACK to acknowledge line
-            if (receivedENQinWait) {
-                ResetEvent(Ev_Read_Thread_Finish);
-                // Clear the flag
-                receivedENQinWait = false;
-                // Send ACK
-                sendACK();
-                // Now wait for the packet to come, and validate it
-                waitForPacket();
-            } 
-            else
-            {
-                // Idle state waiting
-                ResetEvent(Ev_Read_Thread_Finish);
-                if (evaluateInput(readInput()))
-                {
-                    sendACK();
-                    // Now we wait for the packet to come, and validate it
-                    waitForPacket();
-                }
-            }
-        }
-    }
-    catch (exception& e) {
-        OutputDebugString(e.what());
-    }
+    char c = ACK;
+    sendData(&c, sizeof(c));
+    session->stats.add(STAT_ACKS_RECEIVED);
 
-	return 0;
+    // the line goes to the peer; when we were bidding for it too, the peer won the round
+    if (session->bidFailures)
+    {
+        session->bidsLost++;
+        session->bidFailures = 0;
+    }
 }
 
-VOID sendACK()
+VOID sendSACK()
 {
-    char c = ACK;
-    sendData(&c, sizeof(c), hRead_Lock);
-    updateStats(++stats.acksReceived, IDC_SDATA4);
+    char sack[SACK_SIZE];
+    // NAK when frames are missing in front of ones we already hold
+    SACK window = session->rxWindow.sack();
+    encodeSack(window, !session->rxWindow.complete(), sack);
+    sendData(sack, SACK_SIZE);
+    TRACE(TRACE_SACK_SENT, window.base, window.mask, !session->rxWindow.complete());
+    session->stats.add(STAT_ACKS_RECEIVED);
 }
 
 CHAR readInput()
 {
-    COMSTAT cs;
     char c = '\0';
-    OVERLAPPED ovRead = { NULL };
 
     try {
-        // Create overlapped event
-        ovRead.hEvent = CreateEvent(NULL, FALSE, FALSE, EV_OVREAD);
-        //	Set listener to a character
-        errorCheck(!SetCommMask(hComm, EV_RXCHAR) ? ERR_COMMMASK : NO_ERR);
-        DWORD read_byte, dwEvent, dwError;
-        // Waits for EV_RXCHAR event to trigger
-        if (WaitCommEvent(hComm, &dwEvent, NULL))
+        // Waits for input on the line, unless bytes are buffered already
+        BOOL input = session->rxRing.size() > 0 || session->transport->waitForInput();
+        // pull in everything that is there in one read
+        if (input && (session->rxRing.size() > 0 || readChunk(TIME_OUT_BYTE) > 0))
         {
-            // Clear Comm Port
-            ClearCommError(hComm, &dwError, &cs);
-            if ((dwEvent & EV_RXCHAR) && cs.cbInQue)
-            {
-                if (!ReadFile(hComm, &c, sizeof(c), &read_byte, &ovRead))
-                    printMsg();
-            }
+            c = (char) session->rxRing.at(0);
+            session->rxRing.consume(1);
         }
 
-        // If a event other than EV_RXCHAR has occured, which should be triggered by the 
-        // RETURN_COMM_EVENT macro.
-        if (dwEvent == 0)
-            // End the read thread
-            ExitThread(readThreadId);
+        // The wait was ended by a command for the engine, nothing was read
+        if (!input)
+            return c;
 
-        // Discards all characters from the output and input buffer
-        PurgeComm(hComm, PURGE_RXCLEAR | PURGE_TXCLEAR);
-        CloseHandle(ovRead.hEvent);
+        // Discards all characters from the output and input buffer, unless the rest of
+        // a setup frame is still to be read; what is neither is the rest of an exchange we
+        // are not in, a late SACK most of the time, and goes until the line is quiet
+        if (c == ENQ)
+            purgeInput();
+        else if (c != SOH)
+            drainInput();
     }
     catch (exception& e) {
         OutputDebugString(e.what());
@@ -153,91 +118,120 @@ BOOL evaluateInput(CHAR c)
     return (c == ENQ);
 }
 
-VOID waitForPacket()
+BOOL waitForPacket()
 {
+    BOOL  hold = FALSE;
+    // after a held burst the next one follows our SACK, not an ACK
+    BOOL  held = session->rxHeld;
+    session->rxHeld = FALSE;
+
     try {
-        BOOL  received = FALSE;
+        BOOL  poll = FALSE;
 
-        while (!received)
+        // the burst takes a round trip to start
+        for (;;)
         {
-            char *str;
-
-            // If timeout waiting for packet
-            if (!waitForData(&str, PACKET_SIZE, TIME_OUT_LONG))
+            DWORD wait = session->linkRtt.timeout();
+            DWORD asked = GetTickCount();
+            BOOL  buffered = session->rxRing.size() > 0;
+            if (!timeout(wait))
             {
-                // If when sender has higher priority, go to wait state
-                if (!receiverPriority && senderPriority) {
-                    OutputDebugString("Going to wait state\n");
-                    receivedENQinWait = waitForENQ();
-                }
-
-                OutputDebugString("Going back to idle\n");
-                SetEvent(Ev_Read_Thread_Finish);
-                return;
+                session->linkRtt.backoff();
+                TRACE(TRACE_NO_FRAME, 0, wait, 0);
+                return FALSE;
             }
 
-            // fixed length packet
-            if (strlen(str) == PACKET_SIZE)
+            // a sender that did not hear our ACK, or lost our SACK of a held burst, bids for the line
+            // again; it gets its ACK, and what it sends after that is a burst like any other
+            if (session->rxRing.at(0) != ENQ)
             {
-                // if the packet is validated, send an ack, otherwise continue to 
-                // wait for a new packet
-                if (validatePacket(str))
+                // the ACK went out just before, the burst answers it unless it was already there; the
+                // read that brought it in is the first of its first frame
+                if (!buffered)
                 {
-                    received = true;
+                    if (!held)
+                        session->linkRtt.sample(GetTickCount() - asked);
+                    session->readMetrics.frameReads++;
                 }
+                break;
             }
+            TRACE(TRACE_ENQ_RECEIVED, 0, 0, 0);
+            purgeInput();
+            sendACK();
+            held = FALSE;
         }
-        // send ACK to confirm a valid packet
-        sendACK();
 
-        if (!receiverPriority && senderPriority) {
-            // WAIT STATE: wait for an enq, for a specified amount of time.
-            receivedENQinWait = waitForENQ();
-        }
+        // collect the burst until its last (poll) frame arrives, the frames follow each other back to
+        // back
+        while (!poll)
+        {
+            FRAME_VIEW frame;
+            int result = waitForFrame(&frame, TIME_OUT_FRAME);
+
+            // the poll frame got lost, answer for what we have as soon as the line is quiet; the SACK
+            // of a burst that only came in garbled still tells the sender we are there
+            if (result == DECODE_NEED_MORE)
+                break;
 
-        SetEvent(Ev_Read_Thread_Finish);
-        SetEvent(Ev_Send_Thread_Finish);
+            // the frame is decoded in place in the receive ring
+            // keep validated frames, a corrupted one is reported as missing in the SACK
+            if (result == DECODE_CORRUPT)
+            {
+                TRACE(TRACE_FRAME_CORRUPT, frame.seq, frame.length, 0);
+                session->stats.add(STAT_PACKET_CORRUPTED);
+            }
+            else if (validatePacket(frame, &poll))
+                hold = hold || (frame.flags & FLAG_HOLD) != 0;
+            session->rxDecoder.release(frame);
+        }
+        // send SACK to confirm the frames of this burst
+        sendSACK();
+        // the burst goes on its way to the file while the line turns around
+        if (session->bond)
+            session->bond->sync();
+        else
+            session->fileSink.sync();
     }
     catch (exception& e) {
         OutputDebugString(e.what());
     }
+
+    session->rxHeld = hold;
+    return hold;
 }
 
-BOOL validatePacket(const char *packet)
+BOOL validatePacket(const FRAME_VIEW &frame, BOOL *poll)
 {
     string message;
-    string crcs;
 
     try {
-        // first byte is SYN
-        if (packet[0] == SYN)
+        // the decoder has checked the CRC already; a frame sent again because our SACK got lost
+        // still ends its burst and gets answered
+        *poll = (frame.flags & FLAG_POLL) != 0;
+
+        // the payload is only copied out of the ring when the window takes the frame, the sequence
+        // number alone tells a duplicate
+        if (session->rxWindow.classify(frame.seq) == ARQ_ACCEPTED)
         {
-            for (size_t i = PACKET_DATA_INDEX; i <= PACKET_DATA_SIZE; i++)
+            framePayloadCopy(frame, message);
+            // a payload that does not unpack is as good as corrupted, it stays out of the SACK and
+            // comes again
+            if (!unpackPayload(message))
             {
-                // NUL can not be the filler as the packets that contain NUL, NULL, or '\0' are simply
-                // terminated when transmitting. Ignore NUL0s in the packet.
-                if (packet[i] != NUL0)
-                    message += packet[i];
+                TRACE(TRACE_BAD_BLOCK, frame.seq, frame.payload.size(), 0);
+                session->stats.add(STAT_PACKET_CORRUPTED);
+                return FALSE;
             }
+        }
 
-            // the last 2 CRC bytes
-            crcs.push_back(packet[PACKET_SIZE - 2]);
-            crcs.push_back(packet[PACKET_SIZE - 1]);
-
-            // check if its a duplicated packet by CRCs
-            if (crcs != prev_crcs) {
-                if (!validateCheckSum(message, crcs)) {
-                    updateStats(++stats.packetCorrupted, IDC_SDATA3);
-                }
-                else {
-                    message.erase(remove_if(message.begin(), message.end(), INVALID_CHAR()), message.end());
-                    read_packets.push_back(message);
-                    addLine(&hReadPanel, message);
-                    updateStats(++stats.packetReceived, IDC_SDATA2);
-                }
-                updateStats(getBER(), IDC_SDATA6);
-                prev_crcs = crcs;
-            }
+        int result = session->rxWindow.accept(frame.seq, message);
+        TRACE(TRACE_FRAME_RECEIVED, frame.seq, frame.payload.size(), result);
+        if (result == ARQ_ACCEPTED)
+        {
+            session->stats.add(STAT_PACKET_RECEIVED);
+            // hand over everything that is now in sequence
+            while (session->rxWindow.pop(message))
+                deliverPacket(message);
         }
     }
     catch (exception& e) {
@@ -248,17 +242,46 @@ BOOL validatePacket(const char *packet)
     return TRUE;
 }
 
-int getBER() {
-    return (int)(100 * stats.packetCorrupted / (stats.packetReceived + stats.packetCorrupted));
-}
+BOOL unpackPayload(string &message)
+{
+    // a stripe of a bonded transfer keeps its header, deliverPacket() takes the offset from it
+    size_t header = session->bond ? BOND_HEADER : 0;
+    if (message.size() < header)
+        return FALSE;
 
-BOOL validateCheckSum(string data, string crcs) {
-    uint16_t crcRaw = calculateCRC16(data);
-    string crcCheck = CRCtoString(crcRaw);
-
-    if (crcCheck != crcs) {
-        return FALSE;
+    // undo the compression stage
+    if (session->linkParams.compress != COMPRESS_NONE)
+    {
+        string raw;
+        if (!decompressBlock(message.substr(header), raw))
+            return FALSE;
+        message.replace(header, string::npos, raw);
     }
 
     return TRUE;
 }
+
+VOID deliverPacket(string &message)
+{
+    uint64_t offset = 0;
+
+    // a stripe of a bonded transfer says where in the file it goes, unpackPayload() saw its header
+    if (session->bond)
+    {
+        offset = bondOffset(message);
+        message.erase(0, BOND_HEADER);
+    }
+
+    // byte for byte into the file, the panel picks up the tail on its own
+    if (session->bond)
+        session->bond->deliver(offset, message);
+    else
+        session->fileSink.write(message);
+}
+
+BOOL validateCheckSum(const char *data, size_t len, const char *crcs) {
+    uint16_t crcRaw = crc16((const uint8_t*) data, len);
+
+    // CRC is sent high byte first
+    return (BYTE) crcs[0] == (crcRaw >> 8) && (BYTE) crcs[1] == (crcRaw & 0xFF);
+}
@@ -16,14 +16,14 @@
 #include "Common.h"
 
 // function prototypes
-int getBER();
 VOID initPort();
-VOID initRead();
-DWORD WINAPI readIdle(LPVOID);
 VOID sendACK();
+VOID sendSACK();
 CHAR readInput();
 BOOL evaluateInput(CHAR);
-VOID waitForPacket();
-BOOL validatePacket(const char*);
-BOOL validateCheckSum(std::string, std::string);
+BOOL waitForPacket();
+BOOL validatePacket(const FRAME_VIEW&, BOOL*);
+BOOL unpackPayload(std::string&);
+VOID deliverPacket(std::string&);
+BOOL validateCheckSum(const char*, size_t, const char*);
 #endif
@@ -4,12 +4,15 @@
 -- PROGRAM:         RMProtocol
 --
 -- Functions
---                  DWORD WINAPI loadPacketThread(LPVOID lpvoid);
---                  VOID initWrite(char* packet);
---                  DWORD WINAPI transferPacket(LPVOID packet);
---                  BOOL confirmLine();
---                  VOID sendPacket(char* str);
+--                  int confirmLine();
+--                  DWORD bidBackoff(int result);
+--                  VOID sendBurst(SendWindow* window, std::vector<std::pair<BYTE, size_t>> &burstFrames, BOOL hold);
+--                  BOOL awaitSack(SendWindow* window, const std::vector<std::pair<BYTE, size_t>> &burstFrames,
+--                                 BOOL resent, size_t *acked);
+--                  VOID adaptPayload(SendWindow* window);
 --                  BOOL evalResponse(char c);
+--                  double retransmissionRatio();
+--                  double bidSuccessRate();
 --
 -- DATE:            December 3, 2016
 --
@@ -18,127 +21,234 @@
 -- PROGRAMMER:      Fred Yang
 --
 -- NOTES:
--- This class wraps the basic writing operations on serial comm port.
+-- This class wraps the basic writing operations on serial comm port. The engine thread in Engine.cpp
+-- calls them from its bid, send and wait-ACK states.
+--
+-- Both stations bid for the line the same way, so they often bid at once. An ENQ heard in answer to
+-- ours is a collision, and so is any other reply but an ACK, the peer is on the line either way; on a
+-- half-duplex radio the two ENQs may just as well wipe each other out, and a bid that goes unanswered
+-- is handled as one too, but only that one counts towards giving up the send. Either way the station backs off a random number
+-- of slots, listening for the peer's bid all the while, with the range doubling after each failed
+-- bid in a row up to 2^BID_MAX_EXPONENT slots. The station that drew fewer slots bids again first and
+-- the other answers it. A station the peer has beaten BID_MAX_LOSSES rounds in a row takes the first
+-- slot of the next round, so a station that keeps winning cannot shut the other one out.
 ----------------------------------------------------------------------------------------------------------------------*/
 #include "SerialWrite.h"
+#include "LinkSession.h"
+#include <cmath>
+#include <random>
 #pragma warning (disable: 4996)
 using namespace std;
 
-// write lock
-HANDLE hWrite_Lock = CreateMutex(NULL, FALSE, WRITE_LOCK);
-// send thread finish event
-HANDLE Ev_Send_Thread_Finish = CreateEvent(NULL, TRUE, FALSE, NULL);
-
-DWORD WINAPI loadPacketThread(LPVOID lpvoid)
+int confirmLine()
 {
-    try {
-        write_packets.clear();
-        write_packets = parseData();
-
-        for (auto packet : write_packets)
+    DWORD numTries_confirmLine = 0;
+    int result = BID_UNANSWERED;
+
+    // bid for the line with an ENQ until the receiver acknowledges it
+    while (numTries_confirmLine < LINE_TRIES) {
+        char c = ENQ;
+        const char *str = "";
+        // whatever is still buffered came before the bid, it cannot be the answer to it
+        purgeInput();
+        sendData(&c, sizeof(c));
+        DWORD sent = GetTickCount();
+        TRACE(TRACE_ENQ_SENT, 0, numTries_confirmLine, 0);
+        session->bidMetrics.bids++;
+
+        if (!waitForData(&str, 1, session->linkRtt.timeout()))
         {
-            char *tmp = new char[packet.length() + 1];
-            *tmp = 0;
-            strncat(tmp, packet.c_str(), packet.length() + 1);
-            WaitForSingleObject(Ev_Read_Thread_Finish, TIME_OUT_LONG);
-            ResetEvent(Ev_Read_Thread_Finish);
-            // stats sendPackets
-            updateStats(++stats.packetSent, IDC_SDATA0);
+            session->linkRtt.backoff();
+            session->bidMetrics.unanswered++;
         }
-    }
-    catch (exception& e) {
-        OutputDebugString(e.what());
+        // an ACK with more right behind it is the start of a late SACK, not the answer to our bid
+        else if (evalResponse(str[0]) && session->rxRing.size() == 0)
+        {
+            TRACE(TRACE_LINE_ACKED, 0, GetTickCount() - sent, 0);
+            // an ACK after a repeated ENQ could answer either of them
+            if (numTries_confirmLine == 0)
+                session->linkRtt.sample(GetTickCount() - sent);
+            session->bidMetrics.won++;
+            // the round is over, and the peer did not win it
+            session->bidFailures = 0;
+            session->bidsLost = 0;
+            return BID_WON;
+        }
+        else
+        {
+            // the peer bid at the same time, or was still answering something else; either way it is
+            // there and on the line, what is left of its answer goes
+            if (str[0] != ENQ)
+                drainInput();
+            TRACE(TRACE_BID_COLLIDED, 0, GetTickCount() - sent, session->bidFailures);
+            session->bidMetrics.collided++;
+            result = BID_COLLIDED;
+        }
+
+        numTries_confirmLine++;
     }
 
-    return 0;
+    return result;
 }
 
-VOID initWrite(char* packet)
+DWORD bidBackoff(int result)
 {
-    try {
-        errorCheck((writeThread = CreateThread(NULL, 0, transferPacket, (LPVOID)packet, 0, &writeThreadId)) 
-            == NULL ? ERR_WRITE_THREAD : NO_ERR);
-        WaitForSingleObject(Ev_Send_Thread_Finish, INFINITE);
-        ResetEvent(Ev_Send_Thread_Finish);
+    DWORD wait;
+    session->bidFailures++;
+
+    if (!session->randomBackoff)
+    {
+        // the same wait as after a burst, two stations that bid at once come back at once
+        wait = max<DWORD>(TIME_OUT_SHORT, session->linkRtt.timeout());
     }
-    catch (exception& e) {
-        OutputDebugString(e.what());
+    else
+    {
+        // before the link has a round trip, a slot is as long as the shortest wait for the peer's bid
+        double rtt = session->linkRtt.samples() ? session->linkRtt.srtt() : TIME_OUT_SHORT;
+        DWORD slot = max<DWORD>(BID_SLOT_MIN, (DWORD) ceil(rtt));
+
+        // each station draws from a generator of its own, seeded in its engine so a forked peer differs
+        if (!session->bidRandom)
+            session->bidRandom = ((uint64_t) random_device()() << 32 | random_device()()) | 1;
+        session->bidRandom ^= session->bidRandom << 13;
+        session->bidRandom ^= session->bidRandom >> 7;
+        session->bidRandom ^= session->bidRandom << 17;
+
+        DWORD range = 1u << min<DWORD>(session->bidFailures, BID_MAX_EXPONENT);
+        DWORD slots = session->bidsLost >= BID_MAX_LOSSES ? 0 : (DWORD) (session->bidRandom % range);
+        wait = slots * slot;
     }
+
+    TRACE(TRACE_BACKOFF, 0, wait, result);
+    session->bidMetrics.backoffs++;
+    session->bidMetrics.backoffMs += wait;
+    return wait;
 }
 
-DWORD WINAPI transferPacket(LPVOID packet)
+VOID sendBurst(SendWindow* window, vector<pair<BYTE, size_t>> &burstFrames, BOOL hold)
 {
-    try {
-        ResetEvent(Ev_Read_Thread_Finish);
-        SetCommMask(hComm, RETURN_COMM_EVENT);
-        WaitForSingleObject(hWrite_Lock, TIME_OUT_LONG);
-
-        char* s = (char*) packet;
-
-        if (!confirmLine()) 
-        {
-            OutputDebugString("exceeded confirm line max tries\n");
-
-            //WAIT STATE: wait for an enq, for a specified amount of time.
-            receivedENQinWait = waitForENQ();
-            ReleaseMutex(hWrite_Lock);
-            SetEvent(Ev_Send_Thread_Finish);
-            return 0;
-        }
-
-        sendPacket(s);
-
-        // Check priorities to determine if go directly to read idle, or
-        // just wait for ENQ
-        if (!(receiverPriority && !senderPriority))
-        {
-            receivedENQinWait = waitForENQ();
-        }
-        else {
-            SetEvent(Ev_Send_Thread_Finish);
-        }
-
-        //going back to wait/idle state
-        ReleaseMutex(hWrite_Lock);
-        initRead();
-
-        // reset send panel
-        clearBox(&hSendPanel);
+    vector<ARQ_FRAME*> frames;
+
+    // Every frame of the window that has not been acknowledged goes out in one burst
+    window->burst(frames);
+
+    // the frame pointers do not outlive the SACK, keep what the link quality needs
+    burstFrames.clear();
+    for (ARQ_FRAME *frame : frames)
+        burstFrames.push_back(make_pair(frame->seq, frameSize(frame->payload.length())));
+
+    DWORD burstStart = GetTickCount();
+    size_t burstBytes = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        // every frame says the line is held, the receiver only needs one of them to get through
+        BYTE flags = ((i + 1 == frames.size()) ? FLAG_POLL : 0) | (hold ? FLAG_HOLD : 0);
+        string frame = buildFrame(frames[i]->seq, flags, frames[i]->payload);
+        uint64_t written = latencyClock();
+        sendData(&frame[0], frame.length());
+        session->stateLatency[LATENCY_FRAME_WRITE].record(latencyClock() - written);
+        TRACE(TRACE_FRAME_SENT, frames[i]->seq, frame.length(), frames[i]->payload.length());
+        burstBytes += frame.length();
+        session->stats.add(STAT_PACKET_SENT);
+    }
+    session->linkQuality.recordBurst(burstBytes, GetTickCount() - burstStart);
+}
 
-        delete[] s;
+BOOL awaitSack(SendWindow* window, const vector<pair<BYTE, size_t>> &burstFrames, BOOL resent, size_t *acked)
+{
+    // Wait for the selective acknowledgement of the burst
+    const char *str = "";
+    DWORD length = 0;
+    DWORD sent = GetTickCount();
+    SACK sack;
+    *acked = 0;
+
+    // the receiver answers a burst whose poll frame got lost once the line has been quiet for
+    // TIME_OUT_FRAME, a round trip after that is the latest its SACK can be in
+    DWORD wait = session->linkRtt.timeout() + TIME_OUT_FRAME;
+    if (!waitForData(&str, SACK_SIZE, wait, &length))
+    {
+        TRACE(TRACE_SACK_TIMEOUT, 0, burstFrames.size(), GetTickCount() - sent);
+        // the receiver only stays quiet when it heard none of the burst, the SACK is too short to
+        // be the one that got lost most of the time
+        for (const auto &frame : burstFrames)
+            session->linkQuality.record(frame.second, FALSE);
+        adaptPayload(window);
+        session->linkRtt.backoff();
+        return FALSE;
     }
-    catch (exception& e) {
-        OutputDebugString(e.what());
+    // a SACK that fails its CRC is as good as lost, the burst goes again
+    if (!decodeSack(str, length, &sack))
+        return FALSE;
+    // a SACK after a repeated burst could answer either of them, and one for a burst whose poll
+    // frame got lost comes after the receiver's wait for it
+    if (!resent && !burstFrames.empty() && sackCovers(sack, burstFrames.back().first))
+        session->linkRtt.sample(GetTickCount() - sent);
+
+    // whatever the SACK does not cover was lost or corrupted on the way
+    for (const auto &frame : burstFrames)
+        session->linkQuality.record(frame.second, sackCovers(sack, frame.first));
+    adaptPayload(window);
+
+    *acked = window->onSack(sack);
+    TRACE(TRACE_SACK_RECEIVED, sack.base, sack.mask, *acked);
+    // a file reports how far into it the window is, text how many frames got through
+    if (session->fileSource.isOpen())
+        updateProgressBar((int)(progressSize * session->fileSource.position() /
+            max<uint64_t>(1, session->fileSource.size())));
+    else if (session->transfer.queue)
+    {
+        FRAME_QUEUE_METRICS queued = session->transfer.queue->metrics();
+        updateProgressBar((int)(progressSize * (queued.popped - window->outstanding()) /
+            max<size_t>(1, queued.pushed)));
     }
-
-    return 0;
+    session->stats.add(STAT_ACKS_RECEIVED);
+    return TRUE;
 }
 
-VOID sendPacket(char* str) { 
-    DWORD numTries_sendPacket = 0;
-
-    // Try to send the packet until we reach the maximum attempts
-    while (numTries_sendPacket < SEND_TRIES) {
-        // Send the packet
-        sendData(str, strlen(str), hWrite_Lock);
-
-        // Wait for a response for the packet we sent
-        char *str = "";
+BOOL evalResponse(char c)
+{
+    return (c == ACK);
+}
 
-        if (!waitForData(&str, 1, TIME_OUT_LONG))
-        {
-            updateStats(++stats.packetSent, IDC_SDATA0);
-            numTries_sendPacket++;
-            continue;
-        }
-        else if (evalResponse (str[0])) {
-            updateProgressBar (progressSize / write_packets.size());
-            updateStats(++stats.acksReceived, IDC_SDATA4);
-            return;
-        }
-    }
+double retransmissionRatio()
+{
+    size_t total = session->sendMetrics.framesSent + session->sendMetrics.framesResent;
+    return total ? (double) session->sendMetrics.framesResent / total : 0.0;
+}
 
-    // reaches the maximum attempts
-    updateStats(++stats.packetLost, IDC_SDATA1);
+double bidSuccessRate()
+{
+    return session->bidMetrics.bids ? (double) session->bidMetrics.won / session->bidMetrics.bids : 0.0;
 }
 
+VOID adaptPayload(SendWindow* window)
+{
+    if (!session->linkParams.adaptive || session->linkQuality.frames() < QUALITY_MIN_FRAMES)
+        return;
+
+    // the line bid and the SACK each take about a round trip, at the rate the line takes bytes
+    double burstOverhead = 2 * session->linkRtt.srtt() * session->linkQuality.lineRate() + 1 + 1 + SACK_SIZE;
+    double ber = session->linkQuality.ber();
+    size_t current = window->payloadSize();
+    // frames the source did not fill are as large as they get, the frames it did fill could grow
+    size_t fill = window->fullest() < current ? window->fullest() : 0;
+    size_t frames = session->linkParams.window;
+    size_t best = bestPayload(ber, burstOverhead, frames, session->linkParams.maxPayload, fill);
+
+    // the estimate comes from smaller frames, grow by doubling at most; shrink at once, but only on
+    // frames that got lost, the estimate of a clean history is a guess
+    best = min<size_t>(best, current * 2);
+    if (best < current && session->linkQuality.failed() == 0)
+        return;
+    double efficiency = payloadEfficiency(best, ber, burstOverhead, frames, fill);
+    if (best == current ||
+        efficiency < payloadEfficiency(current, ber, burstOverhead, frames, fill) * QUALITY_HYSTERESIS)
+        return;
+
+    SIZE_DECISION decision = { GetTickCount(), session->linkQuality.frames(), session->linkQuality.failed(), ber,
+        (WORD) current, (WORD) best, efficiency };
+    session->sizeTrace.record(decision);
+    window->setMaxPayload(best);
+    session->txPayload = (WORD) best;
+}
@@ -15,11 +15,53 @@
 #define SERIAL_WRITE_H
 #include "Common.h"
 
+// Send path counters over every transfer, resends / (sent + resends) is the retransmission ratio
+struct SEND_METRICS {
+    size_t framesSent;
+    size_t framesResent;
+    // ms from the first transmission of a frame to its acknowledgement, of every transfer in a few
+    // buckets however long the link runs
+    LatencyHistogram frameLatency;
+    // send queue of the text transfers: most payloads waiting, and waits on a full or empty queue
+    size_t queueMaxDepth;
+    size_t queueFullStalls;
+    size_t queueEmptyStalls;
+    // bursts sent on a bid won for an earlier one, and the ms of turnaround and bids that saved
+    size_t burstsHeld;
+    double turnaroundSavedMs;
+};
+
+// Line bids over the life of the link; won / bids is the bid success rate
+struct BID_METRICS {
+    size_t bids;
+    size_t won;
+    size_t collided;        // the peer's ENQ came back in answer to ours
+    size_t unanswered;
+    // waits drawn after a failed bid, and the ms they added up to
+    size_t backoffs;
+    uint64_t backoffMs;
+};
+
+// result of confirmLine()
+#define BID_WON             0
+#define BID_COLLIDED        1
+#define BID_UNANSWERED      2
+
+// A failed bid backs off a random number of slots, from [0, 2^n) after n failed bids in a row, n capped
+#define BID_MAX_EXPONENT    5
+// Shortest backoff slot in ms; a slot is at least a round trip, so the peer hears a bid made a slot earlier
+#define BID_SLOT_MIN        10
+// Contention rounds in a row the peer may win before this station takes the first slot of the next one
+#define BID_MAX_LOSSES      2
+
 // function prototypes
-DWORD WINAPI loadPacketThread(LPVOID lpvoid);
-VOID initWrite(char* packet);
-DWORD WINAPI transferPacket(LPVOID packet);
-BOOL confirmLine();
-VOID sendPacket(char* str);
+int confirmLine();
+DWORD bidBackoff(int result);
+VOID sendBurst(SendWindow* window, std::vector<std::pair<BYTE, size_t>> &burstFrames, BOOL hold);
+BOOL awaitSack(SendWindow* window, const std::vector<std::pair<BYTE, size_t>> &burstFrames, BOOL resent,
+    size_t *acked);
+VOID adaptPayload(SendWindow* window);
 BOOL evalResponse(char c);
+double retransmissionRatio();
+double bidSuccessRate();
 #endif
\ No newline at end of file
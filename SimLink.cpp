@@ -0,0 +1,504 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     SimLink.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  SimTransport::SimTransport(int fd, BYTE station, const SIM_PARAMS &params);
+--                  DWORD SimTransport::read(uint8_t *dst, DWORD size, DWORD msec);
+--                  BOOL SimTransport::write(const uint8_t *src, DWORD size);
+--                  BOOL SimTransport::waitForInput();
+--                  VOID SimTransport::wake();
+--                  VOID SimTransport::purge();
+--                  BOOL SimTransport::isOpen();
+--                  VOID SimTransport::hangUp();
+--                  VOID SimTransport::close();
+--                  SIM_STATS SimTransport::stats();
+--                  BOOL parseSimSpec(const char *spec, SIM_PARAMS *params);
+--                  int simFork(const SIM_PARAMS &params);
+--                  int simForkLinks(const std::vector<SIM_PARAMS> &params, std::vector<Transport *> &links);
+--                  int simJoin(int peer);
+--                  BOOL simStats(SIM_STATS *stats);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- A simulated half-duplex radio link. simFork() splits the process in two stations joined by a socket
+-- pair, and each one talks through a SimTransport, so the real state machine runs on both ends.
+-- simForkLinks() joins the two stations by several links at once, for a bonded transfer.
+--
+-- The station that sends a byte applies the whole channel model to it:
+--
+-- - The byte takes SIM_BITS_PER_BYTE bit times at the baud rate, then arrives after the latency.
+-- - The station cannot key up until the turnaround time has passed since it last heard the line.
+-- - Bits flip independently at the BER, and in bursts that start at the burst rate.
+-- - The byte can be dropped on the air, and is while the link is down.
+-- - The byte is lost when the modem buffer is full.
+--
+-- A byte that arrives while its receiver is keyed up is lost as well.
+--
+-- Each station draws from its own generator, seeded from the seed and the station number, in the
+-- order it sends bytes. The same transfer with the same seed hits the same errors. Thread timing is
+-- still real time. Linux only, like the headless driver that uses it.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "SimLink.h"
+#include "Common.h"
+#include "LinkSession.h"
+#include "LinkPool.h"
+#ifndef _WIN32
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+using namespace std;
+
+// this station's ends of the simulated links, if any
+static vector<SimTransport *> simLinks;
+
+// ms on a clock both stations share
+static double clockMs()
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SimTransport::SimTransport(int fd, BYTE station, const SIM_PARAMS &params)
+    : fd(fd), params(params), burstLeft(0), lineFree(0), lastHeard(-1e18), started(clockMs()), open(TRUE),
+      closing(FALSE)
+{
+    memset(&counters, 0, sizeof(counters));
+    rng = ((uint64_t) params.seed << 1) | station;
+    nextError = bitsUntil(params.ber);
+    nextBurst = bitsUntil(params.burstRate);
+
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    if (pipe(wakeFd) == 0)
+    {
+        fcntl(wakeFd[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFd[1], F_SETFL, O_NONBLOCK);
+    }
+    line = thread(&SimTransport::deliver, this);
+}
+
+SimTransport::~SimTransport()
+{
+    close();
+    ::close(fd);
+    ::close(wakeFd[0]);
+    ::close(wakeFd[1]);
+}
+
+uint64_t SimTransport::random()
+{
+    // splitmix64
+    uint64_t z = (rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t SimTransport::bitsUntil(double rate)
+{
+    if (rate <= 0)
+        return UINT64_MAX;
+    if (rate >= 1)
+        return 0;
+
+    // geometric gap, one draw per error instead of one per bit
+    double u = ((random() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return (uint64_t) floor(log(u) / log1p(-rate));
+}
+
+BYTE SimTransport::impair(BYTE b, BOOL *lost)
+{
+    *lost = params.dropRate > 0 && (random() >> 11) * (1.0 / 9007199254740992.0) < params.dropRate;
+
+    for (int bit = 0; bit < 8; bit++)
+    {
+        BOOL flip = FALSE;
+        if (burstLeft > 0)
+        {
+            burstLeft--;
+            flip = random() & 1;
+        }
+        else if (nextBurst-- == 0)
+        {
+            burstLeft = params.burstLength ? params.burstLength - 1 : 0;
+            flip = random() & 1;
+            nextBurst = bitsUntil(params.burstRate);
+        }
+        if (nextError-- == 0)
+        {
+            flip = !flip;
+            nextError = bitsUntil(params.ber);
+        }
+
+        if (flip)
+        {
+            b ^= (BYTE) (1 << bit);
+            counters.bitsFlipped++;
+        }
+    }
+
+    return b;
+}
+
+BOOL SimTransport::write(const uint8_t *src, DWORD size)
+{
+    unique_lock<mutex> guard(lock);
+    if (!open)
+        return FALSE;
+
+    double now = clockMs();
+    double byteTime = params.baud ? SIM_BITS_PER_BYTE * 1000.0 / params.baud : 0;
+    // keying up has to wait out the turnaround after the last byte heard
+    lineFree = max(lineFree, max(now, lastHeard + params.turnaround));
+
+    for (DWORD i = 0; i < size; i++)
+    {
+        // the modem only holds so much that is not on the air yet
+        if (params.buffer && byteTime > 0 && (lineFree - now) / byteTime >= params.buffer)
+        {
+            counters.bytesOverflow++;
+            continue;
+        }
+
+        lineFree += byteTime;
+        counters.lineBusyMs += byteTime;
+        counters.bytesSent++;
+
+        BOOL lost;
+        BYTE b = impair(src[i], &lost);
+        // a link that went down takes nothing across until it comes back, if it does
+        if (params.down && lineFree >= started + params.down && (!params.up || lineFree < started + params.up))
+            lost = TRUE;
+        if (lost)
+            counters.bytesDropped++;
+        else
+            air.push_back(make_pair(lineFree + params.latency, b));
+    }
+    queued.notify_one();
+
+    double done = lineFree;
+    guard.unlock();
+
+    // without a modem buffer the write lasts as long as the bytes take on the line
+    if (!params.buffer && done > now)
+        poolSleep(done - now);
+    return TRUE;
+}
+
+VOID SimTransport::deliver()
+{
+    vector<uint8_t> due;
+    unique_lock<mutex> guard(lock);
+
+    // hands each byte to the peer once it has crossed the air
+    while (!closing || !air.empty())
+    {
+        if (air.empty())
+        {
+            queued.wait(guard);
+            continue;
+        }
+
+        double now = clockMs();
+        if (air.front().first > now)
+        {
+            queued.wait_for(guard, chrono::duration<double, milli>(air.front().first - now));
+            continue;
+        }
+
+        due.clear();
+        while (!air.empty() && air.front().first <= now)
+        {
+            due.push_back(air.front().second);
+            air.pop_front();
+        }
+
+        guard.unlock();
+        for (size_t sent = 0; sent < due.size();)
+        {
+            ssize_t n = ::write(fd, &due[sent], due.size() - sent);
+            if (n > 0)
+                sent += (size_t) n;
+            else if (n < 0 && (errno == EAGAIN || errno == EINTR))
+            {
+                struct pollfd p = { fd, POLLOUT, 0 };
+                poll(&p, 1, TIME_OUT);
+            }
+            else
+                break;
+        }
+        this_thread::sleep_for(chrono::milliseconds(SIM_DELIVER_MS));
+        guard.lock();
+    }
+
+    shutdown(fd, SHUT_WR);
+}
+
+DWORD SimTransport::hear(DWORD n)
+{
+    lock_guard<mutex> guard(lock);
+    double now = clockMs();
+    counters.bytesHeard += n;
+
+    // half duplex, nothing is heard while this station is on the air
+    if (now < lineFree)
+    {
+        counters.bytesCollided += n;
+        return 0;
+    }
+
+    lastHeard = now;
+    return n;
+}
+
+DWORD SimTransport::read(uint8_t *dst, DWORD size, DWORD msec)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(msec);
+
+    for (;;)
+    {
+        BOOL live = isOpen();
+        if (live)
+        {
+            session->readMetrics.readCalls++;
+            ssize_t n = ::read(fd, dst, size);
+            if (n > 0)
+            {
+                DWORD heard = hear((DWORD) n);
+                if (heard > 0)
+                    return heard;
+                continue;
+            }
+            if (n == 0)
+            {
+                hangUp();
+                live = FALSE;
+            }
+            else if (errno == EINTR)
+                continue;
+            else if (errno != EAGAIN)
+                live = FALSE;
+        }
+
+        auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (left <= 0)
+            return 0;
+
+        // nothing more comes from a line that is gone, but the caller still gets the wait it asked
+        // for instead of spinning on it
+        if (!live)
+        {
+            poolSleep((double) left);
+            return 0;
+        }
+        struct pollfd p = { fd, POLLIN, 0 };
+        poolPoll(&p, 1, (int) left);
+    }
+}
+
+BOOL SimTransport::waitForInput()
+{
+    char drain[16];
+    // the pipe keeps a wake from before this wait, which then ends at once; once the peer is gone
+    // only wake() ends it
+    struct pollfd p[2] = { { wakeFd[0], POLLIN, 0 }, { fd, POLLIN, 0 } };
+    while (poolPoll(p, isOpen() ? 2 : 1, -1) < 0 && errno == EINTR)
+        ;
+
+    if (p[0].revents & POLLIN)
+    {
+        while (::read(wakeFd[0], drain, sizeof(drain)) > 0)
+            ;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+VOID SimTransport::wake()
+{
+    char c = 0;
+    if (::write(wakeFd[1], &c, 1) < 0)
+        OutputDebugString("SimTransport::wake failed\n");
+}
+
+VOID SimTransport::purge()
+{
+    uint8_t drop[256];
+    ssize_t n;
+    while ((n = ::read(fd, drop, sizeof(drop))) > 0)
+        ;
+    if (n == 0)
+        hangUp();
+}
+
+BOOL SimTransport::isOpen()
+{
+    lock_guard<mutex> guard(lock);
+    return open;
+}
+
+VOID SimTransport::hangUp()
+{
+    // write() looks at it under the lock as well
+    lock_guard<mutex> guard(lock);
+    open = FALSE;
+}
+
+VOID SimTransport::close()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        closing = TRUE;
+        queued.notify_one();
+    }
+    if (line.joinable())
+        line.join();
+}
+
+SIM_STATS SimTransport::stats()
+{
+    lock_guard<mutex> guard(lock);
+    return counters;
+}
+
+BOOL parseSimSpec(const char *spec, SIM_PARAMS *params)
+{
+    params->baud = 9600;
+    params->latency = 0;
+    params->turnaround = 0;
+    params->ber = 0;
+    params->burstRate = 0;
+    params->burstLength = 32;
+    params->dropRate = 0;
+    params->buffer = 0;
+    params->down = 0;
+    params->up = 0;
+    params->seed = 1;
+
+    // "baud=9600,latency=20,ber=1e-5,..." where every key is optional
+    string s(spec);
+    size_t pos = 0;
+    while (pos < s.length())
+    {
+        size_t end = s.find(',', pos);
+        string item = s.substr(pos, end == string::npos ? string::npos : end - pos);
+        pos = end == string::npos ? s.length() : end + 1;
+        if (item.empty() || item == "default")
+            continue;
+
+        size_t eq = item.find('=');
+        if (eq == string::npos)
+            return FALSE;
+        string key = item.substr(0, eq);
+        const char *value = item.c_str() + eq + 1;
+
+        if (key == "baud")
+            params->baud = (DWORD) atol(value);
+        else if (key == "latency")
+            params->latency = (DWORD) atol(value);
+        else if (key == "turnaround")
+            params->turnaround = (DWORD) atol(value);
+        else if (key == "ber")
+            params->ber = atof(value);
+        else if (key == "burst")
+            params->burstRate = atof(value);
+        else if (key == "burstlen")
+            params->burstLength = (DWORD) atol(value);
+        else if (key == "drop")
+            params->dropRate = atof(value);
+        else if (key == "buffer")
+            params->buffer = (DWORD) atol(value);
+        else if (key == "down")
+            params->down = (DWORD) atol(value);
+        else if (key == "up")
+            params->up = (DWORD) atol(value);
+        else if (key == "seed")
+            params->seed = (uint32_t) strtoul(value, NULL, 0);
+        else
+            return FALSE;
+    }
+
+    return params->ber >= 0 && params->ber < 1 && params->burstRate >= 0 && params->burstRate < 1 &&
+        params->dropRate >= 0 && params->dropRate < 1;
+}
+
+int simFork(const SIM_PARAMS &params)
+{
+    vector<Transport *> links;
+    int pid = simForkLinks(vector<SIM_PARAMS>(1, params), links);
+    if (pid >= 0)
+        session->transport = links[0];
+    return pid;
+}
+
+int simForkLinks(const vector<SIM_PARAMS> &params, vector<Transport *> &links)
+{
+    vector<int> fds;
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+            break;
+        fds.push_back(sv[0]);
+        fds.push_back(sv[1]);
+    }
+
+    // nothing buffered may be written out twice
+    fflush(stdout);
+    fflush(stderr);
+
+    int pid = fds.size() == 2 * params.size() ? fork() : -1;
+    if (pid < 0)
+    {
+        for (int fd : fds)
+            ::close(fd);
+        return -1;
+    }
+
+    // station 0 is the parent, station 1 the forked peer, on every link
+    BYTE station = pid == 0 ? 1 : 0;
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        ::close(fds[2 * i + 1 - station]);
+        simLinks.push_back(new SimTransport(fds[2 * i + station], station, params[i]));
+        links.push_back(simLinks.back());
+    }
+    return pid;
+}
+
+int simJoin(int peer)
+{
+    // the peer sees the lines go away once everything sent so far has crossed them
+    for (SimTransport *link : simLinks)
+        link->close();
+
+    int status;
+    if (waitpid(peer, &status, 0) != peer || !WIFEXITED(status))
+        return 1;
+    return WEXITSTATUS(status);
+}
+
+BOOL simStats(SIM_STATS *stats)
+{
+    // the link of the calling thread's session
+    for (SimTransport *link : simLinks)
+        if (link == session->transport)
+        {
+            *stats = link->stats();
+            return TRUE;
+        }
+    return FALSE;
+}
+#endif
@@ -0,0 +1,107 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     SimLink.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the channel model and the class declaration for the simulated half-duplex
+-- link. Two stations talk over it with the real engine on both ends, one process each, and without
+-- any modem.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef SIM_LINK_H
+#define SIM_LINK_H
+#include "Transport.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+// Bits on the line per byte, 8N1
+#define SIM_BITS_PER_BYTE   10
+// Bytes that crossed the air are handed over at most this often, like a UART FIFO interrupt
+#define SIM_DELIVER_MS      1
+
+// Channel model, applied to the bytes a station sends
+struct SIM_PARAMS {
+    DWORD       baud;           // 0 does not pace the line at all
+    DWORD       latency;        // ms from the end of a byte on one side to the other side
+    DWORD       turnaround;     // ms a station needs to key up after it last heard the line
+    double      ber;            // independent bit errors, per bit
+    double      burstRate;      // chance per bit that an error burst starts
+    DWORD       burstLength;    // bits in a burst, each one flipped with probability 1/2
+    double      dropRate;       // bytes lost on the air, per byte
+    DWORD       buffer;         // modem transmit buffer in bytes, overflow is lost; 0 blocks the writer
+    DWORD       down;           // ms from the start after which every byte is lost, 0 for never
+    DWORD       up;             // ms from the start after which a link that went down is back, 0 for never
+    uint32_t    seed;
+};
+
+// What the channel did to the bytes this station sent
+struct SIM_STATS {
+    uint64_t    bytesSent;
+    uint64_t    bytesDropped;
+    uint64_t    bytesOverflow;
+    uint64_t    bitsFlipped;
+    uint64_t    bytesCollided;  // heard while keyed up, lost on a half-duplex line
+    uint64_t    bytesHeard;     // from the peer, what reached this station intact or not
+    double      lineBusyMs;     // time this station held the line
+};
+
+class SimTransport : public Transport {
+public:
+    SimTransport(int fd, BYTE station, const SIM_PARAMS &params);
+    ~SimTransport();
+
+    DWORD       read(uint8_t *dst, DWORD size, DWORD msec);
+    BOOL        write(const uint8_t *src, DWORD size);
+    BOOL        waitForInput();
+    VOID        wake();
+    VOID        purge();
+    BOOL        isOpen();
+
+    // no more bytes from this side, the peer sees the line go away
+    VOID        close();
+    SIM_STATS   stats();
+
+private:
+    BYTE        impair(BYTE b, BOOL *lost);
+    uint64_t    random();
+    uint64_t    bitsUntil(double rate);
+    DWORD       hear(DWORD n);
+    // the peer closed its end, nothing more comes in and nothing goes out
+    VOID        hangUp();
+    VOID        deliver();
+
+    int                 fd;
+    int                 wakeFd[2];
+    SIM_PARAMS          params;
+    SIM_STATS           counters;
+    uint64_t            rng;
+    uint64_t            nextError;      // bits until the next independent error
+    uint64_t            nextBurst;      // bits until the next burst starts
+    DWORD               burstLeft;
+    double              lineFree;       // ms when the transmitter is done with what it has
+    double              lastHeard;
+    double              started;
+    BOOL                open;
+    BOOL                closing;
+    std::deque<std::pair<double, uint8_t>> air;
+    std::mutex          lock;
+    std::condition_variable queued;
+    std::thread         line;
+};
+
+// function prototypes
+BOOL parseSimSpec(const char *spec, SIM_PARAMS *params);
+int simFork(const SIM_PARAMS &params);
+int simForkLinks(const std::vector<SIM_PARAMS> &params, std::vector<Transport *> &links);
+int simJoin(int peer);
+BOOL simStats(SIM_STATS *stats);
+#endif
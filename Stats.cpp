@@ -0,0 +1,65 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Stats.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  LinkStats::LinkStats();
+--                  VOID LinkStats::add(int counter, int n);
+--                  FILE_STATISTICS LinkStats::snapshot() const;
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The engine counts on the line's time, so counting is a few stores and nothing else: no lock, no
+-- message to the dialog. The dialog and the headless driver take a snapshot every STATS_REFRESH ms
+-- and show what changed.
+--
+-- A snapshot is taken like a sequence lock. add() makes the version odd, counts, and makes it even
+-- again; a reader copies the counters between two reads of the version, and copies them again when
+-- the version was odd or moved. A frame and its ACK are never seen half counted.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Stats.h"
+using namespace std;
+
+LinkStats::LinkStats()
+    : version(0)
+{
+    for (auto &counter : counters)
+        counter = 0;
+}
+
+VOID LinkStats::add(int counter, int n)
+{
+    // one writer, so nothing moves the version in between
+    unsigned v = version.load(memory_order_relaxed);
+    version.store(v + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    counters[counter].store(counters[counter].load(memory_order_relaxed) + n, memory_order_relaxed);
+    version.store(v + 2, memory_order_release);
+}
+
+FILE_STATISTICS LinkStats::snapshot() const
+{
+    FILE_STATISTICS s;
+    unsigned before, after;
+
+    do {
+        before = version.load(memory_order_acquire);
+        s.packetSent = counters[STAT_PACKET_SENT].load(memory_order_relaxed);
+        s.packetLost = counters[STAT_PACKET_LOST].load(memory_order_relaxed);
+        s.packetReceived = counters[STAT_PACKET_RECEIVED].load(memory_order_relaxed);
+        s.packetCorrupted = counters[STAT_PACKET_CORRUPTED].load(memory_order_relaxed);
+        s.acksReceived = counters[STAT_ACKS_RECEIVED].load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = version.load(memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    int frames = s.packetReceived + s.packetCorrupted;
+    s.bitErrorRate = frames ? 100 * s.packetCorrupted / frames : 0;
+    return s;
+}
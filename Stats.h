@@ -0,0 +1,54 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Stats.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the macro definitions and class declaration for the link counters the
+-- engine keeps, and the snapshot of them that the dialog and the headless driver read.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef STATS_H
+#define STATS_H
+#include "Platform.h"
+#include <atomic>
+
+// Counters of a link
+#define STAT_PACKET_SENT        0
+#define STAT_PACKET_LOST        1
+#define STAT_PACKET_RECEIVED    2
+#define STAT_PACKET_CORRUPTED   3
+#define STAT_ACKS_RECEIVED      4
+#define STAT_COUNTERS           5
+
+// ms between two looks at the counters by the dialog or the headless driver
+#define STATS_REFRESH           250
+
+// File stats, a snapshot of the counters
+struct FILE_STATISTICS {
+	int packetSent;
+    int packetLost;
+	int packetReceived;
+	int packetCorrupted;
+	int acksReceived;
+	int bitErrorRate;       // percent of the frames received that were corrupted
+};
+
+// Counters of one link. Only the engine thread of the link counts, any thread may take a snapshot.
+class LinkStats {
+public:
+    LinkStats();
+
+    VOID            add(int counter, int n = 1);
+    // every counter as of one moment, never halfway through an add()
+    FILE_STATISTICS snapshot() const;
+
+private:
+    std::atomic<int>        counters[STAT_COUNTERS];
+    // odd while an add() is in progress, a snapshot that saw it change is taken again
+    std::atomic<unsigned>   version;
+};
+#endif
@@ -0,0 +1,317 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     TermiosLink.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  TermiosTransport::TermiosTransport(int fd);
+--                  DWORD TermiosTransport::read(uint8_t *dst, DWORD size, DWORD msec);
+--                  BOOL TermiosTransport::write(const uint8_t *src, DWORD size);
+--                  BOOL TermiosTransport::waitForInput();
+--                  VOID TermiosTransport::wake();
+--                  VOID TermiosTransport::purge();
+--                  BOOL TermiosTransport::isOpen();
+--                  BOOL TermiosTransport::configure(const char *settings);
+--                  VOID TermiosTransport::close();
+--                  TermiosTransport *openTermios(const char *path);
+--                  BOOL openPtyPair(int *master, int *slave);
+--                  int ptyFork();
+--                  int ptyJoin(int peer);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The serial port on Linux, without the Win32 calls Platform.cpp emulates. The port is a raw,
+-- nonblocking termios fd, and every wait is an epoll_wait() on it:
+--
+-- - read() takes whatever is buffered in one call, and sleeps on the port only when there is nothing.
+-- - write() sleeps on the port only while the driver's buffer is full.
+-- - waitForInput() sleeps on the port and on an eventfd. wake() bumps the eventfd, so a wake from
+--   before the wait ends it at once.
+--
+-- The end of a pty pair is a tty like any other, so ptyFork() runs two stations on one machine
+-- through this same code. The pty has no line rate, and bytes cross it at once.
+--
+-- Linux only, like the headless driver that uses it.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "TermiosLink.h"
+#include "Common.h"
+#include "LinkSession.h"
+#include "LinkPool.h"
+#ifndef _WIN32
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+using namespace std;
+
+// this station's end of the pty pair
+static TermiosTransport *ptyLink;
+
+// adds fd to an epoll set
+static VOID watch(int set, int fd, uint32_t events)
+{
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    epoll_ctl(set, EPOLL_CTL_ADD, fd, &ev);
+}
+
+// sleeps until something in the set is ready, -1 waits forever; returns the fd that is, or -1.
+// first goes first when more than one is ready. The set is readable while anything in it is ready,
+// which lets a pool's worker wait on it along with the other links
+static int ready(int set, int msec, int first = -1)
+{
+    struct epoll_event ev[2];
+    struct pollfd p = { set, POLLIN, 0 };
+    int n;
+    while ((n = poolPoll(&p, 1, msec)) < 0 && errno == EINTR)
+        ;
+    if (n <= 0 || (n = epoll_wait(set, ev, 2, 0)) <= 0)
+        return -1;
+
+    for (int i = 0; i < n; i++)
+        if (ev[i].data.fd == first)
+            return first;
+    return ev[0].data.fd;
+}
+
+TermiosTransport::TermiosTransport(int fd)
+    : fd(fd), wakeFd(eventfd(0, EFD_NONBLOCK)), inSet(epoll_create1(0)), idleSet(epoll_create1(0)),
+      outSet(epoll_create1(0)), open(TRUE)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    // raw 8 bit bytes, no echo and no line editing; the line rate is left as it is. VMIN 0 would
+    // make an empty read return 0, not EAGAIN, and look like a hang up
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    watch(inSet, fd, EPOLLIN);
+    watch(idleSet, fd, EPOLLIN);
+    watch(idleSet, wakeFd, EPOLLIN);
+    watch(outSet, fd, EPOLLOUT);
+}
+
+TermiosTransport::~TermiosTransport()
+{
+    close();
+    ::close(wakeFd);
+    ::close(inSet);
+    ::close(idleSet);
+    ::close(outSet);
+}
+
+VOID TermiosTransport::hangUp()
+{
+    // a port that hung up is always readable, only wake() may end a wait from now on
+    if (open)
+        epoll_ctl(idleSet, EPOLL_CTL_DEL, fd, NULL);
+    open = FALSE;
+}
+
+DWORD TermiosTransport::read(uint8_t *dst, DWORD size, DWORD msec)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(msec);
+
+    for (;;)
+    {
+        session->readMetrics.readCalls++;
+        ssize_t n = ::read(fd, dst, size);
+        if (n > 0)
+            return (DWORD) n;
+
+        // the other end of a pty hangs up with EIO, a tty that goes away with 0
+        if (n == 0 || errno == EIO)
+        {
+            hangUp();
+            return 0;
+        }
+        if (errno != EAGAIN && errno != EINTR)
+            return 0;
+
+        auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (left <= 0 || ready(inSet, (int) left) < 0)
+            return 0;
+    }
+}
+
+BOOL TermiosTransport::write(const uint8_t *src, DWORD size)
+{
+    DWORD total = 0;
+
+    while (total < size)
+    {
+        ssize_t n = ::write(fd, src + total, size - total);
+        if (n > 0)
+            total += (DWORD) n;
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else if (n < 0 && errno == EAGAIN)
+            ready(outSet, -1);
+        else
+        {
+            if (n < 0 && errno == EIO)
+                hangUp();
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL TermiosTransport::waitForInput()
+{
+    // a wake and input at once, the wake goes first and the input stays for the next wait
+    if (ready(idleSet, -1, wakeFd) != wakeFd)
+        return TRUE;
+
+    uint64_t count;
+    if (::read(wakeFd, &count, sizeof(count)) < 0)
+        OutputDebugString("TermiosTransport::waitForInput could not clear the wake\n");
+    return FALSE;
+}
+
+VOID TermiosTransport::wake()
+{
+    uint64_t one = 1;
+    if (::write(wakeFd, &one, sizeof(one)) < 0)
+        OutputDebugString("TermiosTransport::wake failed\n");
+}
+
+VOID TermiosTransport::purge()
+{
+    // only what came in, bytes of ours still on the way to the peer stay; read what is buffered
+    // where the flush does not work
+    if (tcflush(fd, TCIFLUSH) != 0)
+    {
+        uint8_t drop[256];
+        while (::read(fd, drop, sizeof(drop)) > 0)
+            ;
+    }
+}
+
+BOOL TermiosTransport::isOpen()
+{
+    return open;
+}
+
+BOOL TermiosTransport::configure(const char *settings)
+{
+    const struct { DWORD baud; speed_t speed; } speeds[] = {
+        { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 }, { 19200, B19200 },
+        { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 }
+    };
+    DCB dcb = {};
+    struct termios tio;
+    if (!BuildCommDCB(settings, &dcb) || tcgetattr(fd, &tio) != 0)
+        return FALSE;
+
+    speed_t speed = B0;
+    for (const auto &s : speeds)
+        if (s.baud == dcb.BaudRate)
+            speed = s.speed;
+    if (speed == B0)
+        return FALSE;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+    tio.c_cflag |= dcb.ByteSize == 5 ? CS5 : dcb.ByteSize == 6 ? CS6 : dcb.ByteSize == 7 ? CS7 : CS8;
+    if (dcb.Parity == ODDPARITY)
+        tio.c_cflag |= PARENB | PARODD;
+    else if (dcb.Parity == EVENPARITY)
+        tio.c_cflag |= PARENB;
+    if (dcb.StopBits == TWOSTOPBITS)
+        tio.c_cflag |= CSTOPB;
+
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+VOID TermiosTransport::close()
+{
+    if (fd < 0)
+        return;
+
+    hangUp();
+    ::close(fd);
+    fd = -1;
+}
+
+TermiosTransport *openTermios(const char *path)
+{
+    int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+        return NULL;
+    return new TermiosTransport(fd);
+}
+
+BOOL openPtyPair(int *master, int *slave)
+{
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    *slave = -1;
+    if (*master < 0)
+        return FALSE;
+
+    const char *name;
+    if (grantpt(*master) != 0 || unlockpt(*master) != 0 || !(name = ptsname(*master)) ||
+        (*slave = ::open(name, O_RDWR | O_NOCTTY)) < 0)
+    {
+        ::close(*master);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+int ptyFork()
+{
+    int master, slave;
+    if (!openPtyPair(&master, &slave))
+        return -1;
+
+    // nothing buffered may be written out twice
+    fflush(stdout);
+    fflush(stderr);
+
+    int pid = fork();
+    if (pid < 0)
+    {
+        ::close(master);
+        ::close(slave);
+        return -1;
+    }
+
+    // the parent keeps the master side, the forked peer the slave
+    ::close(pid == 0 ? master : slave);
+    ptyLink = new TermiosTransport(pid == 0 ? slave : master);
+    session->transport = ptyLink;
+    return pid;
+}
+
+int ptyJoin(int peer)
+{
+    // everything sent was acknowledged, the peer can see the line go away now
+    ptyLink->close();
+
+    int status;
+    if (waitpid(peer, &status, 0) != peer || !WIFEXITED(status))
+        return 1;
+    return WEXITSTATUS(status);
+}
+#endif
@@ -0,0 +1,57 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     TermiosLink.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the class declaration for the POSIX serial port transport, a termios fd
+-- driven by epoll, and the function declarations for running two stations over a pty pair with it.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef TERMIOS_LINK_H
+#define TERMIOS_LINK_H
+#include "Transport.h"
+
+// --port value that runs both stations over a pty pair instead of a serial port
+#define PTY_PORT            "pty"
+
+#ifndef _WIN32
+class TermiosTransport : public Transport {
+public:
+    // takes over fd, a tty or the end of a pty pair
+    explicit TermiosTransport(int fd);
+    ~TermiosTransport();
+
+    DWORD       read(uint8_t *dst, DWORD size, DWORD msec);
+    BOOL        write(const uint8_t *src, DWORD size);
+    BOOL        waitForInput();
+    VOID        wake();
+    VOID        purge();
+    BOOL        isOpen();
+
+    // line settings as "9600,n,8,1", the form BuildCommDCB() takes
+    BOOL        configure(const char *settings);
+    // hangs up, the other end of a pty sees the line go away
+    VOID        close();
+
+private:
+    VOID        hangUp();
+
+    int         fd;
+    int         wakeFd;         // eventfd, keeps a wake() until the wait it ends
+    int         inSet;          // epoll sets: the port readable,
+    int         idleSet;        // the port readable or a wake(),
+    int         outSet;         // and the port writable
+    BOOL        open;
+};
+
+// function prototypes
+TermiosTransport *openTermios(const char *path);
+BOOL openPtyPair(int *master, int *slave);
+int ptyFork();
+int ptyJoin(int peer);
+#endif
+#endif
@@ -0,0 +1,301 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Trace.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  VOID traceEvent(uint16_t event, uint8_t seq, uint32_t a, uint32_t b);
+--                  BOOL traceOpen(const char *path, const char *port, BOOL append);
+--                  BOOL traceDump();
+--                  const char *traceEventName(uint16_t event);
+--                  BOOL decodeTrace(const char *path, std::string &csv);
+--                  static uint64_t traceClock();
+--                  static VOID traceHeader(const TRACE_RING &ring, TRACE_HEADER *header, size_t *first, size_t *tail);
+--                  static BOOL writeAll(int fd, const void *data, size_t size);
+--                  static VOID traceSignal(int sig);
+--                  static LONG WINAPI traceException(EXCEPTION_POINTERS *info);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The engine's debug strings cost a formatted write to the debugger or stderr for every frame, more
+-- than the frame itself on a fast line. The trace keeps a 16 byte record per event instead, in a ring
+-- of TRACE_RECORDS that is never resized or locked. Every link has a ring of its own in its session,
+-- and only the thread running the link records in it, so a record is a read of the time stamp
+-- counter and a few plain stores; the oldest one is overwritten once the ring is full. The clock is
+-- not converted when recording: a dump carries the rate of the counter, measured against the steady
+-- clock from traceOpen() on, and the decoder turns ticks into us.
+--
+-- A ring only leaves memory in a dump: a TRACE_HEADER, then the records oldest first, appended to
+-- the file given to traceOpen(), for every link traceOpen() named. A dump is taken when the driver
+-- asks for one, on SIGUSR1 on Linux, and when the program dies of a fault. The dump only uses calls
+-- that are safe in a signal handler and in an unhandled exception filter. A record being written
+-- while a ring is dumped may come out torn; the decoder prints it as it finds it.
+--
+-- decodeTrace() turns a dump file, every dump in it, into CSV with the time unwrapped to 64 bits.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Trace.h"
+#include "LinkSession.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifndef _WIN32
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+std::atomic<BOOL> traceEnabled(FALSE);
+
+// the rings that go in a dump, set before their count is raised so a signal handler can read them
+static TRACE_RING *traceRings[TRACE_LINKS];
+static atomic<int> traceLinks(0);
+// the clock and the steady clock in us when the trace started
+static uint64_t traceStart;
+static uint64_t traceStartUs;
+// where dumps go, fixed so a signal handler can read it
+static char tracePath[TRACE_PATH_LEN];
+
+static const char *traceNames[TRACE_EVENTS] = {
+    "state", "enq_sent", "line_acked", "bid_failed", "frame_sent", "sack_received", "sack_timeout",
+    "enq_received", "wait_timeout", "frame_received", "frame_corrupt", "no_frame", "sack_sent",
+    "write", "bad_block", "transfer_start", "transfer_end", "bid_collided", "backoff",
+    "setup_sent"
+};
+
+static uint64_t traceClock()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    // no cycle counter, fall back to nanoseconds
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+VOID traceEvent(uint16_t event, uint8_t seq, uint32_t a, uint32_t b)
+{
+    // one writer per ring, a plain store is enough and avoids a locked add
+    TRACE_RING &ring = session->trace;
+    uint64_t next = ring.next.load(memory_order_relaxed);
+    TRACE_RECORD &r = ring.records[next & (TRACE_RECORDS - 1)];
+    r.time = (uint32_t) ((traceClock() - traceStart) >> TRACE_TICK_SHIFT);
+    r.event = event;
+    r.seq = seq;
+    r.state = session->engineState;
+    r.a = a;
+    r.b = b;
+    ring.next.store(next + 1, memory_order_release);
+}
+
+#ifndef _WIN32
+static BOOL writeAll(int fd, const void *data, size_t size)
+{
+    const char *p = (const char *) data;
+    while (size > 0)
+    {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        size -= (size_t) n;
+    }
+    return TRUE;
+}
+
+static VOID traceSignal(int sig)
+{
+    int saved = errno;
+    traceDump();
+    errno = saved;
+
+    // a fault goes on to kill the process, the handler was reset when it ran
+    if (sig != SIGUSR1)
+        raise(sig);
+}
+#else
+static LONG WINAPI traceException(EXCEPTION_POINTERS *)
+{
+    traceDump();
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+BOOL traceOpen(const char *path, const char *port, BOOL append)
+{
+    TRACE_RING &ring = session->trace;
+    if (strlen(path) >= sizeof(tracePath))
+        return FALSE;
+    strcpy(tracePath, path);
+    strncpy(ring.port, port, sizeof(ring.port) - 1);
+
+    // the calling thread's link goes in the dumps from now on, once
+    static mutex adding;
+    {
+        lock_guard<mutex> guard(adding);
+        int links = traceLinks.load(memory_order_relaxed);
+        if (find(traceRings, traceRings + links, &ring) == traceRings + links)
+        {
+            if (links == TRACE_LINKS)
+                return FALSE;
+            traceRings[links] = &ring;
+            traceLinks.store(links + 1, memory_order_release);
+        }
+    }
+
+#ifndef _WIN32
+    int fd = ::open(tracePath, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd < 0)
+        return FALSE;
+    ::close(fd);
+
+    // a fault dumps what led up to it, SIGUSR1 dumps the ring while the link runs
+    struct sigaction fault = {}, demand = {};
+    fault.sa_handler = traceSignal;
+    fault.sa_flags = SA_RESETHAND;
+    for (int sig : { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT })
+        sigaction(sig, &fault, NULL);
+    demand.sa_handler = traceSignal;
+    demand.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &demand, NULL);
+#else
+    HANDLE file = CreateFile(tracePath, GENERIC_WRITE, FILE_SHARE_READ, NULL,
+        append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return FALSE;
+    CloseHandle(file);
+
+    SetUnhandledExceptionFilter(traceException);
+#endif
+
+    if (!traceEnabled)
+    {
+        traceStartUs = latencyClock();
+        traceStart = traceClock();
+        traceEnabled = TRUE;
+    }
+    return TRUE;
+}
+
+static VOID traceHeader(const TRACE_RING &ring, TRACE_HEADER *header, size_t *first, size_t *tail)
+{
+    // records made while this dump is written go in the next one
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+    memcpy(header->port, ring.port, sizeof(header->port));
+    header->recordSize = sizeof(TRACE_RECORD);
+    header->written = ring.next.load(memory_order_acquire);
+    header->count = (uint32_t) min<uint64_t>(header->written, TRACE_RECORDS);
+    uint64_t us = latencyClock() - traceStartUs;
+    header->tickHz = us ? (uint64_t) ((double) (traceClock() - traceStart) * 1e6 / us) : 0;
+    header->tickShift = TRACE_TICK_SHIFT;
+
+    // oldest first, the ring wraps at most once in between
+    *first = (size_t) ((header->written - header->count) & (TRACE_RECORDS - 1));
+    *tail = min<size_t>(header->count, TRACE_RECORDS - *first);
+}
+
+BOOL traceDump()
+{
+    if (!tracePath[0])
+        return FALSE;
+
+    TRACE_HEADER header;
+    size_t first, tail;
+    int links = traceLinks.load(memory_order_acquire);
+    BOOL ok = TRUE;
+
+#ifndef _WIN32
+    int fd = ::open(tracePath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+        return FALSE;
+    for (int i = 0; ok && i < links; i++)
+    {
+        const TRACE_RING &ring = *traceRings[i];
+        traceHeader(ring, &header, &first, &tail);
+        ok = writeAll(fd, &header, sizeof(header)) &&
+            writeAll(fd, &ring.records[first], tail * sizeof(TRACE_RECORD)) &&
+            writeAll(fd, &ring.records[0], (header.count - tail) * sizeof(TRACE_RECORD));
+    }
+    ::close(fd);
+#else
+    DWORD written;
+    HANDLE file = CreateFile(tracePath, FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return FALSE;
+    for (int i = 0; ok && i < links; i++)
+    {
+        const TRACE_RING &ring = *traceRings[i];
+        traceHeader(ring, &header, &first, &tail);
+        ok = WriteFile(file, &header, sizeof(header), &written, NULL) &&
+            WriteFile(file, &ring.records[first], (DWORD) (tail * sizeof(TRACE_RECORD)), &written, NULL) &&
+            WriteFile(file, &ring.records[0], (DWORD) ((header.count - tail) * sizeof(TRACE_RECORD)), &written,
+                NULL);
+    }
+    CloseHandle(file);
+#endif
+
+    return ok;
+}
+
+const char *traceEventName(uint16_t event)
+{
+    return event < TRACE_EVENTS ? traceNames[event] : "unknown";
+}
+
+BOOL decodeTrace(const char *path, string &csv)
+{
+    ifstream in(path, ios::binary);
+    if (!in)
+        return FALSE;
+
+    TRACE_HEADER header;
+    TRACE_RECORD r;
+    char line[160];
+    csv = "port,us,event,state,seq,a,b\n";
+
+    // one dump after another, each with its own clock
+    while (in.read((char *) &header, sizeof(header)))
+    {
+        if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.recordSize != sizeof(r))
+            return FALSE;
+
+        string port(header.port, strnlen(header.port, sizeof(header.port)));
+        // a dump taken at once has no rate yet, its times stay in ticks
+        double usPerTime = header.tickHz ? (double) (1ULL << header.tickShift) * 1e6 / header.tickHz : 1.0;
+        uint64_t wraps = 0;
+        uint32_t last = 0;
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            if (!in.read((char *) &r, sizeof(r)))
+                return FALSE;
+
+            // a torn record may step back a little, only a big step back is the clock wrapping
+            if (r.time < last && last - r.time > 0x80000000u)
+                wraps++;
+            last = r.time;
+
+            snprintf(line, sizeof(line), "%s,%llu,%s,%s,%u,%lu,%lu\n", port.c_str(),
+                (unsigned long long) (((wraps << 32) + r.time) * usPerTime), traceEventName(r.event),
+                r.state < ENGINE_STATES ? latencyNames[r.state] : "unknown", (unsigned) r.seq,
+                (unsigned long) r.a, (unsigned long) r.b);
+            csv += line;
+        }
+    }
+
+    return in.eof();
+}
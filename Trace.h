@@ -0,0 +1,109 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Trace.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the event IDs, record layout, ring and function declarations for the
+-- binary trace of the engine, and the TRACE() macro the engine records events with. Building with
+-- NO_TRACE defined compiles every TRACE() out, otherwise one costs a load and a branch until
+-- traceOpen() turns recording on.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef TRACE_H
+#define TRACE_H
+#include "Platform.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Records kept per link, the oldest are overwritten; a power of two
+#define TRACE_RECORDS           65536
+// Links a dump can hold
+#define TRACE_LINKS             64
+// Start of a dump file, and of every dump appended to one
+#define TRACE_MAGIC             "RMTRACE1"
+#define TRACE_PORT_LEN          16
+#define TRACE_PATH_LEN          260
+// a record keeps the time stamp counter shifted right by this, 1/3 us and 24 minutes to a wrap at
+// 3 GHz
+#define TRACE_TICK_SHIFT        10
+
+// trace events: what a and b of the record hold
+#define TRACE_STATE             0   // engine state entered, a: state left
+#define TRACE_ENQ_SENT          1   // line bid, a: try
+#define TRACE_LINE_ACKED        2   // the peer answered the bid, a: ms
+#define TRACE_BID_FAILED        3   // no answer to any try, a: tries, b: bids that failed before in a row
+#define TRACE_FRAME_SENT        4   // seq, a: frame bytes, b: payload bytes
+#define TRACE_SACK_RECEIVED     5   // seq: base, a: mask, b: frames acknowledged
+#define TRACE_SACK_TIMEOUT      6   // a: frames in the burst, b: ms waited
+#define TRACE_ENQ_RECEIVED      7   // the peer bid for the line
+#define TRACE_WAIT_TIMEOUT      8   // no bid from the peer after our burst or a backoff, a: ms waited
+#define TRACE_FRAME_RECEIVED    9   // seq, a: payload bytes, b: ARQ result
+#define TRACE_FRAME_CORRUPT     10  // a frame failed its CRC, seq as it came in, a: frame bytes
+#define TRACE_NO_FRAME          11  // nothing came after our ACK, a: ms waited
+#define TRACE_SACK_SENT         12  // seq: base, a: mask, b: TRUE for a NAK
+#define TRACE_WRITE             13  // a: bytes, b: TRUE when the write went through
+#define TRACE_BAD_BLOCK         14  // a payload that did not decompress, a: its bytes
+#define TRACE_TRANSFER_START    15  // seq: first, a: bytes to send, 0 for text
+#define TRACE_TRANSFER_END      16  // seq: next, a: frames sent, b: frames given up on
+#define TRACE_BID_COLLIDED      17  // an ENQ or another non-ACK answered ours, a: ms, b: bids failed before
+#define TRACE_BACKOFF           18  // wait after a failed bid, a: ms drawn, b: how the bid failed
+#define TRACE_SETUP_SENT        19  // link setup offered, seq: our next number, a: TRUE when it resyncs
+#define TRACE_EVENTS            20
+
+// One event, 16 bytes
+struct TRACE_RECORD {
+    uint32_t    time;           // ticks >> TRACE_TICK_SHIFT since the trace started
+    uint16_t    event;
+    uint8_t     seq;
+    uint8_t     state;          // engine state when it happened
+    uint32_t    a;
+    uint32_t    b;
+};
+
+// In front of the records of a dump
+struct TRACE_HEADER {
+    char        magic[8];
+    char        port[TRACE_PORT_LEN];   // the station the dump came from
+    uint32_t    recordSize;
+    uint32_t    count;                  // records that follow, oldest first
+    uint64_t    written;                // records ever made, the first written - count were overwritten
+    uint64_t    tickHz;                 // ticks per second, measured over the life of the trace
+    uint32_t    tickShift;
+    uint32_t    reserved;
+};
+
+// The records of one link, the oldest overwritten once it is full. Only the links traceOpen() named
+// go in the dumps.
+struct TRACE_RING {
+    TRACE_RECORD            records[TRACE_RECORDS];
+    // records ever made
+    std::atomic<uint64_t>   next;
+    char                    port[TRACE_PORT_LEN];
+
+    // the records are left as they are, a ring costs no memory until it is used
+    TRACE_RING() : next(0) { port[0] = '\0'; }
+};
+
+// set by traceOpen(), nothing is recorded before
+extern std::atomic<BOOL> traceEnabled;
+
+#ifdef NO_TRACE
+#define TRACE(event, seq, a, b)     ((void) 0)
+#else
+#define TRACE(event, seq, a, b)     do { if (traceEnabled.load(std::memory_order_relaxed)) \
+                                        traceEvent((event), (uint8_t) (seq), (uint32_t) (a), (uint32_t) (b)); \
+                                    } while (0)
+#endif
+
+// function prototypes
+VOID traceEvent(uint16_t event, uint8_t seq, uint32_t a, uint32_t b);
+BOOL traceOpen(const char *path, const char *port, BOOL append);
+BOOL traceDump();
+const char *traceEventName(uint16_t event);
+BOOL decodeTrace(const char *path, std::string &csv);
+#endif
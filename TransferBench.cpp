@@ -0,0 +1,364 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     TransferBench.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  int runSuite(const HEADLESS_OPTIONS &options);
+--                  std::vector<SUITE_POINT> suiteMatrix(const HEADLESS_OPTIONS &options);
+--                  BOOL runPoint(const HEADLESS_OPTIONS &options, const SUITE_POINT &point, SUITE_RESULT *result);
+--                  std::string formatResult(const HEADLESS_OPTIONS &options, const SUITE_RESULT &result,
+--                                           BOOL header);
+--                  int compareBaseline(const HEADLESS_OPTIONS &options, const std::vector<SUITE_RESULT> &results);
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- End-to-end transfer benchmark for the headless driver. Every point of the BER x payload x latency
+-- matrix sends the same file over a fresh simulated link and reports, from the sender's side:
+--
+-- - goodput, in file bytes per second;
+-- - line utilization, the time either station had bytes on the line over the transfer time;
+-- - the retransmission ratio;
+-- - p50 and p99 of the time from a frame's first transmission to its acknowledgement.
+--
+-- The engine keeps its state in globals, so each point runs in a forked worker. The worker forks
+-- the peer station in turn, and hands its result back over a pipe. A point is only as repeatable
+-- as the sim seed and the thread timing.
+--
+-- With --baseline, the results are checked against the CSV of an earlier run. The suite fails when
+-- a point that got through before does not, when goodput drops by more than the tolerance, or when
+-- p99 latency grows by more than the tolerance.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "TransferBench.h"
+#include "LinkSession.h"
+#ifndef _WIN32
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+using namespace std;
+
+// generated when nothing is given to send
+static const char *suiteFile = "rmsuite.tmp";
+
+int runSuite(const HEADLESS_OPTIONS &options)
+{
+    vector<SUITE_POINT> matrix = suiteMatrix(options);
+    if (matrix.empty())
+    {
+        fprintf(stderr, "empty benchmark matrix\n");
+        return 2;
+    }
+
+    HEADLESS_OPTIONS run = options;
+    if (run.sendFiles.empty())
+    {
+        // words of random letters, so the compressor has some but not all of its usual work
+        ofstream out(suiteFile, ios::binary | ios::trunc);
+        uint32_t state = 1;
+        for (DWORD i = 0; i < options.suiteBytes; i++)
+        {
+            state = state * 1103515245 + 12345;
+            DWORD r = (state >> 16) % 32;
+            out.put(r < 26 ? (char) ('a' + r) : r < 31 ? ' ' : '\n');
+        }
+        if (!out)
+        {
+            fprintf(stderr, "cannot write %s\n", suiteFile);
+            return 1;
+        }
+        run.sendFiles.push_back(suiteFile);
+    }
+
+    vector<SUITE_RESULT> results;
+    for (const SUITE_POINT &point : matrix)
+    {
+        SUITE_RESULT result;
+        if (!runPoint(run, point, &result))
+        {
+            fprintf(stderr, "benchmark worker failed at ber=%g payload=%lu latency=%lu\n", point.ber,
+                (unsigned long) point.payload, (unsigned long) point.latency);
+            result.point = point;
+            result.elapsed = 0;
+            result.goodput = result.utilization = result.retransmit = 0;
+            result.frameP50 = result.frameP99 = 0;
+            result.lost = 0;
+            result.berEstimate = 0;
+            result.payloadEnd = 0;
+            result.ok = FALSE;
+        }
+
+        // a line per point as it finishes, a full matrix takes minutes
+        fputs(formatResult(options, result, results.empty()).c_str(), stdout);
+        fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (options.sendFiles.empty())
+        remove(suiteFile);
+
+    int code = 0;
+    for (const SUITE_RESULT &result : results)
+        if (!result.ok)
+            code = 1;
+    if (!options.baseline.empty())
+        code = max<int>(code, compareBaseline(options, results));
+    return code;
+}
+
+vector<SUITE_POINT> suiteMatrix(const HEADLESS_OPTIONS &options)
+{
+    auto split = [](const string &list) {
+        vector<string> items;
+        stringstream in(list);
+        string item;
+        while (getline(in, item, ','))
+            if (!item.empty())
+                items.push_back(item);
+        return items;
+    };
+
+    vector<SUITE_POINT> matrix;
+    for (const string &ber : split(options.bers))
+        for (const string &payload : split(options.payloads))
+            for (const string &latency : split(options.latencies))
+            {
+                SUITE_POINT point;
+                point.ber = atof(ber.c_str());
+                // same range as --payload
+                point.payload = (DWORD) max<long>(PAYLOAD_UNIT, min<long>(PACKET_DATA_MAX, atol(payload.c_str())));
+                point.latency = (DWORD) atol(latency.c_str());
+                matrix.push_back(point);
+            }
+
+    return matrix;
+}
+
+BOOL runPoint(const HEADLESS_OPTIONS &options, const SUITE_POINT &point, SUITE_RESULT *result)
+{
+    // the point's settings go after the base spec, later keys win
+    char spec[96];
+    snprintf(spec, sizeof(spec), ",ber=%g,latency=%lu", point.ber, (unsigned long) point.latency);
+    string sim = (options.sim.empty() ? string(SUITE_SIM) : options.sim) + spec;
+
+    SIM_PARAMS params;
+    if (!parseSimSpec(sim.c_str(), &params))
+        return FALSE;
+
+    int fds[2];
+    if (pipe(fds) != 0)
+        return FALSE;
+    fflush(stdout);
+    fflush(stderr);
+
+    int worker = fork();
+    if (worker < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return FALSE;
+    }
+
+    DWORD limit = options.timeout ? options.timeout : SUITE_TIMEOUT;
+    if (worker == 0)
+    {
+        // the peer lands in the worker's group, both go if the point runs over
+        setpgid(0, 0);
+        close(fds[0]);
+        HEADLESS_OPTIONS run = options;
+        run.suite = FALSE;
+        run.sim = sim;
+        run.receive = FALSE;
+        run.recvFile.clear();
+        run.timeout = limit;
+        session->localParams.maxPayload = (WORD) point.payload;
+
+        TRANSFER_RESULT transfer;
+        int code = runTransfer(run, &transfer);
+        // the peer station is done once it has received everything
+        if (transfer.peer)
+            exit(code);
+
+        SUITE_RESULT measured;
+        measured.point = point;
+        measured.elapsed = transfer.elapsed;
+        measured.goodput = transfer.elapsed ? transfer.bytesSent * 1000.0 / transfer.elapsed : 0;
+        measured.retransmit = retransmissionRatio();
+        measured.frameP50 = (DWORD) session->sendMetrics.frameLatency.percentile(0.50);
+        measured.frameP99 = (DWORD) session->sendMetrics.frameLatency.percentile(0.99);
+        measured.lost = session->stats.snapshot().packetLost;
+        measured.berEstimate = session->linkQuality.ber();
+        measured.payloadEnd = session->linkParams.adaptive ? session->txPayload : session->linkParams.maxPayload;
+        measured.ok = code == 0;
+        measured.utilization = 0;
+
+        // this station's own bytes plus everything it heard from the peer
+        SIM_STATS line;
+        if (simStats(&line) && transfer.elapsed && params.baud)
+        {
+            double byteTime = SIM_BITS_PER_BYTE * 1000.0 / params.baud;
+            measured.utilization = (line.lineBusyMs + line.bytesHeard * byteTime) / transfer.elapsed;
+        }
+
+        BOOL sent = write(fds[1], &measured, sizeof(measured)) == (ssize_t) sizeof(measured);
+        exit(sent ? 0 : 1);
+    }
+
+    setpgid(worker, worker);
+    close(fds[1]);
+    size_t got = 0;
+    DWORD start = GetTickCount();
+    while (got < sizeof(*result))
+    {
+        struct pollfd ready = { fds[0], POLLIN, 0 };
+        DWORD spent = GetTickCount() - start;
+        if (spent >= limit || poll(&ready, 1, (int) (limit - spent)) <= 0)
+        {
+            fprintf(stderr, "point ran over %lu ms, stopped\n", (unsigned long) limit);
+            kill(-worker, SIGKILL);
+            break;
+        }
+
+        ssize_t n = read(fds[0], (char *) result + got, sizeof(*result) - got);
+        if (n <= 0)
+            break;
+        got += n;
+    }
+    close(fds[0]);
+
+    int status;
+    waitpid(worker, &status, 0);
+    return got == sizeof(*result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+string formatResult(const HEADLESS_OPTIONS &options, const SUITE_RESULT &result, BOOL header)
+{
+    char ber[32];
+    snprintf(ber, sizeof(ber), "%g", result.point.ber);
+
+    vector<pair<string, string>> fields;
+    auto add = [&fields](const char *name, double value) {
+        ostringstream text;
+        text.precision(6);
+        text << value;
+        fields.push_back(make_pair(string(name), text.str()));
+    };
+    fields.push_back(make_pair(string("ber"), string(ber)));
+    add("payload", result.point.payload);
+    add("latencyMs", result.point.latency);
+    add("elapsedMs", result.elapsed);
+    add("goodputBps", floor(result.goodput));
+    add("lineUtilization", result.utilization);
+    add("retransmissionRatio", result.retransmit);
+    add("frameP50Ms", result.frameP50);
+    add("frameP99Ms", result.frameP99);
+    add("packetLost", result.lost);
+    add("berEstimate", result.berEstimate);
+    add("payloadEnd", result.payloadEnd);
+    add("ok", result.ok ? 1 : 0);
+
+    string out;
+    if (options.csv)
+    {
+        if (header)
+            for (size_t i = 0; i < fields.size(); i++)
+                out += fields[i].first + (i + 1 < fields.size() ? "," : "\n");
+        for (size_t i = 0; i < fields.size(); i++)
+            out += fields[i].second + (i + 1 < fields.size() ? "," : "\n");
+        return out;
+    }
+
+    // one object per point
+    out = "{";
+    for (size_t i = 0; i < fields.size(); i++)
+        out += "\"" + fields[i].first + "\":" + fields[i].second + (i + 1 < fields.size() ? "," : "}\n");
+    return out;
+}
+
+int compareBaseline(const HEADLESS_OPTIONS &options, const vector<SUITE_RESULT> &results)
+{
+    ifstream in(options.baseline.c_str());
+    string line;
+    if (!getline(in, line))
+    {
+        fprintf(stderr, "cannot read baseline %s\n", options.baseline.c_str());
+        return 1;
+    }
+
+    // columns by name, so a baseline with more or fewer of them still works
+    map<string, size_t> column;
+    {
+        stringstream header(line);
+        string name;
+        for (size_t i = 0; getline(header, name, ','); i++)
+            column[name] = i;
+    }
+    const char *needed[] = { "ber", "payload", "latencyMs", "goodputBps", "frameP99Ms", "ok" };
+    for (const char *name : needed)
+        if (!column.count(name))
+        {
+            fprintf(stderr, "baseline %s has no %s column, it must be --suite --csv output\n",
+                options.baseline.c_str(), name);
+            return 1;
+        }
+
+    map<string, vector<string>> rows;
+    while (getline(in, line))
+    {
+        vector<string> values;
+        stringstream row(line);
+        string value;
+        while (getline(row, value, ','))
+            values.push_back(value);
+        if (values.size() == column.size())
+            rows[values[column["ber"]] + "," + values[column["payload"]] + "," + values[column["latencyMs"]]] = values;
+    }
+
+    int regressions = 0;
+    for (const SUITE_RESULT &result : results)
+    {
+        char key[96];
+        snprintf(key, sizeof(key), "%g,%lu,%lu", result.point.ber, (unsigned long) result.point.payload,
+            (unsigned long) result.point.latency);
+        if (!rows.count(key))
+        {
+            fprintf(stderr, "%s: not in the baseline\n", key);
+            continue;
+        }
+
+        const vector<string> &base = rows[key];
+        double goodput = atof(base[column["goodputBps"]].c_str());
+        double p99 = atof(base[column["frameP99Ms"]].c_str());
+        BOOL ok = atoi(base[column["ok"]].c_str()) != 0;
+
+        if (ok && !result.ok)
+        {
+            fprintf(stderr, "%s: transfer failed, it got through in the baseline\n", key);
+            regressions++;
+        }
+        else if (result.goodput < goodput * (1 - options.tolerance))
+        {
+            fprintf(stderr, "%s: goodput %.0f B/s, baseline %.0f B/s\n", key, result.goodput, goodput);
+            regressions++;
+        }
+        else if (result.frameP99 > p99 * (1 + options.tolerance) + SUITE_LATENCY_SLACK)
+        {
+            fprintf(stderr, "%s: p99 frame latency %lu ms, baseline %.0f ms\n", key,
+                (unsigned long) result.frameP99, p99);
+            regressions++;
+        }
+    }
+
+    return regressions ? 1 : 0;
+}
+#endif
@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     TransferBench.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the defaults and function declarations for the end-to-end transfer
+-- benchmark, which runs whole transfers over the simulated link across a matrix of channel and frame
+-- settings.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef TRANSFER_BENCH_H
+#define TRANSFER_BENCH_H
+#include "Headless.h"
+
+// default matrix, each axis a comma-separated list
+#define SUITE_BERS          "0,1e-5,1e-4"
+#define SUITE_PAYLOADS      "256,1024,4096"
+#define SUITE_LATENCIES     "0,50"
+// line the matrix points modify unless --sim gives another
+#define SUITE_SIM           "baud=115200,turnaround=2,seed=1"
+// generated file sent at every point
+#define SUITE_BYTES         65536
+// a point still running after this long has failed, unless --timeout gives another limit
+#define SUITE_TIMEOUT       180000
+// a result this much worse than its baseline is a regression
+#define SUITE_TOLERANCE     0.10
+// p99 latency has to grow by at least this many ms as well, a few frames move it by a tick or two
+#define SUITE_LATENCY_SLACK 20
+
+// One point of the matrix
+struct SUITE_POINT {
+    double      ber;
+    DWORD       payload;
+    DWORD       latency;
+};
+
+// What a transfer at one point measured, as seen by the sending station
+struct SUITE_RESULT {
+    SUITE_POINT point;
+    DWORD       elapsed;
+    double      goodput;        // file bytes per second
+    double      utilization;    // share of the time either station had bytes on the line
+    double      retransmit;     // resent frames over all frames sent
+    DWORD       frameP50;       // ms from first transmission to acknowledgement
+    DWORD       frameP99;
+    DWORD       lost;
+    double      berEstimate;    // the sender's view of the channel, to hold against the point's BER
+    DWORD       payloadEnd;     // frame size the sender ended up with
+    BOOL        ok;
+};
+
+// function prototypes
+int runSuite(const HEADLESS_OPTIONS &options);
+std::vector<SUITE_POINT> suiteMatrix(const HEADLESS_OPTIONS &options);
+BOOL runPoint(const HEADLESS_OPTIONS &options, const SUITE_POINT &point, SUITE_RESULT *result);
+std::string formatResult(const HEADLESS_OPTIONS &options, const SUITE_RESULT &result, BOOL header);
+int compareBaseline(const HEADLESS_OPTIONS &options, const std::vector<SUITE_RESULT> &results);
+#endif
@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE:     Transport.cpp
+--
+-- PROGRAM:         RMProtocol
+--
+-- Functions
+--                  CommTransport::CommTransport(HANDLE port);
+--                  DWORD CommTransport::read(uint8_t *dst, DWORD size, DWORD msec);
+--                  BOOL CommTransport::write(const uint8_t *src, DWORD size);
+--                  BOOL CommTransport::waitForInput();
+--                  VOID CommTransport::wake();
+--                  VOID CommTransport::purge();
+--                  BOOL CommTransport::isOpen();
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- The comm port behind the Transport interface. These are the overlapped reads, writes and comm
+-- events the engine used to do on hComm itself, moved here unchanged.
+----------------------------------------------------------------------------------------------------------------------*/
+#include "Transport.h"
+#include "Common.h"
+#include "LinkSession.h"
+using namespace std;
+
+CommTransport::CommTransport(HANDLE port)
+    : hPort(port), hReadEvent(CreateEvent(NULL, TRUE, FALSE, NULL)), woken(FALSE)
+{
+}
+
+CommTransport::~CommTransport()
+{
+    CloseHandle(hReadEvent);
+}
+
+DWORD CommTransport::read(uint8_t *dst, DWORD size, DWORD msec)
+{
+    DWORD bytes_read = 0;
+    DWORD start = GetTickCount();
+
+    do {
+        OVERLAPPED ovRead = {};
+        ovRead.hEvent = hReadEvent;
+        ResetEvent(hReadEvent);
+        session->readMetrics.readCalls++;
+
+        // with the port timeouts set in initPort(), a read returns as soon as anything is
+        // buffered and takes all of it, up to size
+        if (!ReadFile(hPort, dst, size, &bytes_read, &ovRead))
+        {
+            if (GetLastError() != ERROR_IO_PENDING)
+                return 0;
+
+            DWORD left = msec - min<DWORD>(msec, GetTickCount() - start);
+            if (WaitForSingleObject(hReadEvent, left) != WAIT_OBJECT_0)
+                CancelIo(hPort);
+            if (!GetOverlappedResult(hPort, &ovRead, &bytes_read, TRUE))
+                bytes_read = 0;
+        }
+    } while (bytes_read == 0 && GetTickCount() - start < msec);
+
+    return bytes_read;
+}
+
+BOOL CommTransport::write(const uint8_t *src, DWORD size)
+{
+    COMSTAT cs;
+    DWORD err, result, bytes_written = 0;
+    OVERLAPPED ovWrite = {};
+    ovWrite.hEvent = CreateEvent(NULL, FALSE, FALSE, EV_OVWRITE);
+
+    BOOL ok = WriteFile(hPort, src, size, &bytes_written, &ovWrite);
+    if (!ok && GetLastError() == ERROR_IO_PENDING)
+    {
+        if ((result = WaitForSingleObject(ovWrite.hEvent, INFINITE)) == WAIT_OBJECT_0)
+        {
+            // a write that went through is in the trace, see sendData()
+            if (!(ok = GetOverlappedResult(hPort, &ovWrite, &bytes_written, FALSE)))
+                OutputDebugString("Write Failed\n");
+        }
+        else
+            OutputDebugString("Error occured in Send()::WaitForSingleObject()\n");
+    }
+
+    CloseHandle(ovWrite.hEvent);
+    ClearCommError(hPort, &err, &cs);
+    return ok;
+}
+
+BOOL CommTransport::waitForInput()
+{
+    DWORD dwEvent = EV_RXCHAR, dwError;
+    COMSTAT cs;
+
+    //	Set listener to a character
+    errorCheck(!SetCommMask(hPort, EV_RXCHAR) ? ERR_COMMMASK : NO_ERR);
+    // a wake() after this point changes the mask again and ends the wait below
+    if (woken)
+    {
+        woken = FALSE;
+        return FALSE;
+    }
+    // Waits for EV_RXCHAR event to trigger; a failed wait is left to the read that follows
+    if (WaitCommEvent(hPort, &dwEvent, NULL))
+        ClearCommError(hPort, &dwError, &cs);
+
+    // no event at all means the mask was changed by wake()
+    if (dwEvent == 0)
+        woken = FALSE;
+    return dwEvent != 0;
+}
+
+VOID CommTransport::wake()
+{
+    woken = TRUE;
+    SetCommMask(hPort, RETURN_COMM_EVENT);
+}
+
+VOID CommTransport::purge()
+{
+    PurgeComm(hPort, PURGE_RXCLEAR | PURGE_TXCLEAR);
+}
+
+BOOL CommTransport::isOpen()
+{
+    return hPort != INVALID_HANDLE_VALUE;
+}
@@ -0,0 +1,58 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- HEADER FILE:     Transport.h
+--
+-- DATE:            October 17, 2026
+--
+-- DESIGNER:        Fred Yang
+--
+-- PROGRAMMER:      Fred Yang
+--
+-- NOTES:
+-- This header file includes the class declarations for the line the engine talks over. The engine
+-- only reads, writes, waits and purges through the current transport, so the comm port can be
+-- swapped for a simulated link without touching the state machine.
+----------------------------------------------------------------------------------------------------------------------*/
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+#include "Platform.h"
+#include <cstdint>
+
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    // reads what is there, waiting up to msec for the first byte; returns the bytes read
+    virtual DWORD   read(uint8_t *dst, DWORD size, DWORD msec) = 0;
+    // returns once the bytes are handed to the line
+    virtual BOOL    write(const uint8_t *src, DWORD size) = 0;
+    // blocks until input arrives; FALSE when wake() ended the wait
+    virtual BOOL    waitForInput() = 0;
+    // ends a waitForInput() in another thread, the next one if none is in progress
+    virtual VOID    wake() = 0;
+    // drops whatever is waiting to be read
+    virtual VOID    purge() = 0;
+    // FALSE once the other end is gone for good
+    virtual BOOL    isOpen() = 0;
+};
+
+// the comm port opened by initPort()
+class CommTransport : public Transport {
+public:
+    explicit CommTransport(HANDLE port);
+    ~CommTransport();
+
+    DWORD   read(uint8_t *dst, DWORD size, DWORD msec);
+    BOOL    write(const uint8_t *src, DWORD size);
+    BOOL    waitForInput();
+    VOID    wake();
+    VOID    purge();
+    BOOL    isOpen();
+
+private:
+    HANDLE  hPort;
+    // reused by every read
+    HANDLE  hReadEvent;
+    // wake() came before the wait it is meant to end
+    BOOL    woken;
+};
+#endif
@@ -7,6 +7,7 @@
 --                  VOID errorCheck(DWORD err);
 --                  VOID printMsg();
 --                  VOID configComm();
+--                  BOOL configLine(LPCSTR settings);
 --
 -- DATE:            December 3, 2016
 --
@@ -18,6 +19,7 @@
 -- This class wraps error check, comm config, and print methods.
 ----------------------------------------------------------------------------------------------------------------------*/
 #include "Utils.h"
+#include "LinkSession.h"
 
 VOID errorCheck(DWORD err)
 {
@@ -30,11 +32,8 @@ VOID errorCheck(DWORD err)
         case ERR_INIT_COMM:
             msg = "Failed to initialize serial port handle\n";
             break;
-        case ERR_READ_THREAD :
-            msg = "Failed to create read thread handle\n";
-            break;
-        case ERR_WRITE_THREAD :
-            msg = "Failed to create write thread handle\n";
+        case ERR_ENGINE_THREAD :
+            msg = "Failed to create engine thread handle\n";
             break;
         case ERR_RETRIEVE_COMM :
             msg = "Failed to retrieve communication configuration\n";
@@ -70,7 +69,17 @@ VOID configComm()
     COMMCONFIG cc;                   //Configuration state of the serial port
     cc.dwSize = sizeof(COMMCONFIG);  //Set the size of the structure to default
     cc.wVersion = 0x100;             //Set the version number 
-    errorCheck(!GetCommConfig(hComm, &cc, &cc.dwSize) ? ERR_RETRIEVE_COMM : NO_ERR);
+    errorCheck(!GetCommConfig(session->hComm, &cc, &cc.dwSize) ? ERR_RETRIEVE_COMM : NO_ERR);
     errorCheck(!CommConfigDialog(lpszCommName, hwnd, &cc) ? NO_ERR : NO_ERR);
-    errorCheck(!SetCommState(hComm, &cc.dcb) ? ERR_SET_COMM : NO_ERR);
-}
\ No newline at end of file
+    errorCheck(!SetCommState(session->hComm, &cc.dcb) ? ERR_SET_COMM : NO_ERR);
+}
+
+BOOL configLine(LPCSTR settings)
+{
+    // same settings as the dialog, given as "9600,n,8,1" instead
+    DCB dcb = {};
+    dcb.DCBlength = sizeof(DCB);
+    if (!GetCommState(session->hComm, &dcb) || !BuildCommDCB(settings, &dcb))
+        return FALSE;
+    return SetCommState(session->hComm, &dcb);
+}
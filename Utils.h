@@ -19,4 +19,5 @@
 VOID errorCheck(DWORD err);
 VOID printMsg();
 VOID configComm();
+BOOL configLine(LPCSTR settings);
 #endif
\ No newline at end of file